@@ -48,26 +48,43 @@ void Entity::Update(float time_delta) {
 }
 
 std::optional<WorldPos> Entity::GetMoveTarget() {
-  auto &path = GetPath();
-  if (path.empty()) {
+  if (m_FlowField) {
+    auto next_pos = m_FlowField->GetNextStep(GetPosition());
+    if (!next_pos || GetPosition().DistanceTo(next_pos.value()) <= 1.0) {
+      // target reached (or unreachable), stop following the field
+      m_FlowField.reset();
+      return {};
+    }
+    return next_pos;
+  }
+
+  if (m_Path.empty()) {
     return {};
   }
 
   WorldPos current_pos = GetPosition();
-  WorldPos next_pos = path.front();
+  WorldPos next_pos = m_Path.front();
 
   if (current_pos.DistanceTo(next_pos) > 1.0) {
     // target not reached yet
     return next_pos;
   }
-  // target reached, pop it
-  // m_MoveQueue.pop();
-  path.erase(path.begin());
+  // target reached, move on
+  m_Path.pop_front();
   // return nothing - if there's next point in the queue,
   // we'll get it in the next iteration
   return {};
 }
 
+std::optional<WorldPos> Entity::PopWaypoint() {
+  if (m_Waypoints.empty()) {
+    return {};
+  }
+  WorldPos waypoint = m_Waypoints.front();
+  m_Waypoints.pop_front();
+  return waypoint;
+}
+
 bool Entity::CollidesWith(const Entity &other) const {
   const auto &A = *this;
   const auto &B = other;
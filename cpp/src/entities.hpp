@@ -6,10 +6,13 @@
 #include <memory>
 #include <optional>
 #include <string_view>
+#include <utility>
 
 #include "log.hpp"
 #include "math.hpp"
 #include "pathfinder/base.hpp"
+#include "pathfinder/flow_field.hpp"
+#include "pathfinder/followed_path.hpp"
 #include "sprite.hpp"
 
 class Entity {
@@ -58,11 +61,43 @@ public:
 
   void ZeroActualVelocityInDirection(WorldPos direction);
 
-  const pathfinder::Path &GetPath() const { return m_Path; }
-  pathfinder::Path &GetPath() { return m_Path; }
-  void SetPath(pathfinder::Path &path) { m_Path = path; }
+  const pathfinder::FollowedPath &GetPath() const { return m_Path; }
+  void SetPath(pathfinder::Path path) {
+    SetPath(pathfinder::FollowedPath(std::move(path)));
+  }
+  // the route may be shared with other entities
+  void SetPath(pathfinder::FollowedPath path) {
+    m_Path = std::move(path);
+    m_Waypoints.clear();
+    m_FlowField.reset();
+  }
   std::optional<WorldPos> GetMoveTarget();
 
+  // Coarse path from a hierarchical pathfinder, the segment to the next
+  // waypoint is refined into the path only once the current one is walked
+  void SetWaypoints(pathfinder::Path waypoints) {
+    m_Path.clear();
+    m_Waypoints = pathfinder::FollowedPath(std::move(waypoints));
+    m_FlowField.reset();
+  }
+  bool NeedsRefinement() const {
+    return m_Path.empty() && !m_Waypoints.empty();
+  }
+  std::optional<WorldPos> PopWaypoint();
+  const pathfinder::FollowedPath &GetWaypoints() const { return m_Waypoints; }
+  // the refined segment to the waypoint popped last, keeps the waypoints
+  void SetPathSegment(pathfinder::Path segment) {
+    m_Path = pathfinder::FollowedPath(std::move(segment));
+  }
+
+  // Follow a flow field shared by a group of entities instead of own path,
+  // the next step is read from the field every time
+  void SetFlowField(std::shared_ptr<const pathfinder::FlowField> field) {
+    m_Path.clear();
+    m_Waypoints.clear();
+    m_FlowField = std::move(field);
+  }
+
   bool CollidesWith(const Entity &other) const;
 
   bool IsCollisionBoxVisible() const { return m_CollisionBoxVisible; }
@@ -75,7 +110,9 @@ protected:
   WorldPos m_Position;
   WorldPos m_ActualVelocity;
   WorldPos m_RequestedVelocity;
-  pathfinder::Path m_Path;
+  pathfinder::FollowedPath m_Path;
+  pathfinder::FollowedPath m_Waypoints;
+  std::shared_ptr<const pathfinder::FlowField> m_FlowField;
 
 private:
   bool m_FlagExpired = false;
@@ -67,6 +67,7 @@ void GameLoop::Run() {
   LOG_INFO("Running the game");
   while (!m_Game->IsExitRequested()) {
     m_Game->HandleActions(m_UserInput->GetActions());
+    m_Game->UpdatePaths(kPathExpansionsPerFrame);
     m_Game->UpdateWorld();
 
     m_Window->ClearWindow();
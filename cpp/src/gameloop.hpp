@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 
 #include "pathfindingdemo.hpp"
@@ -25,6 +26,10 @@ public:
   }
 
 private:
+  // nodes the time-sliced path requests may expand per frame, shared by all
+  // of them, keeps the frame time bounded however many units get orders
+  static constexpr size_t kPathExpansionsPerFrame = 20000;
+
   void Draw();
 
   std::unique_ptr<PathFindingDemo> m_Game;
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -14,6 +15,21 @@ Map::Map(int rows, int cols) : m_Cols(cols), m_Rows(rows) {
       m_Tiles[row].push_back(&tile_types.at(TileType::GRASS));
     }
   }
+  m_Costs.assign(GetTileCount(), tile_types.at(TileType::GRASS).cost);
+  m_Impassable.assign(GetTileCount(), 0);
+  RelabelComponents();
+}
+
+void TileRect::Extend(TilePos p) {
+  min = TilePos{std::min(min.x(), p.x()), std::min(min.y(), p.y())};
+  max = TilePos{std::max(max.x(), p.x()), std::max(max.y(), p.y())};
+}
+
+void TileRect::Extend(const TileRect &other) {
+  if (other.IsEmpty())
+    return;
+  Extend(other.min);
+  Extend(other.max);
 }
 
 WorldPos Map::TileToWorld(TilePos p) const {
@@ -52,24 +68,6 @@ bool Map::IsTilePosValid(TilePos p) const {
   return row < m_Tiles.size() && col < m_Tiles[0].size();
 }
 
-std::vector<TilePos> Map::GetNeighbors(TilePos center) const {
-  std::vector<TilePos> neighbours;
-  neighbours.reserve(4);
-
-  std::array<TilePos, 4> candidates = {
-      center + TilePos{1, 0},
-      center + TilePos{-1, 0},
-      center + TilePos{0, 1},
-      center + TilePos{0, -1},
-  };
-
-  for (const auto &c : candidates) {
-    if (IsTilePosValid(c))
-      neighbours.push_back(c);
-  }
-  return neighbours;
-}
-
 void Map::PaintCircle(TilePos center, unsigned radius, TileType tile_type) {
   // get rectangle that wraps the circle
   TilePos corner1 = TilePos{center.x() - static_cast<int32_t>(radius),
@@ -78,17 +76,19 @@ void Map::PaintCircle(TilePos center, unsigned radius, TileType tile_type) {
                             center.y() + static_cast<int32_t>(radius)};
   // iterate through all valid points, setting the type
   const unsigned radius_squared = radius * radius;
+  TileRect changed;
   for (int x = corner1.x(); x < corner2.x(); x++) {
     for (int y = corner1.y(); y < corner2.y(); y++) {
       TilePos current_tile = {x, y};
       unsigned distance_squared = static_cast<unsigned>(
           center.DistanceTo(current_tile) * center.DistanceTo(current_tile));
-      if (IsTilePosValid(current_tile) && distance_squared < radius_squared) {
+      if (distance_squared < radius_squared) {
         // y is row, x is col
-        m_Tiles[y][x] = &tile_types.at(tile_type);
+        SetTile(TilePos{y, x}, tile_type, changed);
       }
     }
   }
+  RecordChange(changed);
 }
 
 void Map::PaintLine(TilePos start_tile, TilePos stop_tile, double width,
@@ -102,6 +102,7 @@ void Map::PaintLine(TilePos start_tile, TilePos stop_tile, double width,
   const vec<double, 2> ortho = step.GetOrthogonal();
   LOG_DEBUG("step = ", step, " ortho = ", ortho);
 
+  TileRect changed;
   // NOLINTNEXTLINE(clang-analyzer-security.FloatLoopCounter)
   for (double t = 0; t < line_length; t += 1.0) {
     // NOLINTNEXTLINE(clang-analyzer-security.FloatLoopCounter)
@@ -109,28 +110,200 @@ void Map::PaintLine(TilePos start_tile, TilePos stop_tile, double width,
       auto tile_pos = start + step * t + ortho * ortho_t;
       TilePos tile_pos_int{static_cast<int32_t>(tile_pos.x()),
                            static_cast<int32_t>(tile_pos.y())};
-      if (IsTilePosValid(tile_pos_int)) {
-        size_t row = static_cast<size_t>(tile_pos.x());
-        size_t col = static_cast<size_t>(tile_pos.y());
-        m_Tiles[row][col] = &tile_types.at(tile_type);
-      }
+      SetTile(tile_pos_int, tile_type, changed);
     }
   }
+  RecordChange(changed);
 }
 
 void Map::PaintRectangle(TilePos first_corner, TilePos second_corner,
                          TileType tile_type) {
   std::initializer_list<int> xvals = {first_corner.x(), second_corner.x()};
   std::initializer_list<int> yvals = {first_corner.y(), second_corner.y()};
+  TileRect changed;
   for (int x = std::min(xvals); x < std::max(xvals); x++) {
     for (int y = std::min(yvals); y < std::max(yvals); y++) {
       TilePos tile_pos{x, y};
       LOG_DEBUG("tile_pos = ", tile_pos);
-      if (IsTilePosValid(tile_pos)) {
-        size_t row = static_cast<size_t>(tile_pos.x());
-        size_t col = static_cast<size_t>(tile_pos.y());
-        m_Tiles[row][col] = &tile_types.at(tile_type);
-      }
+      SetTile(tile_pos, tile_type, changed);
+    }
+  }
+  RecordChange(changed);
+}
+
+void Map::PaintTiles(const std::vector<TileType> &tiles) {
+  assert(tiles.size() == GetTileCount());
+  TileRect changed;
+  for (size_t idx = 0; idx < tiles.size(); idx++)
+    SetTile(IndexToTile(idx), tiles[idx], changed);
+  // most of the map may have changed, labelling it from scratch is cheaper
+  // than refilling around every blocked tile
+  m_NewlyOpened.clear();
+  m_NewlyBlocked.clear();
+  RelabelComponents();
+  RecordChange(changed);
+}
+
+void Map::SetTile(TilePos p, TileType tile_type, TileRect &changed) {
+  if (!IsTilePosValid(p))
+    return;
+  const Tile *tile = &tile_types.at(tile_type);
+  size_t row = static_cast<size_t>(p.x());
+  size_t col = static_cast<size_t>(p.y());
+  if (m_Tiles[row][col] == tile)
+    return;
+  m_Tiles[row][col] = tile;
+  m_Costs[TileToIndex(p)] = tile->cost;
+  const size_t idx = TileToIndex(p);
+  const bool was_passable = !m_Impassable[idx];
+  m_Impassable[idx] = !tile->passable;
+  if (was_passable && !tile->passable)
+    m_NewlyBlocked.push_back(p);
+  else if (!was_passable && tile->passable)
+    m_NewlyOpened.push_back(p);
+  changed.Extend(p);
+}
+
+void Map::RecordChange(const TileRect &changed) {
+  if (changed.IsEmpty())
+    return;
+  UpdateComponents();
+  m_Version++;
+  m_Changes.push_back(MapChange{m_Version, changed});
+  if (m_Changes.size() > kMaxChanges) {
+    // merge the oldest half into one change, callers that are that far
+    // behind update the union of the areas
+    const size_t merged = m_Changes.size() / 2;
+    for (size_t i = 1; i < merged; i++)
+      m_Changes.front().area.Extend(m_Changes[i].area);
+    m_Changes.front().version = m_Changes[merged - 1].version;
+    m_Changes.erase(m_Changes.begin() + 1, m_Changes.begin() + merged);
+  }
+}
+
+void Map::SetConnectivity(Connectivity connectivity) {
+  if (connectivity == m_Connectivity)
+    return;
+  m_Connectivity = connectivity;
+  if (GetTileCount() == 0)
+    return;
+  TileRect changed;
+  changed.Extend(TilePos{0, 0});
+  changed.Extend(IndexToTile(GetTileCount() - 1));
+  RecordChange(changed);
+}
+
+std::span<const MapChange> Map::GetChangesSince(uint64_t version) const {
+  // versions are increasing, so the newer changes are at the end
+  auto first = std::ranges::upper_bound(m_Changes, version, {},
+                                        &MapChange::version);
+  return {first, m_Changes.end()};
+}
+
+uint32_t Map::GetComponent(TilePos p) const {
+  if (!IsPassable(p))
+    return kNoComponent;
+  return FindComponent(m_ComponentLabels[TileToIndex(p)]);
+}
+
+bool Map::IsReachable(TilePos from, TilePos to) const {
+  const uint32_t component = GetComponent(from);
+  return component != kNoComponent && component == GetComponent(to);
+}
+
+uint32_t Map::FindComponent(uint32_t label) const {
+  // no path compression here, searches on other threads may be asking
+  while (m_ComponentParent[label] != label)
+    label = m_ComponentParent[label];
+  return label;
+}
+
+uint32_t Map::CompressComponent(uint32_t label) {
+  while (m_ComponentParent[label] != label) {
+    m_ComponentParent[label] = m_ComponentParent[m_ComponentParent[label]];
+    label = m_ComponentParent[label];
+  }
+  return label;
+}
+
+void Map::UnionComponents(uint32_t a, uint32_t b) {
+  a = CompressComponent(a);
+  b = CompressComponent(b);
+  if (a == b)
+    return;
+  if (m_ComponentRank[a] < m_ComponentRank[b])
+    std::swap(a, b);
+  m_ComponentParent[b] = a;
+  if (m_ComponentRank[a] == m_ComponentRank[b])
+    m_ComponentRank[a]++;
+}
+
+uint32_t Map::NewComponent() {
+  const auto label = static_cast<uint32_t>(m_ComponentParent.size());
+  m_ComponentParent.push_back(label);
+  m_ComponentRank.push_back(0);
+  return label;
+}
+
+void Map::FillComponent(TilePos start, uint32_t label) {
+  std::vector<TilePos> stack{start};
+  m_ComponentLabels[TileToIndex(start)] = label;
+  while (!stack.empty()) {
+    const TilePos current = stack.back();
+    stack.pop_back();
+    for (TilePos step : kNeighborSteps) {
+      const TilePos next = current + step;
+      if (!IsPassable(next) || m_ComponentLabels[TileToIndex(next)] == label)
+        continue;
+      m_ComponentLabels[TileToIndex(next)] = label;
+      stack.push_back(next);
     }
   }
 }
+
+void Map::UpdateComponents() {
+  // A single Paint* call either opens or blocks tiles. Opened tiles can only
+  // join components, which the union-find handles directly.
+  for (TilePos p : m_NewlyOpened) {
+    const uint32_t label = NewComponent();
+    m_ComponentLabels[TileToIndex(p)] = label;
+    for (TilePos step : kNeighborSteps) {
+      const TilePos next = p + step;
+      if (IsPassable(next) &&
+          m_ComponentLabels[TileToIndex(next)] != kNoComponent)
+        UnionComponents(label, m_ComponentLabels[TileToIndex(next)]);
+    }
+  }
+
+  // Blocked tiles may split their component. Every part of it touches one
+  // of the blocked tiles, so refilling from their neighbours relabels all
+  // of them, components away from the change keep their labels.
+  const auto first_new = static_cast<uint32_t>(m_ComponentParent.size());
+  for (TilePos p : m_NewlyBlocked)
+    m_ComponentLabels[TileToIndex(p)] = kNoComponent;
+  for (TilePos p : m_NewlyBlocked) {
+    for (TilePos step : kNeighborSteps) {
+      const TilePos next = p + step;
+      // labels from first_new up were filled by this loop already
+      if (IsPassable(next) && m_ComponentLabels[TileToIndex(next)] < first_new)
+        FillComponent(next, NewComponent());
+    }
+  }
+  m_NewlyOpened.clear();
+  m_NewlyBlocked.clear();
+
+  // abandoned labels pile up in the union-find, start over once there are
+  // many more of them than tiles
+  if (m_ComponentParent.size() > 2 * GetTileCount() + 1)
+    RelabelComponents();
+}
+
+void Map::RelabelComponents() {
+  m_ComponentLabels.assign(GetTileCount(), kNoComponent);
+  m_ComponentParent.clear();
+  m_ComponentRank.clear();
+  for (size_t idx = 0; idx < GetTileCount(); idx++) {
+    if (!m_Impassable[idx] && m_ComponentLabels[idx] == kNoComponent)
+      FillComponent(IndexToTile(idx), NewComponent());
+  }
+}
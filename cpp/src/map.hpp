@@ -1,5 +1,11 @@
 #pragma once
 
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <span>
 #include <vector>
 
 #include "math.hpp"
@@ -7,9 +13,72 @@
 
 using TileGrid = std::vector<std::vector<const Tile *>>;
 
+// Rectangle of tiles, both corners inclusive. Default constructed
+// rectangle is empty and grows with Extend().
+struct TileRect {
+  TilePos min{std::numeric_limits<int32_t>::max(),
+              std::numeric_limits<int32_t>::max()};
+  TilePos max{std::numeric_limits<int32_t>::min(),
+              std::numeric_limits<int32_t>::min()};
+
+  bool IsEmpty() const { return min.x() > max.x() || min.y() > max.y(); }
+  bool Contains(TilePos p) const {
+    return min.x() <= p.x() && p.x() <= max.x() && min.y() <= p.y() &&
+           p.y() <= max.y();
+  }
+  void Extend(TilePos p);
+  void Extend(const TileRect &other);
+};
+
+// Tiles touched by a single Paint* call
+struct MapChange {
+  uint64_t version; // map version after the change
+  TileRect area;
+};
+
+// Neighbour of a tile with everything a search needs to relax the edge
+struct Neighbor {
+  TilePos pos;
+  size_t index; // Map::TileToIndex(pos)
+  float step;   // length of the move, 1 or sqrt(2) for diagonals
+  float cost;   // cost of the move, step times the cost of the tile
+};
+
+// Moves allowed between tiles: only the four sides or also the diagonals.
+// Diagonal moves can't cut the corner of an impassable tile.
+enum class Connectivity {
+  FOUR = 4,
+  EIGHT = 8,
+};
+
+// Fixed-capacity list of neighbours, lives on the stack so expanding a node
+// doesn't allocate
+class NeighborList {
+public:
+  static constexpr size_t kCapacity = 8;
+
+  void push_back(const Neighbor &neighbor) { m_Items[m_Size++] = neighbor; }
+  // always writes, but only keeps the entry if "keep" is set (no branch)
+  void push_back_if(const Neighbor &neighbor, bool keep) {
+    m_Items[m_Size] = neighbor;
+    m_Size += keep;
+  }
+  const Neighbor *begin() const { return m_Items.data(); }
+  const Neighbor *end() const { return m_Items.data() + m_Size; }
+  size_t size() const { return m_Size; }
+  bool empty() const { return m_Size == 0; }
+  const Neighbor &operator[](size_t i) const { return m_Items[i]; }
+
+private:
+  std::array<Neighbor, kCapacity> m_Items;
+  size_t m_Size = 0;
+};
+
 class Map {
 public:
   static constexpr float TILE_SIZE = 10.0f; // tile size in world
+  // entries of the change log, see GetChangesSince
+  static constexpr size_t kMaxChanges = 64;
 
   Map(int rows, int cols);
   Map() : Map(0, 0) {}
@@ -32,21 +101,166 @@ public:
 
   bool IsTilePosValid(TilePos p) const;
 
+  size_t GetRows() const { return m_Rows; }
+  size_t GetCols() const { return m_Cols; }
+  size_t GetTileCount() const { return m_Rows * m_Cols; }
+
+  // flat tile index (row * cols + col), used by the search state arrays
+  size_t TileToIndex(TilePos p) const {
+    return static_cast<size_t>(p.x()) * m_Cols + static_cast<size_t>(p.y());
+  }
+  TilePos IndexToTile(size_t index) const {
+    return TilePos{static_cast<int32_t>(index / m_Cols),
+                   static_cast<int32_t>(index % m_Cols)};
+  }
+
   // methods for drawing on the map
   void PaintCircle(TilePos center, unsigned radius, TileType tile_type);
   void PaintLine(TilePos start, TilePos stop, double width, TileType tile_type);
   void PaintRectangle(TilePos first_corner, TilePos second_corner,
                       TileType tile_type);
+  // sets every tile, one type per flat index, as a single change
+  void PaintTiles(const std::vector<TileType> &tiles);
+
+  // Every Paint* call that changes at least one tile bumps the version, so
+  // pathfinders can tell that their precomputed data is out of date.
+  uint64_t GetVersion() const { return m_Version; }
+  // Areas changed after the given version, oldest first, valid until the
+  // next change. The log keeps kMaxChanges entries, older ones are merged
+  // into the first entry, so long outdated callers get a larger area.
+  std::span<const MapChange> GetChangesSince(uint64_t version) const;
+
+  // changing the connectivity changes every path, it's recorded as a change
+  // of the whole map
+  void SetConnectivity(Connectivity connectivity);
+  Connectivity GetConnectivity() const { return m_Connectivity; }
+
+  bool IsPassable(TilePos p) const {
+    return IsTilePosValid(p) && !m_Impassable[TileToIndex(p)];
+  }
+
+  // Passable tiles are labelled by the connected component they belong to,
+  // the labels are kept up to date by every Paint* call. Diagonal moves
+  // can't cut corners, so they never connect anything the four sides don't
+  // and the components are the same for both connectivities.
+  static constexpr uint32_t kNoComponent =
+      std::numeric_limits<uint32_t>::max();
+  // component of the tile, kNoComponent for invalid or impassable tiles
+  uint32_t GetComponent(TilePos p) const;
+  // false if there is no path between the tiles, no matter the cost
+  bool IsReachable(TilePos from, TilePos to) const;
 
-  std::vector<TilePos> GetNeighbors(TilePos center) const;
-  float GetCost(TilePos pos) const { return GetTileAt(pos)->cost; }
+  // Passable neighbours of "center" with their index and cost. Searches call
+  // this for every expanded node, so it's inline and has a fast path for
+  // tiles away from the border, which have all neighbours.
+  NeighborList GetNeighbors(TilePos center) const {
+    NeighborList neighbors;
+    const size_t idx = TileToIndex(center);
+    const auto x = static_cast<size_t>(center.x());
+    const auto y = static_cast<size_t>(center.y());
+    // negative coordinates wrap around and fail the checks too
+    if (x - 1 < m_Rows - 2 && y - 1 < m_Cols - 2) {
+      const size_t down = idx + m_Cols, up = idx - m_Cols;
+      const bool open_down = !m_Impassable[down], open_up = !m_Impassable[up];
+      const bool open_right = !m_Impassable[idx + 1];
+      const bool open_left = !m_Impassable[idx - 1];
+      neighbors.push_back_if(
+          {center + TilePos{1, 0}, down, 1.0f, m_Costs[down]}, open_down);
+      neighbors.push_back_if({center + TilePos{-1, 0}, up, 1.0f, m_Costs[up]},
+                             open_up);
+      neighbors.push_back_if(
+          {center + TilePos{0, 1}, idx + 1, 1.0f, m_Costs[idx + 1]},
+          open_right);
+      neighbors.push_back_if(
+          {center + TilePos{0, -1}, idx - 1, 1.0f, m_Costs[idx - 1]},
+          open_left);
+      if (m_Connectivity == Connectivity::EIGHT) {
+        constexpr float d = std::numbers::sqrt2_v<float>;
+        neighbors.push_back_if(
+            {center + TilePos{1, 1}, down + 1, d, d * m_Costs[down + 1]},
+            open_down && open_right && !m_Impassable[down + 1]);
+        neighbors.push_back_if(
+            {center + TilePos{1, -1}, down - 1, d, d * m_Costs[down - 1]},
+            open_down && open_left && !m_Impassable[down - 1]);
+        neighbors.push_back_if(
+            {center + TilePos{-1, 1}, up + 1, d, d * m_Costs[up + 1]},
+            open_up && open_right && !m_Impassable[up + 1]);
+        neighbors.push_back_if(
+            {center + TilePos{-1, -1}, up - 1, d, d * m_Costs[up - 1]},
+            open_up && open_left && !m_Impassable[up - 1]);
+      }
+      return neighbors;
+    }
+
+    for (TilePos step : kNeighborSteps) {
+      const TilePos next = center + step;
+      if (!IsTilePosValid(next) || m_Impassable[TileToIndex(next)])
+        continue;
+      const size_t next_idx = TileToIndex(next);
+      neighbors.push_back({next, next_idx, 1.0f, m_Costs[next_idx]});
+    }
+    if (m_Connectivity == Connectivity::EIGHT) {
+      for (TilePos step : kDiagonalSteps) {
+        const TilePos next = center + step;
+        if (!IsTilePosValid(next) || m_Impassable[TileToIndex(next)] ||
+            m_Impassable[TileToIndex(center + TilePos{step.x(), 0})] ||
+            m_Impassable[TileToIndex(center + TilePos{0, step.y()})])
+          continue;
+        constexpr float d = std::numbers::sqrt2_v<float>;
+        const size_t next_idx = TileToIndex(next);
+        neighbors.push_back({next, next_idx, d, d * m_Costs[next_idx]});
+      }
+    }
+    return neighbors;
+  }
+  float GetCost(TilePos pos) const {
+    assert(IsTilePosValid(pos));
+    return m_Costs[TileToIndex(pos)];
+  }
 
   template <typename T> double GetTileVelocityCoeff(T p) const {
     return 1.0 / GetTileAt(p)->cost;
   }
 
 private:
+  // same order as the fast path of GetNeighbors
+  static inline const std::array<TilePos, 4> kNeighborSteps = {
+      TilePos{1, 0}, TilePos{-1, 0}, TilePos{0, 1}, TilePos{0, -1}};
+  static inline const std::array<TilePos, 4> kDiagonalSteps = {
+      TilePos{1, 1}, TilePos{1, -1}, TilePos{-1, 1}, TilePos{-1, -1}};
+
+  // set the tile if it's on the map, grows "changed" if the type differs
+  void SetTile(TilePos p, TileType tile_type, TileRect &changed);
+  void RecordChange(const TileRect &changed);
+
+  // Components are kept as per-tile labels merged by a union-find, so
+  // opening tiles only joins labels and blocking tiles only refills the
+  // areas around them.
+  uint32_t FindComponent(uint32_t label) const;
+  // same as FindComponent, but also shortens the path to the root
+  uint32_t CompressComponent(uint32_t label);
+  void UnionComponents(uint32_t a, uint32_t b);
+  uint32_t NewComponent();
+  // flood fills "label" over the passable tiles connected to "start"
+  void FillComponent(TilePos start, uint32_t label);
+  void UpdateComponents();
+  void RelabelComponents();
+
   TileGrid m_Tiles;
+  // cost of every tile by flat index, kept next to m_Tiles for the searches
+  std::vector<float> m_Costs;
+  // 1 for impassable tiles, diagonal moves can't pass their corners either
+  std::vector<uint8_t> m_Impassable;
+  // component label of every tile and the union-find over the labels
+  std::vector<uint32_t> m_ComponentLabels;
+  std::vector<uint32_t> m_ComponentParent;
+  std::vector<uint8_t> m_ComponentRank;
+  // tiles whose passability changed since the last RecordChange
+  std::vector<TilePos> m_NewlyBlocked;
+  std::vector<TilePos> m_NewlyOpened;
   size_t m_Cols = 0;
   size_t m_Rows = 0;
+  uint64_t m_Version = 0;
+  Connectivity m_Connectivity = Connectivity::FOUR;
+  std::vector<MapChange> m_Changes;
 };
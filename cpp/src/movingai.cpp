@@ -0,0 +1,129 @@
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "movingai.hpp"
+
+#include "log.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "tile.hpp"
+
+namespace movingai {
+
+namespace {
+
+TileType ToTileType(char c) {
+  switch (c) {
+  case '.':
+  case 'G':
+  case 'S':
+    return TileType::GRASS;
+  default:
+    return TileType::WALL;
+  }
+}
+
+} // namespace
+
+std::expected<std::unique_ptr<Map>, std::string>
+LoadMap(const std::filesystem::path &path) {
+  std::ifstream file(path);
+  if (!file)
+    return std::unexpected("Cannot open " + path.string());
+
+  // "type octile", "height H", "width W" and "map", the order of the
+  // first three is not fixed
+  int height = -1, width = -1;
+  std::string key;
+  while (file >> key && key != "map") {
+    if (key == "type") {
+      std::string type;
+      file >> type;
+      if (type != "octile")
+        return std::unexpected(path.string() + ": unsupported map type " +
+                               type);
+    } else if (key == "height") {
+      file >> height;
+    } else if (key == "width") {
+      file >> width;
+    } else {
+      return std::unexpected(path.string() + ": unknown header " + key);
+    }
+  }
+  if (key != "map" || height <= 0 || width <= 0)
+    return std::unexpected(path.string() + " is not a MovingAI map");
+
+  std::vector<TileType> tiles;
+  tiles.reserve(static_cast<size_t>(height) * static_cast<size_t>(width));
+  std::string line;
+  std::getline(file, line); // rest of the "map" line
+  for (int row = 0; row < height; row++) {
+    if (!std::getline(file, line))
+      return std::unexpected(path.string() + " is truncated");
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.size() != static_cast<size_t>(width))
+      return std::unexpected(path.string() + ": row " + std::to_string(row) +
+                             " has " + std::to_string(line.size()) +
+                             " tiles instead of " + std::to_string(width));
+    for (char c : line)
+      tiles.push_back(ToTileType(c));
+  }
+
+  auto map = std::make_unique<Map>(height, width);
+  map->SetConnectivity(Connectivity::EIGHT);
+  map->PaintTiles(tiles);
+  LOG_INFO("Loaded ", path.string(), ", ", width, "x", height, " tiles");
+  return map;
+}
+
+std::expected<std::vector<Scenario>, std::string>
+LoadScenarios(const std::filesystem::path &path, const Map &map) {
+  std::ifstream file(path);
+  if (!file)
+    return std::unexpected("Cannot open " + path.string());
+
+  std::string line;
+  if (!std::getline(file, line) || !line.starts_with("version"))
+    return std::unexpected(path.string() + " is not a MovingAI scenario");
+
+  std::vector<Scenario> scenarios;
+  size_t line_number = 1;
+  while (std::getline(file, line)) {
+    line_number++;
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+    // bucket, map file, map width and height, start x and y, goal x and y,
+    // optimal cost. The map file name may not contain whitespace.
+    std::istringstream fields(line);
+    Scenario scenario;
+    std::string map_name;
+    size_t width, height;
+    int start_x, start_y, goal_x, goal_y;
+    if (!(fields >> scenario.bucket >> map_name >> width >> height >>
+          start_x >> start_y >> goal_x >> goal_y >> scenario.optimal_cost))
+      return std::unexpected(path.string() + ":" +
+                             std::to_string(line_number) + " is malformed");
+    if (width != map.GetCols() || height != map.GetRows())
+      return std::unexpected(path.string() + ":" +
+                             std::to_string(line_number) + " is for " +
+                             map_name + ", a map of a different size");
+    // x is the column, our tile positions are (row, column)
+    scenario.start = TilePos{start_y, start_x};
+    scenario.goal = TilePos{goal_y, goal_x};
+    if (!map.IsTilePosValid(scenario.start) ||
+        !map.IsTilePosValid(scenario.goal))
+      return std::unexpected(path.string() + ":" +
+                             std::to_string(line_number) +
+                             " leaves the map");
+    scenarios.push_back(scenario);
+  }
+  return scenarios;
+}
+
+} // namespace movingai
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "map.hpp"
+#include "math.hpp"
+
+// Loader for the grid benchmarks of Sturtevant's MovingAI repository
+// (https://movingai.com/benchmarks/formats.html).
+//
+// A .map file is a grid of characters, "." and "G" are ground, "S" (swamp)
+// is passable too, everything else (out of bounds "@" and "O", trees "T",
+// water "W") becomes a wall. The maps are octile: 8-connected, diagonals
+// cost sqrt(2) and don't cut corners, which is what Connectivity::EIGHT
+// does, so the loaded map uses it.
+//
+// A .scen file lists queries with the optimal cost of each, grouped into
+// buckets of similar length.
+namespace movingai {
+
+struct Scenario {
+  unsigned bucket;
+  TilePos start;
+  TilePos goal;
+  double optimal_cost;
+};
+
+std::expected<std::unique_ptr<Map>, std::string>
+LoadMap(const std::filesystem::path &path);
+
+// scenarios made for a map of a different size or leaving it are rejected
+std::expected<std::vector<Scenario>, std::string>
+LoadScenarios(const std::filesystem::path &path, const Map &map);
+
+} // namespace movingai
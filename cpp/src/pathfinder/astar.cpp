@@ -0,0 +1,146 @@
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <numbers>
+
+#include "astar.hpp"
+
+#include "base.hpp"
+#include "landmarks.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+namespace heuristic {
+
+float Manhattan::operator()(const TilePos &a, const TilePos &b) const {
+  return scale *
+         static_cast<float>(std::abs(a.x() - b.x()) + std::abs(a.y() - b.y()));
+}
+
+float Octile::operator()(const TilePos &a, const TilePos &b) const {
+  const auto dx = static_cast<float>(std::abs(a.x() - b.x()));
+  const auto dy = static_cast<float>(std::abs(a.y() - b.y()));
+  constexpr float diagonal_extra = std::numbers::sqrt2_v<float> - 1.0f;
+  return scale * (std::max(dx, dy) + diagonal_extra * std::min(dx, dy));
+}
+
+float Euclidean::operator()(const TilePos &a, const TilePos &b) const {
+  const auto dx = static_cast<float>(a.x() - b.x());
+  const auto dy = static_cast<float>(a.y() - b.y());
+  return scale * std::sqrt(dx * dx + dy * dy);
+}
+
+float Grid::operator()(const TilePos &a, const TilePos &b) const {
+  if (map && map->GetConnectivity() == Connectivity::EIGHT)
+    return octile(a, b);
+  return manhattan(a, b);
+}
+
+} // namespace heuristic
+
+template <typename Heuristic, typename Frontier>
+Path AStar<Heuristic, Frontier>::FindPath(WorldPos start_world,
+                                          WorldPos end_world) {
+  Begin(start_world, end_world);
+  Step(std::numeric_limits<size_t>::max());
+  return TakePath();
+}
+
+template <typename Heuristic, typename Frontier>
+void AStar<Heuristic, Frontier>::Begin(WorldPos start_world,
+                                       WorldPos end_world) {
+  ResetCounters();
+  m_Status = SearchStatus::NOT_FOUND;
+  if (!m_Map)
+    return;
+  // heuristics with precomputed data catch up with changes of the map
+  if constexpr (requires { m_Heuristic.Refresh(); })
+    m_Heuristic.Refresh();
+
+  m_Start = m_Map->WorldToTile(start_world);
+  m_End = m_Map->WorldToTile(end_world);
+
+  if (!m_Map->IsTilePosValid(m_Start) || !m_Map->IsTilePosValid(m_End))
+    return;
+  if (m_Start == m_End)
+    return;
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(m_Start, m_End))
+    return;
+
+  // clear previous run
+  m_State.Reset(m_Map);
+  m_Frontier.clear();
+
+  const size_t start_idx = m_Map->TileToIndex(m_Start);
+  m_Frontier.push({m_Heuristic(m_Start, m_End), m_Start});
+  CountPush(m_Frontier.size());
+  m_State.Visit(start_idx, 0.0f, start_idx); // sentinel
+  m_Status = SearchStatus::IN_PROGRESS;
+}
+
+template <typename Heuristic, typename Frontier>
+SearchStatus AStar<Heuristic, Frontier>::Step(size_t max_expansions) {
+  using QueueEntry = utils::QueueEntry;
+
+  if (m_Status != SearchStatus::IN_PROGRESS)
+    return m_Status;
+
+  size_t expanded = 0;
+  while (!m_Frontier.empty()) {
+    const QueueEntry current = m_Frontier.top();
+    if (current.tile == m_End) { // early exit
+      m_Status = SearchStatus::FOUND;
+      return m_Status;
+    }
+    if (expanded == max_expansions)
+      return m_Status; // out of budget, the frontier stays for next time
+    m_Frontier.pop();
+
+    const size_t current_idx = m_Map->TileToIndex(current.tile);
+    const float current_cost = m_State.GetCost(current_idx);
+    // skip stale entries, the tile was reached cheaper in the meantime
+    if (current.cost > current_cost + m_Heuristic(current.tile, m_End))
+      continue;
+    m_ExpandedNodes++;
+    expanded++;
+
+    for (const Neighbor &next : m_Map->GetNeighbors(current.tile)) {
+      const float newCost = current_cost + next.cost;
+
+      if (!m_State.IsVisited(next.index) ||
+          newCost < m_State.GetCost(next.index)) {
+        m_State.Visit(next.index, newCost, current_idx);
+        m_Frontier.push({newCost + m_Heuristic(next.pos, m_End), next.pos});
+        CountPush(m_Frontier.size());
+      }
+    }
+  }
+
+  m_Status = m_State.IsVisited(m_Map->TileToIndex(m_End))
+                 ? SearchStatus::FOUND
+                 : SearchStatus::NOT_FOUND;
+  return m_Status;
+}
+
+template <typename Heuristic, typename Frontier>
+Path AStar<Heuristic, Frontier>::TakePath() {
+  if (m_Status != SearchStatus::FOUND)
+    return {};
+  // reconstruct path
+  return m_State.ReconstructPath(*m_Map, m_Start, m_End);
+}
+
+template class AStar<heuristic::Manhattan>;
+template class AStar<heuristic::Grid>;
+template class AStar<heuristic::Octile>;
+template class AStar<heuristic::Euclidean>;
+template class AStar<heuristic::Zero>;
+template class AStar<heuristic::Manhattan, utils::RadixHeap<>>;
+template class AStar<heuristic::Landmark>;
+
+} // namespace pathfinder
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string_view>
+
+#include "base.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Heuristics for A*. All of them are scaled by the cheapest tile cost, so the
+// estimate never exceeds the real cost of reaching the goal (admissible).
+namespace heuristic {
+
+struct Manhattan {
+  float operator()(const TilePos &a, const TilePos &b) const;
+  float scale = utils::cheapest_tile_cost();
+};
+
+struct Octile {
+  float operator()(const TilePos &a, const TilePos &b) const;
+  float scale = utils::cheapest_tile_cost();
+};
+
+struct Euclidean {
+  float operator()(const TilePos &a, const TilePos &b) const;
+  float scale = utils::cheapest_tile_cost();
+};
+
+// Manhattan while the map only allows straight moves, octile once it allows
+// diagonal ones. Pathfinders give it their map if it has none.
+struct Grid {
+  float operator()(const TilePos &a, const TilePos &b) const;
+  const Map *map = nullptr;
+  Manhattan manhattan;
+  Octile octile;
+};
+
+// turns A* into Dijkstra's algorithm
+struct Zero {
+  float operator()(const TilePos &, const TilePos &) const { return 0.0f; }
+};
+
+} // namespace heuristic
+
+// Frontier is utils::PriorityQueue (binary heap) or utils::RadixHeap, the
+// latter needs a consistent heuristic (all of the above are)
+template <typename Heuristic = heuristic::Grid,
+          typename Frontier = utils::PriorityQueue<>>
+class AStar final : public PathFinderBase {
+
+public:
+  AStar(const Map *m, Heuristic h = {}) : PathFinderBase(m), m_Heuristic(h) {
+    if constexpr (requires { m_Heuristic.map; })
+      if (!m_Heuristic.map)
+        m_Heuristic.map = m;
+  }
+  const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override {
+    return m_State.GetMemoryUsage() + m_Frontier.memory_usage();
+  }
+
+  void Begin(WorldPos start, WorldPos end) override;
+  SearchStatus Step(size_t max_expansions) override;
+  Path TakePath() override;
+  bool IsTimeSliced() const override { return true; }
+
+private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
+  // heuristics may give the pathfinder a name of their own
+  static constexpr std::string_view DefaultName() {
+    if constexpr (requires { Heuristic::kName; })
+      return Heuristic::kName;
+    else
+      return "A*";
+  }
+
+  const std::string_view m_Name = DefaultName();
+  Heuristic m_Heuristic;
+  // cost in the search state is g, the frontier is ordered by f = g + h
+  SearchState m_State;
+  Frontier m_Frontier;
+  // query of the running search, kept between the Step calls
+  TilePos m_Start;
+  TilePos m_End;
+  SearchStatus m_Status = SearchStatus::NOT_FOUND;
+};
+
+// implemented in astar.cpp
+extern template class AStar<heuristic::Manhattan>;
+extern template class AStar<heuristic::Grid>;
+extern template class AStar<heuristic::Octile>;
+extern template class AStar<heuristic::Euclidean>;
+extern template class AStar<heuristic::Zero>;
+extern template class AStar<heuristic::Manhattan, utils::RadixHeap<>>;
+
+} // namespace pathfinder
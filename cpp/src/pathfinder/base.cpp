@@ -1,9 +1,13 @@
 #include <cassert>
+#include <chrono>
 #include <memory>
 #include <queue>
+#include <utility>
 
 #include "pathfinder/base.hpp"
 
+#include "pathfinder/utils.hpp"
+
 #include "log.hpp"
 #include "math.hpp"
 
@@ -11,9 +15,58 @@ namespace pathfinder {
 
 PathFinderBase::PathFinderBase(const Map *map) : m_Map(map) {}
 
+Path PathFinderBase::CalculatePath(WorldPos start, WorldPos end) {
+  using Clock = std::chrono::steady_clock;
+  ResetCounters();
+  const auto t0 = Clock::now();
+  Path path = FindPath(start, end);
+  const auto t1 = Clock::now();
+
+  m_LastStats.expanded_nodes = m_ExpandedNodes;
+  m_LastStats.pushed_nodes = m_PushedNodes;
+  m_LastStats.peak_frontier = m_PeakFrontier;
+  m_LastStats.memory_bytes = GetMemoryUsage();
+  m_LastStats.time_ms =
+      std::chrono::duration<double, std::milli>(t1 - t0).count();
+  m_LastStats.path_cost = m_Map ? utils::path_cost(*m_Map, path) : 0.0f;
+  m_LastStats.suboptimality = GetSuboptimality();
+  return path;
+}
+
+void PathFinderBase::ResetCounters() {
+  m_ExpandedNodes = 0;
+  m_PushedNodes = 0;
+  m_PeakFrontier = 0;
+}
+
+void PathFinderBase::CountNested(const SearchStats &stats) {
+  m_ExpandedNodes += stats.expanded_nodes;
+  m_PushedNodes += stats.pushed_nodes;
+  m_PeakFrontier = std::max(m_PeakFrontier, stats.peak_frontier);
+}
+
+void PathFinderBase::Begin(WorldPos start, WorldPos end) {
+  m_SliceStart = start;
+  m_SliceEnd = end;
+  m_SlicePath.reset();
+  ResetCounters();
+}
+
+SearchStatus PathFinderBase::Step(size_t) {
+  if (!m_SlicePath)
+    m_SlicePath = CalculatePath(m_SliceStart, m_SliceEnd);
+  return m_SlicePath->empty() ? SearchStatus::NOT_FOUND : SearchStatus::FOUND;
+}
+
+Path PathFinderBase::TakePath() {
+  if (!m_SlicePath)
+    return {};
+  return std::exchange(*m_SlicePath, {});
+}
+
 // LinearPathFinder also lives here, since it is too small to get it's
 // own implementation file
-Path LinearPathFinder::CalculatePath(
+Path LinearPathFinder::FindPath(
     WorldPos, WorldPos end) // first argument (start pos) not used
 {
   auto path = Path{end};
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -16,9 +18,43 @@ enum class PathFinderType {
   BFS,
   DIJKSTRA,
   GBFS,
+  ASTAR,
+  JPS,
+  HPA,
+  DSTAR_LITE,
+  BIDIRECTIONAL_DIJKSTRA,
+  BIDIRECTIONAL_ASTAR,
+  THETA_STAR,
+  ALT,
+  WEIGHTED_ASTAR,
+  FOCAL_ASTAR,
   COUNT,
 };
 
+// Measurements of one query, see PathFinderBase::GetLastStats
+struct SearchStats {
+  size_t expanded_nodes = 0;
+  // frontier insertions, a tile reached cheaper again counts again
+  size_t pushed_nodes = 0;
+  size_t peak_frontier = 0;
+  // bytes held by the search buffers, they keep their largest size between
+  // queries so this is the peak so far
+  size_t memory_bytes = 0;
+  double time_ms = 0.0;
+  // 0 if no path was found
+  float path_cost = 0.0f;
+  // bound on path cost / optimal cost proven by the search, 1 for the
+  // optimal searches and the ones without a bound (see BoundedAStarBase)
+  float suboptimality = 1.0f;
+};
+
+// progress of a time-sliced search, see PathFinderBase::Step
+enum class SearchStatus {
+  IN_PROGRESS,
+  FOUND,
+  NOT_FOUND,
+};
+
 class PathFinderBase {
 public:
   PathFinderBase(const Map *m);
@@ -30,20 +66,77 @@ public:
   PathFinderBase &operator=(PathFinderBase &&) = delete;
 
   virtual const std::string_view &GetName() const = 0;
-  virtual Path CalculatePath(WorldPos start, WorldPos end) = 0;
+  // runs FindPath and measures it, see GetLastStats
+  Path CalculatePath(WorldPos start, WorldPos end);
+
+  // Hierarchical pathfinders can return just the waypoints first and turn
+  // them into a full path segment by segment, once the entity gets there.
+  // Empty result means the pathfinder doesn't support it, use CalculatePath.
+  virtual Path CalculateAbstractPath(WorldPos, WorldPos) { return {}; }
+  virtual Path RefineSegment(WorldPos from, WorldPos to) {
+    return CalculatePath(from, to);
+  }
+
+  // Time-sliced search, for queries that don't fit into a frame. Begin
+  // starts a query, every Step expands at most max_expansions nodes and
+  // keeps the frontier for the next call, TakePath returns the path once
+  // Step reported FOUND. The map must not change between the calls.
+  // By default the whole search runs in the first Step, only pathfinders
+  // that override these keep to the budget.
+  virtual void Begin(WorldPos start, WorldPos end);
+  virtual SearchStatus Step(size_t max_expansions);
+  virtual Path TakePath();
+  // true if Step keeps to max_expansions
+  virtual bool IsTimeSliced() const { return false; }
+
+  // number of nodes expanded by the last CalculatePath call, or since
+  // Begin for time-sliced searches
+  size_t GetExpandedNodeCount() const { return m_ExpandedNodes; }
+  // statistics of the last CalculatePath call
+  const SearchStats &GetLastStats() const { return m_LastStats; }
+  // bytes held by the search buffers kept between queries, without
+  // precomputed data like the abstract graph of HPA* or landmark tables
+  virtual size_t GetMemoryUsage() const { return 0; }
+  // bound proven by the last query, see SearchStats::suboptimality
+  virtual float GetSuboptimality() const { return 1.0f; }
 
 protected:
+  // the search itself, called by CalculatePath
+  virtual Path FindPath(WorldPos start, WorldPos end) = 0;
+
+  // clear the counters at the start of a query
+  void ResetCounters();
+  // call after every push to the frontier
+  void CountPush(size_t frontier_size) {
+    m_PushedNodes++;
+    m_PeakFrontier = std::max(m_PeakFrontier, frontier_size);
+  }
+  // add the counters of a search run by another pathfinder on our behalf
+  void CountNested(const SearchStats &stats);
+
   const Map *m_Map;
+  size_t m_ExpandedNodes = 0;
+  size_t m_PushedNodes = 0;
+  size_t m_PeakFrontier = 0;
+
+private:
+  SearchStats m_LastStats;
+
+  // query of the default time-sliced search
+  WorldPos m_SliceStart;
+  WorldPos m_SliceEnd;
+  std::optional<Path> m_SlicePath;
 };
 
 class LinearPathFinder final : public PathFinderBase {
 
 public:
   LinearPathFinder(const Map *m) : PathFinderBase(m) {}
-  Path CalculatePath(WorldPos start, WorldPos end) override;
   const std::string_view &GetName() const override { return m_Name; }
 
 private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
   const std::string_view m_Name = "Linear Path";
 };
 
@@ -1,14 +1,15 @@
-#include <queue>
+#include <vector>
 
 #include "bfs.hpp"
 
 #include "base.hpp"
 #include "map.hpp"
 #include "math.hpp"
+#include "search_state.hpp"
 
 namespace pathfinder {
 
-Path BFS::CalculatePath(WorldPos start_world, WorldPos end_world) {
+Path BFS::FindPath(WorldPos start_world, WorldPos end_world) {
   if (m_Map == nullptr)
     return {};
 
@@ -20,28 +21,35 @@ Path BFS::CalculatePath(WorldPos start_world, WorldPos end_world) {
   if (start == end) {
     return {};
   }
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(start, end))
+    return {};
   // clear previous run
-  m_CameFrom.clear();
-  m_Distance.clear();
+  m_State.Reset(m_Map);
+  m_Frontier.clear();
 
-  std::queue<TilePos> frontier;
-  frontier.push(start);
-  m_CameFrom[start] = start;
-  m_Distance[start] = 0.0f;
+  // the frontier is a FIFO queue, popping just moves the head forward
+  size_t frontier_head = 0;
+  m_Frontier.push_back(start);
+  CountPush(m_Frontier.size() - frontier_head);
+  const size_t start_idx = m_Map->TileToIndex(start);
+  m_State.Visit(start_idx, 0.0f, start_idx);
 
   // ---------------- build flow-field ----------------
   bool early_exit = false;
-  while (!frontier.empty() && !early_exit) {
-    TilePos current = frontier.front();
-    frontier.pop();
+  while (frontier_head < m_Frontier.size() && !early_exit) {
+    TilePos current = m_Frontier[frontier_head++];
+    m_ExpandedNodes++;
+    const size_t current_idx = m_Map->TileToIndex(current);
 
-    for (TilePos next : m_Map->GetNeighbors(current)) {
-      if (m_CameFrom.find(next) == m_CameFrom.end()) { // not visited
-        frontier.push(next);
-        m_Distance[next] = m_Distance[current] + 1.0f;
-        m_CameFrom[next] = current;
+    for (const Neighbor &next : m_Map->GetNeighbors(current)) {
+      if (!m_State.IsVisited(next.index)) { // not visited
+        m_Frontier.push_back(next.pos);
+        CountPush(m_Frontier.size() - frontier_head);
+        m_State.Visit(next.index, m_State.GetCost(current_idx) + 1.0f,
+                      current_idx);
 
-        if (next == end) { // early exit
+        if (next.pos == end) { // early exit
           early_exit = true;
           break;
         }
@@ -50,18 +58,7 @@ Path BFS::CalculatePath(WorldPos start_world, WorldPos end_world) {
   }
 
   // --------------- reconstruct path -----------------
-  if (m_CameFrom.find(end) == m_CameFrom.end())
-    return {}; // end not reached
-
-  Path path;
-  TilePos cur = end;
-  path.push_back(m_Map->TileToWorld(cur));
-  while (cur != start) {
-    cur = m_CameFrom[cur];
-    path.push_back(m_Map->TileToWorld(cur));
-  }
-  std::reverse(path.begin(), path.end());
-  return path;
+  return m_State.ReconstructPath(*m_Map, start, end);
 }
 
 } // namespace pathfinder
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <string_view>
-#include <unordered_map>
+#include <vector>
 
 #include "base.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
 
 #include "math.hpp"
 
@@ -13,13 +15,18 @@ class BFS final : public PathFinderBase {
 
 public:
   BFS(const Map *m) : PathFinderBase(m) {}
-  Path CalculatePath(WorldPos start, WorldPos end) override;
   const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override {
+    return m_State.GetMemoryUsage() + utils::memory_usage(m_Frontier);
+  }
 
 private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
   const std::string_view m_Name = "Breadth First Search";
-  std::unordered_map<TilePos, double, TilePosHash> m_Distance;
-  std::unordered_map<TilePos, TilePos, TilePosHash> m_CameFrom;
+  // cost in the search state is the distance (in tiles) from start
+  SearchState m_State;
+  std::vector<TilePos> m_Frontier;
 };
 
 } // namespace pathfinder
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "bidirectional.hpp"
+
+#include "astar.hpp"
+#include "base.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+template <typename Heuristic>
+Path Bidirectional<Heuristic>::FindPath(WorldPos start_world,
+                                        WorldPos end_world) {
+  if (!m_Map)
+    return {};
+
+  const TilePos start = m_Map->WorldToTile(start_world);
+  const TilePos end = m_Map->WorldToTile(end_world);
+
+  if (!m_Map->IsTilePosValid(start) || !m_Map->IsTilePosValid(end))
+    return {};
+  if (start == end)
+    return {};
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(start, end))
+    return {};
+
+  // clear previous run
+  constexpr float infinity = std::numeric_limits<float>::infinity();
+  m_BestCost = infinity;
+  m_Start = start;
+  m_End = end;
+  for (auto [side, from] :
+       {std::pair{&m_Forward, start}, std::pair{&m_Backward, end}}) {
+    side->state.Reset(m_Map);
+    side->frontier.clear();
+    const size_t idx = m_Map->TileToIndex(from);
+    side->state.Visit(idx, 0.0f, idx); // sentinel
+    side->frontier.push({side->sign * Potential(from), from});
+    CountPush(side->frontier.size());
+  }
+
+  while (true) {
+    SkipStale(m_Forward);
+    SkipStale(m_Backward);
+    // once one side runs out, every path has been seen by the other one
+    if (m_Forward.frontier.empty() || m_Backward.frontier.empty())
+      break;
+    // the potentials cancel out, so this is a lower bound of every path
+    // not seen yet
+    if (m_Forward.frontier.top().cost + m_Backward.frontier.top().cost >=
+        m_BestCost)
+      break;
+
+    if (m_Forward.frontier.size() <= m_Backward.frontier.size())
+      Expand(m_Forward, m_Backward, true);
+    else
+      Expand(m_Backward, m_Forward, false);
+  }
+
+  if (m_BestCost == infinity)
+    return {}; // the frontiers never met
+  return ReconstructPath(start, end);
+}
+
+template <typename Heuristic>
+float Bidirectional<Heuristic>::Potential(TilePos tile) const {
+  return 0.5f * (m_Heuristic(tile, m_End) - m_Heuristic(m_Start, tile));
+}
+
+template <typename Heuristic>
+void Bidirectional<Heuristic>::SkipStale(Side &side) {
+  while (!side.frontier.empty()) {
+    const utils::QueueEntry &top = side.frontier.top();
+    const size_t idx = m_Map->TileToIndex(top.tile);
+    const float p = side.sign * Potential(top.tile);
+    if (top.cost <= side.state.GetCost(idx) + p)
+      return;
+    // the tile was reached cheaper after this entry was pushed
+    side.frontier.pop();
+  }
+}
+
+template <typename Heuristic>
+void Bidirectional<Heuristic>::Expand(Side &side, const Side &other,
+                                      bool forward) {
+  const utils::QueueEntry current = side.frontier.top();
+  side.frontier.pop();
+  m_ExpandedNodes++;
+
+  const size_t current_idx = m_Map->TileToIndex(current.tile);
+  const float current_cost = side.state.GetCost(current_idx);
+  // forward: entering "next" costs "next", backward: stepping from "next"
+  // to "current" costs "current" (times the length of the step)
+  const float current_tile_cost = m_Map->GetCost(current.tile);
+
+  for (const Neighbor &next : m_Map->GetNeighbors(current.tile)) {
+    const float newCost =
+        current_cost + (forward ? next.cost : next.step * current_tile_cost);
+
+    if (!side.state.IsVisited(next.index) ||
+        newCost < side.state.GetCost(next.index)) {
+      side.state.Visit(next.index, newCost, current_idx);
+      side.frontier.push(
+          {newCost + side.sign * Potential(next.pos), next.pos});
+      CountPush(side.frontier.size() + other.frontier.size());
+
+      // both searches reached the tile, that's a complete path
+      if (other.state.IsVisited(next.index)) {
+        const float cost = newCost + other.state.GetCost(next.index);
+        if (cost < m_BestCost) {
+          m_BestCost = cost;
+          m_Meeting = next.index;
+        }
+      }
+    }
+  }
+}
+
+template <typename Heuristic>
+Path Bidirectional<Heuristic>::ReconstructPath(TilePos start,
+                                               TilePos end) const {
+  const TilePos meeting = m_Map->IndexToTile(m_Meeting);
+  Path path = m_Forward.state.ReconstructPath(*m_Map, start, meeting);
+
+  // backward came-from links lead from the meeting tile to the goal
+  const size_t end_idx = m_Map->TileToIndex(end);
+  size_t cur = m_Meeting;
+  while (cur != end_idx) {
+    cur = m_Backward.state.GetCameFrom(cur);
+    path.push_back(m_Map->TileToWorld(m_Map->IndexToTile(cur)));
+  }
+  return path;
+}
+
+template class Bidirectional<heuristic::Grid>;
+template class Bidirectional<heuristic::Zero>;
+
+} // namespace pathfinder
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string_view>
+#include <type_traits>
+
+#include "astar.hpp"
+#include "base.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Bidirectional search, one frontier grows from the start and one from the
+// goal until they meet. Every step expands the smaller frontier.
+//
+// Entering a tile costs the cost of that tile, so the backward search
+// relaxes the edge from "previous" to "current" with the cost of "current".
+// Both sides use the balanced potential p(v) = (h(v, goal) - h(start, v)) / 2
+// (forward adds it, backward subtracts it), which keeps the heuristic
+// consistent in both directions. The best path seen through a tile reached
+// from both sides (mu) is final once the sum of both frontier minimums
+// reaches mu. With the zero heuristic this is plain bidirectional Dijkstra.
+template <typename Heuristic = heuristic::Grid>
+class Bidirectional final : public PathFinderBase {
+
+public:
+  Bidirectional(const Map *m, Heuristic h = {})
+      : PathFinderBase(m), m_Heuristic(h) {
+    if constexpr (requires { m_Heuristic.map; })
+      if (!m_Heuristic.map)
+        m_Heuristic.map = m;
+  }
+  const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override {
+    return m_Forward.state.GetMemoryUsage() + m_Forward.frontier.memory_usage() +
+           m_Backward.state.GetMemoryUsage() +
+           m_Backward.frontier.memory_usage();
+  }
+
+private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
+  static constexpr bool kIsDijkstra =
+      std::is_same_v<Heuristic, heuristic::Zero>;
+
+  struct Side {
+    explicit Side(float s) : sign(s) {}
+
+    // cost in the search state is g (from the start for the forward side,
+    // to the goal for the backward side), the frontier is ordered by
+    // g + sign * p
+    SearchState state;
+    utils::PriorityQueue<> frontier;
+    const float sign;
+  };
+
+  float Potential(TilePos tile) const;
+  // drop stale entries from the top of the frontier
+  void SkipStale(Side &side);
+  // expand the top of the frontier of "side", "other" is only read
+  void Expand(Side &side, const Side &other, bool forward);
+  Path ReconstructPath(TilePos start, TilePos end) const;
+
+  const std::string_view m_Name =
+      kIsDijkstra ? "Bidirectional Dijkstra" : "Bidirectional A*";
+  Heuristic m_Heuristic;
+  Side m_Forward{1.0f};
+  Side m_Backward{-1.0f};
+  TilePos m_Start;
+  TilePos m_End;
+  // best path found so far goes through this tile and costs m_BestCost
+  size_t m_Meeting = 0;
+  float m_BestCost = 0.0f;
+};
+
+using BidirectionalDijkstra = Bidirectional<heuristic::Zero>;
+using BidirectionalAStar = Bidirectional<heuristic::Grid>;
+
+// implemented in bidirectional.cpp
+extern template class Bidirectional<heuristic::Grid>;
+extern template class Bidirectional<heuristic::Zero>;
+
+} // namespace pathfinder
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "bounded_astar.hpp"
+
+#include "base.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+Path WeightedAStar::FindPath(WorldPos start_world, WorldPos end_world) {
+  using QueueEntry = utils::QueueEntry;
+
+  m_Suboptimality = 1.0f;
+  if (!m_Map)
+    return {};
+
+  const TilePos start = m_Map->WorldToTile(start_world);
+  const TilePos end = m_Map->WorldToTile(end_world);
+
+  if (!m_Map->IsTilePosValid(start) || !m_Map->IsTilePosValid(end))
+    return {};
+  if (start == end)
+    return {};
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(start, end))
+    return {};
+
+  // clear previous run
+  m_State.Reset(m_Map);
+  m_Closed.Reset(m_Map);
+  m_Frontier.clear();
+  m_Inconsistent.clear();
+
+  const size_t start_idx = m_Map->TileToIndex(start);
+  m_Frontier.push({m_Weight * m_Heuristic(start, end), start});
+  CountPush(m_Frontier.size());
+  m_State.Visit(start_idx, 0.0f, start_idx); // sentinel
+
+  bool found = false;
+  while (!m_Frontier.empty()) {
+    const QueueEntry current = m_Frontier.top();
+    if (current.tile == end) { // early exit
+      found = true;
+      break;
+    }
+    m_Frontier.pop();
+
+    const size_t current_idx = m_Map->TileToIndex(current.tile);
+    // skip stale entries, the tile was expanded with a lower cost already
+    if (m_Closed.IsVisited(current_idx))
+      continue;
+    m_Closed.Visit(current_idx, 0.0f, current_idx);
+    m_ExpandedNodes++;
+
+    const float current_cost = m_State.GetCost(current_idx);
+    for (const Neighbor &next : m_Map->GetNeighbors(current.tile)) {
+      const float newCost = current_cost + next.cost;
+
+      if (!m_State.IsVisited(next.index) ||
+          newCost < m_State.GetCost(next.index)) {
+        m_State.Visit(next.index, newCost, current_idx);
+        if (m_Closed.IsVisited(next.index)) {
+          m_Inconsistent.push_back(static_cast<uint32_t>(next.index));
+        } else {
+          m_Frontier.push(
+              {newCost + m_Weight * m_Heuristic(next.pos, end), next.pos});
+          CountPush(m_Frontier.size());
+        }
+      }
+    }
+  }
+  if (!found)
+    return {};
+
+  // smallest g + h of the open and the inconsistent tiles. The goal itself
+  // is open, the bound never exceeds its cost.
+  float lower_bound = std::numeric_limits<float>::infinity();
+  for (const QueueEntry &entry : m_Frontier.entries()) {
+    const size_t index = m_Map->TileToIndex(entry.tile);
+    if (!m_Closed.IsVisited(index))
+      lower_bound = std::min(lower_bound, m_State.GetCost(index) +
+                                              m_Heuristic(entry.tile, end));
+  }
+  for (uint32_t index : m_Inconsistent) {
+    lower_bound =
+        std::min(lower_bound, m_State.GetCost(index) +
+                                  m_Heuristic(m_Map->IndexToTile(index), end));
+  }
+  // the weight bounds the cost on its own, the lower bound may be too low
+  // while inconsistent tiles hold back their improvement
+  m_Suboptimality = std::min(
+      m_Weight, m_State.GetCost(m_Map->TileToIndex(end)) / lower_bound);
+
+  // reconstruct path
+  return m_State.ReconstructPath(*m_Map, start, end);
+}
+
+Path FocalAStar::FindPath(WorldPos start_world, WorldPos end_world) {
+  m_Suboptimality = 1.0f;
+  if (!m_Map)
+    return {};
+
+  const TilePos start = m_Map->WorldToTile(start_world);
+  const TilePos end = m_Map->WorldToTile(end_world);
+
+  if (!m_Map->IsTilePosValid(start) || !m_Map->IsTilePosValid(end))
+    return {};
+  if (start == end)
+    return {};
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(start, end))
+    return {};
+
+  // clear previous run
+  m_State.Reset(m_Map);
+  m_Closed.Reset(m_Map);
+  m_Open.clear();
+  m_Focal.clear();
+  m_FocalBound = 0.0f;
+  m_End = end;
+
+  const size_t start_idx = m_Map->TileToIndex(start);
+  const size_t end_idx = m_Map->TileToIndex(end);
+  m_State.Visit(start_idx, 0.0f, start_idx); // sentinel
+  Insert(start, start_idx, 0.0f);
+
+  // The smallest f never drops (a reached tile has at least the f of the
+  // expanded one with a consistent heuristic), so the focal list only
+  // grows. The largest one seen so far is kept against float rounding.
+  float lower_bound = 0.0f;
+  bool found = false;
+  while (!m_Open.empty()) {
+    lower_bound = std::max(lower_bound, m_Open.begin()->f);
+    const float bound = m_Weight * lower_bound;
+    if (bound > m_FocalBound) {
+      // the smallest f grew, admit the open tiles that are in bounds now
+      for (auto it = m_Open.upper_bound(
+               {m_FocalBound, std::numeric_limits<uint32_t>::max()});
+           it != m_Open.end() && it->f <= bound; ++it) {
+        if (m_Closed.IsVisited(it->index))
+          continue; // inconsistent
+        const float h = m_Heuristic(m_Map->IndexToTile(it->index), end);
+        m_Focal.insert({h, it->f, it->index});
+      }
+      m_FocalBound = bound;
+    }
+    if (m_Focal.empty()) {
+      // Only an inconsistent tile can have the smallest f now, and it holds
+      // the bound back for good. Reopen it, the only case where a tile is
+      // expanded twice.
+      const OpenEntry smallest = *m_Open.begin();
+      const float h = m_Heuristic(m_Map->IndexToTile(smallest.index), end);
+      m_Focal.insert({h, smallest.f, smallest.index});
+    }
+
+    const FocalEntry current = *m_Focal.begin();
+    if (current.index == end_idx) { // early exit
+      found = true;
+      break;
+    }
+    m_Focal.erase(m_Focal.begin());
+    m_Open.erase({current.f, current.index});
+    m_Closed.Visit(current.index, 0.0f, current.index);
+    m_ExpandedNodes++;
+
+    const TilePos current_tile = m_Map->IndexToTile(current.index);
+    const float current_cost = m_State.GetCost(current.index);
+    for (const Neighbor &next : m_Map->GetNeighbors(current_tile)) {
+      const float newCost = current_cost + next.cost;
+
+      if (!m_State.IsVisited(next.index)) {
+        m_State.Visit(next.index, newCost, current.index);
+        Insert(next.pos, next.index, newCost);
+      } else if (newCost < m_State.GetCost(next.index)) {
+        // an expanded tile goes back to the open list as inconsistent
+        Remove(next.pos, next.index, m_State.GetCost(next.index));
+        m_State.Visit(next.index, newCost, current.index);
+        Insert(next.pos, next.index, newCost);
+      }
+    }
+  }
+  if (!found)
+    return {};
+
+  // the goal was in bounds, at most weight times the bound
+  m_Suboptimality = std::min(m_Weight, m_State.GetCost(end_idx) / lower_bound);
+
+  // reconstruct path
+  return m_State.ReconstructPath(*m_Map, start, end);
+}
+
+size_t FocalAStar::GetMemoryUsage() const {
+  // the ordered sets give their nodes back, count their peak with the size
+  // of a red-black tree node (three pointers and the colour)
+  constexpr size_t tree_node = 4 * sizeof(void *);
+  return m_State.GetMemoryUsage() + m_Closed.GetMemoryUsage() +
+         m_PeakFrontier *
+             (sizeof(OpenEntry) + sizeof(FocalEntry) + 2 * tree_node);
+}
+
+void FocalAStar::Insert(TilePos tile, size_t index, float g) {
+  const float h = m_Heuristic(tile, m_End);
+  const auto idx = static_cast<uint32_t>(index);
+  m_Open.insert({g + h, idx});
+  CountPush(m_Open.size());
+  if (g + h <= m_FocalBound && !m_Closed.IsVisited(index))
+    m_Focal.insert({h, g + h, idx});
+}
+
+void FocalAStar::Remove(TilePos tile, size_t index, float g) {
+  // f is computed the same way as in Insert, so the keys match exactly
+  const float h = m_Heuristic(tile, m_End);
+  const auto idx = static_cast<uint32_t>(index);
+  m_Open.erase({g + h, idx});
+  m_Focal.erase({h, g + h, idx});
+}
+
+} // namespace pathfinder
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "astar.hpp"
+#include "base.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Bounded-suboptimal variants of A*: the path costs at most weight times the
+// optimal cost, in exchange for fewer expansions. The weight can be changed
+// between queries, 1 makes both of them optimal.
+//
+// Expanded tiles are not reopened. A tile reached cheaper after its
+// expansion keeps the lower cost and becomes inconsistent (as in ARA*,
+// Likhachev et al.), reopening it would cascade through everything expanded
+// from it. Some open or inconsistent tile of an optimal path always has its
+// optimal cost, so the smallest g + h of those tiles is a lower bound of the
+// optimal cost. The cost of the returned path divided by that bound, or the
+// weight if it is smaller, is reported as the suboptimality of the path. It
+// is often close to 1 even for large weights.
+class BoundedAStarBase : public PathFinderBase {
+public:
+  static constexpr float kDefaultWeight = 1.5f;
+
+  BoundedAStarBase(const Map *m, float weight) : PathFinderBase(m) {
+    m_Heuristic.map = m;
+    SetWeight(weight);
+  }
+
+  // weights below 1 are raised to 1
+  void SetWeight(float weight) { m_Weight = std::max(weight, 1.0f); }
+  float GetWeight() const { return m_Weight; }
+
+  // How much more than the optimum the last path may cost at most: its cost
+  // divided by the lower bound proven by the search, in [1, weight].
+  // 1 when no path was found.
+  float GetSuboptimality() const override { return m_Suboptimality; }
+
+protected:
+  float m_Weight = kDefaultWeight;
+  float m_Suboptimality = 1.0f;
+  heuristic::Grid m_Heuristic;
+  // cost in the search state is g
+  SearchState m_State;
+  // expanded tiles
+  SearchState m_Closed;
+};
+
+// Weighted A* (Pohl), the frontier is ordered by g + weight * h
+class WeightedAStar final : public BoundedAStarBase {
+
+public:
+  WeightedAStar(const Map *m, float weight = kDefaultWeight)
+      : BoundedAStarBase(m, weight) {}
+  const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override {
+    return m_State.GetMemoryUsage() + m_Closed.GetMemoryUsage() +
+           m_Frontier.memory_usage() + utils::memory_usage(m_Inconsistent);
+  }
+
+private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
+  const std::string_view m_Name = "Weighted A*";
+  utils::PriorityQueue<> m_Frontier;
+  // expanded tiles that were reached cheaper later, may repeat
+  std::vector<uint32_t> m_Inconsistent;
+};
+
+// Focal search, A*epsilon (Pearl & Kim).
+//
+// The open list is ordered by f = g + h like in A*, inconsistent tiles stay
+// in it to keep its smallest f a lower bound. The focal list holds the open
+// tiles with f <= weight * (smallest f) that can still be expanded, the
+// search always expands the focal tile closest to the goal (smallest h), so
+// it runs almost as straight as greedy best-first search while the weight
+// still bounds the cost. Both lists are ordered sets, tiles that are reached
+// cheaper are removed and inserted again, and tiles move to the focal list
+// when the smallest f grows.
+class FocalAStar final : public BoundedAStarBase {
+
+public:
+  FocalAStar(const Map *m, float weight = kDefaultWeight)
+      : BoundedAStarBase(m, weight) {}
+  const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override;
+
+private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
+  struct OpenEntry {
+    float f;
+    uint32_t index;
+
+    auto operator<=>(const OpenEntry &) const = default;
+  };
+
+  struct FocalEntry {
+    float h;
+    float f;
+    uint32_t index;
+
+    auto operator<=>(const FocalEntry &) const = default;
+  };
+
+  // add a tile to the open list, and to the focal list if it is in bounds
+  // and not expanded yet
+  void Insert(TilePos tile, size_t index, float g);
+  // remove the entries of a tile with the given g, if it has any
+  void Remove(TilePos tile, size_t index, float g);
+
+  const std::string_view m_Name = "Focal A*";
+  TilePos m_End;
+  std::set<OpenEntry> m_Open;
+  std::set<FocalEntry> m_Focal;
+  // open tiles with f up to this are in the focal list
+  float m_FocalBound = 0.0f;
+};
+
+} // namespace pathfinder
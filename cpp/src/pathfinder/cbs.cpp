@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "cbs.hpp"
+
+#include "cooperative.hpp"
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+namespace {
+
+// The low-level searches run until the goal, never up to the window. They
+// always end: the goal is reachable and the constraints only cover a
+// finite number of ticks.
+constexpr uint32_t kNoWindow = std::numeric_limits<uint32_t>::max() / 2;
+
+struct Conflict {
+  uint32_t first;
+  uint32_t second;
+  // for a swap the tick the two moves start at
+  uint32_t tick;
+  bool is_swap;
+};
+
+TilePos At(const SpaceTimePath &path, size_t tick) {
+  return path[std::min(tick, path.size() - 1)];
+}
+
+// Calls on_conflict with the conflicts of the paths ordered by tick, until it
+// returns false.
+template <typename F>
+void ScanConflicts(std::span<const SpaceTimePath> paths, F &&on_conflict) {
+  size_t ticks = 0;
+  for (const SpaceTimePath &path : paths)
+    ticks = std::max(ticks, path.size());
+  auto key = [](TilePos tile) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(tile.x())) << 32 |
+           static_cast<uint32_t>(tile.y());
+  };
+
+  // (tile, agent) of every agent at the tick, sorted by tile
+  using Cell = std::pair<uint64_t, uint32_t>;
+  std::vector<Cell> cells;
+  for (size_t tick = 0; tick < ticks; tick++) {
+    cells.clear();
+    for (uint32_t i = 0; i < paths.size(); i++) {
+      if (!paths[i].empty())
+        cells.emplace_back(key(At(paths[i], tick)), i);
+    }
+    std::ranges::sort(cells);
+    for (size_t a = 0; a < cells.size(); a++) {
+      for (size_t b = a + 1;
+           b < cells.size() && cells[b].first == cells[a].first; b++) {
+        if (!on_conflict(Conflict{cells[a].second, cells[b].second,
+                                  static_cast<uint32_t>(tick), false}))
+          return;
+      }
+    }
+    if (tick == 0)
+      continue;
+
+    // agents that came from the tile another agent moved to
+    for (uint32_t i = 0; i < paths.size(); i++) {
+      if (paths[i].empty())
+        continue;
+      const TilePos from = At(paths[i], tick - 1);
+      const TilePos to = At(paths[i], tick);
+      if (from == to)
+        continue;
+      auto range = std::ranges::equal_range(cells, key(from), {}, &Cell::first);
+      for (const auto &[tile, j] : range) {
+        if (j > i && At(paths[j], tick - 1) == to &&
+            !on_conflict(
+                Conflict{i, j, static_cast<uint32_t>(tick - 1), true}))
+          return;
+      }
+    }
+  }
+}
+
+std::optional<Conflict> FirstConflict(std::span<const SpaceTimePath> paths) {
+  std::optional<Conflict> first;
+  ScanConflicts(paths, [&first](const Conflict &conflict) {
+    first = conflict;
+    return false;
+  });
+  return first;
+}
+
+} // namespace
+
+size_t CountConflicts(std::span<const SpaceTimePath> paths) {
+  size_t conflicts = 0;
+  ScanConflicts(paths, [&conflicts](const Conflict &) {
+    conflicts++;
+    return true;
+  });
+  return conflicts;
+}
+
+ConflictBasedSearch::ConflictBasedSearch(const Map *map)
+    : ConflictBasedSearch(map, Limits{}) {}
+
+ConflictBasedSearch::ConflictBasedSearch(const Map *map, Limits limits)
+    : m_Map(map), m_Limits(limits), m_Search(map) {}
+
+ConflictBasedSearch::Result
+ConflictBasedSearch::Solve(std::span<const AgentQuery> agents) {
+  using Clock = std::chrono::steady_clock;
+  const auto t0 = Clock::now();
+  // the low-level searches give up at the time limit too, a single one can
+  // take longer than the limit on a large map
+  m_Search.SetDeadline(t0 + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double, std::milli>(
+                                    m_Limits.max_time_ms)));
+
+  // clear previous run
+  m_ExpandedNodes = 0;
+  m_Nodes.clear();
+  m_Open.clear();
+  m_RootPaths.clear();
+  m_RootCosts.clear();
+
+  Result result;
+  if (!m_Map)
+    return result;
+  // two agents can't both stay on a goal, or start on the same tile
+  std::unordered_set<size_t> starts;
+  std::unordered_set<size_t> goals;
+  for (const AgentQuery &agent : agents) {
+    if (!m_Map->IsTilePosValid(agent.start) ||
+        !m_Map->IsTilePosValid(agent.goal))
+      return result;
+    if (!starts.insert(m_Map->TileToIndex(agent.start)).second ||
+        !goals.insert(m_Map->TileToIndex(agent.goal)).second)
+      return result;
+  }
+
+  // root, every agent planned alone
+  const ReservationTable none;
+  float root_cost = 0.0f;
+  for (const AgentQuery &agent : agents) {
+    m_RootPaths.push_back(
+        m_Search.FindPath(agent.start, agent.goal, none, kNoWindow));
+    m_ExpandedNodes += m_Search.GetExpandedNodeCount();
+    if (m_RootPaths.back().empty()) {
+      if (m_Search.HasTimedOut())
+        result.status = Status::TIME_LIMIT;
+      return result;
+    }
+    m_RootCosts.push_back(PathCost(m_RootPaths.back()));
+    root_cost += m_RootCosts.back();
+  }
+  m_Nodes.push_back(
+      {kRoot, {}, {}, 0.0f, root_cost, CountConflicts(m_RootPaths)});
+  m_Open.push({root_cost, m_Nodes.back().conflicts, kRoot});
+
+  // the node with the fewest conflicts, returned if the limits are hit
+  uint32_t best = kRoot;
+  std::vector<SpaceTimePath> paths;
+  std::vector<float> costs;
+  while (!m_Open.empty()) {
+    const Entry current = m_Open.top();
+    m_Open.pop();
+    CollectPaths(current.node, paths, costs);
+    const auto conflict = FirstConflict(paths);
+    if (!conflict) {
+      result.status = Status::SOLVED;
+      result.paths = std::move(paths);
+      result.cost = current.cost;
+      return result;
+    }
+
+    // a node has two children at most
+    if (m_Nodes.size() + 2 > m_Limits.max_nodes) {
+      result.status = Status::NODE_LIMIT;
+      break;
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        Clock::now() - t0;
+    if (elapsed.count() > m_Limits.max_time_ms) {
+      result.status = Status::TIME_LIMIT;
+      break;
+    }
+
+    // one of the two agents has to give way
+    const size_t first_child = m_Nodes.size();
+    bool timed_out = false;
+    for (const uint32_t agent : {conflict->first, conflict->second}) {
+      const SpaceTimePath &path = paths[agent];
+      const auto tile =
+          static_cast<uint32_t>(m_Map->TileToIndex(At(path, conflict->tick)));
+      Constraint constraint{agent, tile, tile, conflict->tick, false};
+      if (conflict->is_swap) {
+        constraint.tile = static_cast<uint32_t>(
+            m_Map->TileToIndex(At(path, conflict->tick + 1)));
+        constraint.is_move = true;
+      }
+      Branch(current.node, constraint, agents[agent], paths, costs);
+      timed_out = timed_out || m_Search.HasTimedOut();
+    }
+    for (auto i = static_cast<uint32_t>(first_child); i < m_Nodes.size(); i++) {
+      if (m_Nodes[i].conflicts < m_Nodes[best].conflicts)
+        best = i;
+    }
+    if (timed_out) {
+      result.status = Status::TIME_LIMIT;
+      break;
+    }
+  }
+
+  CollectPaths(best, paths, costs);
+  result.paths = std::move(paths);
+  result.cost = m_Nodes[best].cost;
+  result.conflicts = m_Nodes[best].conflicts;
+  return result;
+}
+
+void ConflictBasedSearch::CollectPaths(uint32_t node,
+                                       std::vector<SpaceTimePath> &paths,
+                                       std::vector<float> &costs) const {
+  paths = m_RootPaths;
+  costs = m_RootCosts;
+  // the path closest to the node wins
+  std::vector<uint8_t> done(paths.size(), 0);
+  for (uint32_t i = node; i != kRoot; i = m_Nodes[i].parent) {
+    const Node &n = m_Nodes[i];
+    if (done[n.constraint.agent])
+      continue;
+    done[n.constraint.agent] = 1;
+    paths[n.constraint.agent] = n.path;
+    costs[n.constraint.agent] = n.path_cost;
+  }
+}
+
+void ConflictBasedSearch::CollectConstraints(
+    uint32_t node, uint32_t agent, ReservationTable &constraints) const {
+  for (uint32_t i = node; i != kRoot; i = m_Nodes[i].parent) {
+    const Constraint &c = m_Nodes[i].constraint;
+    if (c.agent != agent)
+      continue;
+    // the space-time search refuses a move whose opposite is reserved
+    if (c.is_move)
+      constraints.ReserveMove(c.tile, c.from, c.tick);
+    else
+      constraints.Reserve(c.tile, c.tick);
+  }
+}
+
+void ConflictBasedSearch::Branch(uint32_t node, const Constraint &constraint,
+                                 const AgentQuery &agent,
+                                 std::vector<SpaceTimePath> &paths,
+                                 const std::vector<float> &costs) {
+  ReservationTable constraints;
+  CollectConstraints(node, constraint.agent, constraints);
+  if (constraint.is_move)
+    constraints.ReserveMove(constraint.tile, constraint.from, constraint.tick);
+  else
+    constraints.Reserve(constraint.tile, constraint.tick);
+
+  SpaceTimePath path =
+      m_Search.FindPath(agent.start, agent.goal, constraints, kNoWindow);
+  m_ExpandedNodes += m_Search.GetExpandedNodeCount();
+  if (path.empty())
+    return;
+
+  // count the conflicts of the child's plan, then give the plan back
+  const float path_cost = PathCost(path);
+  std::swap(paths[constraint.agent], path);
+  const size_t conflicts = CountConflicts(paths);
+  std::swap(paths[constraint.agent], path);
+
+  const float cost = m_Nodes[node].cost - costs[constraint.agent] + path_cost;
+  const auto index = static_cast<uint32_t>(m_Nodes.size());
+  m_Nodes.push_back(
+      {node, constraint, std::move(path), path_cost, cost, conflicts});
+  m_Open.push({cost, conflicts, index});
+}
+
+float ConflictBasedSearch::PathCost(const SpaceTimePath &path) const {
+  // the same costs as the space-time search, a wait costs the tile
+  float cost = 0.0f;
+  for (size_t i = 1; i < path.size(); i++) {
+    if (path[i] == path[i - 1]) {
+      cost += m_Map->GetCost(path[i]);
+      continue;
+    }
+    for (const Neighbor &next : m_Map->GetNeighbors(path[i - 1])) {
+      if (next.pos == path[i]) {
+        cost += next.cost;
+        break;
+      }
+    }
+  }
+  return cost;
+}
+
+} // namespace pathfinder
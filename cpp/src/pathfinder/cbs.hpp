@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "cooperative.hpp"
+#include "utils.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Conflict-Based Search (Sharon et al.), optimal joint plans for a few tens
+// of agents.
+//
+// The high level searches a tree of constraints, cheapest sum of path costs
+// first. Every node holds one path per agent, planned alone by the low-level
+// space-time A* under the constraints of that agent. The first conflict of
+// the node's plan (two agents on one tile at a tick, or swapping places)
+// splits it in two: one child forbids the cell or the move to the first
+// agent, the other to the second one, and only that agent is planned again.
+// A node without conflicts is an optimal plan. Nodes keep only the path they
+// changed, the full plan is collected from their ancestors.
+//
+// The tree can grow exponentially with the number of conflicts, so the
+// search gives up after a number of nodes or a time limit and returns the
+// plan with the fewest conflicts seen, the caller can fall back to
+// prioritized planning (CooperativePlanner) with it. The low-level searches
+// stop at the time limit as well, if that happens before the root plan is
+// complete no paths are returned.
+class ConflictBasedSearch {
+public:
+  struct Limits {
+    // constraint tree nodes generated, the root included
+    size_t max_nodes = 10000;
+    double max_time_ms = 100.0;
+  };
+
+  enum class Status { SOLVED, NODE_LIMIT, TIME_LIMIT, NO_SOLUTION };
+
+  struct Result {
+    Status status = Status::NO_SOLUTION;
+    // one path per agent, free of conflicts if solved
+    std::vector<SpaceTimePath> paths;
+    // sum of the path costs, waits included
+    float cost = 0.0f;
+    // conflicts left in the paths, 0 if solved
+    size_t conflicts = 0;
+  };
+
+  ConflictBasedSearch(const Map *map);
+  ConflictBasedSearch(const Map *map, Limits limits);
+
+  // Plans all agents from tick 0, agents stay on their goal after arrival.
+  // No solution if two agents share a start or a goal, or a goal can't be
+  // reached.
+  Result Solve(std::span<const AgentQuery> agents);
+
+  void SetLimits(Limits limits) { m_Limits = limits; }
+  const Limits &GetLimits() const { return m_Limits; }
+  // constraint tree nodes generated by the last Solve call
+  size_t GetNodeCount() const { return m_Nodes.size(); }
+  // expanded by the low-level searches of the last Solve call
+  size_t GetExpandedNodeCount() const { return m_ExpandedNodes; }
+
+private:
+  static constexpr uint32_t kRoot = 0;
+
+  struct Constraint {
+    uint32_t agent;
+    uint32_t tile;
+    // for a move constraint the tile it leaves, the move ends on "tile"
+    uint32_t from;
+    uint32_t tick;
+    bool is_move;
+  };
+
+  struct Node {
+    uint32_t parent;
+    Constraint constraint;
+    // the path of constraint.agent planned under the new constraint
+    SpaceTimePath path;
+    float path_cost;
+    float cost;
+    size_t conflicts;
+  };
+
+  struct Entry {
+    float cost;
+    size_t conflicts;
+    uint32_t node;
+
+    // cheapest on top, on ties the node closer to a plan without conflicts
+    bool operator>(const Entry &o) const noexcept {
+      return cost > o.cost || (cost == o.cost && conflicts > o.conflicts);
+    }
+  };
+
+  // the plan of a node, collected from it and its ancestors
+  void CollectPaths(uint32_t node, std::vector<SpaceTimePath> &paths,
+                    std::vector<float> &costs) const;
+  // the constraints of one agent on the way from the node to the root
+  void CollectConstraints(uint32_t node, uint32_t agent,
+                          ReservationTable &constraints) const;
+  // Adds the child of the node with one more constraint, unless the agent
+  // has no path under it. "paths" and "costs" are the plan of the node.
+  void Branch(uint32_t node, const Constraint &constraint,
+              const AgentQuery &agent, std::vector<SpaceTimePath> &paths,
+              const std::vector<float> &costs);
+  float PathCost(const SpaceTimePath &path) const;
+
+  const Map *m_Map;
+  Limits m_Limits;
+  SpaceTimeAStar m_Search;
+  size_t m_ExpandedNodes = 0;
+  std::vector<Node> m_Nodes;
+  // paths of the root, planned without constraints
+  std::vector<SpaceTimePath> m_RootPaths;
+  std::vector<float> m_RootCosts;
+  utils::PriorityQueue<Entry> m_Open;
+};
+
+// Pairs of agents on one tile at a tick or swapping places, counted once per
+// tick. Agents stay on their last tile after their path ends.
+size_t CountConflicts(std::span<const SpaceTimePath> paths);
+
+} // namespace pathfinder
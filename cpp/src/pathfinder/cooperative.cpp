@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "cooperative.hpp"
+
+#include "flow_field.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+void ReservationTable::Reserve(size_t tile, uint32_t tick) {
+  m_Cells.insert(CellKey(tile, tick));
+  auto [it, inserted] =
+      m_LastTick.try_emplace(static_cast<uint32_t>(tile), tick);
+  if (!inserted)
+    it->second = std::max(it->second, tick);
+}
+
+void ReservationTable::ReserveMove(size_t from, size_t to, uint32_t tick) {
+  m_Moves.insert(
+      {static_cast<uint32_t>(from), static_cast<uint32_t>(to), tick});
+}
+
+void ReservationTable::Hold(size_t tile, uint32_t from_tick) {
+  auto [it, inserted] =
+      m_Held.try_emplace(static_cast<uint32_t>(tile), from_tick);
+  if (!inserted)
+    it->second = std::min(it->second, from_tick);
+}
+
+void ReservationTable::ReservePath(const Map &map, const SpaceTimePath &path,
+                                   uint32_t start_tick, uint32_t ticks) {
+  if (path.empty())
+    return;
+  const size_t last = std::min<size_t>(path.size() - 1, ticks);
+  for (size_t i = 0; i <= last; i++) {
+    const auto tick = static_cast<uint32_t>(start_tick + i);
+    Reserve(map.TileToIndex(path[i]), tick);
+    if (i > 0)
+      ReserveMove(map.TileToIndex(path[i - 1]), map.TileToIndex(path[i]),
+                  tick - 1);
+  }
+  if (last == path.size() - 1)
+    Hold(map.TileToIndex(path.back()),
+         static_cast<uint32_t>(start_tick + last));
+}
+
+void ReservationTable::Clear() {
+  m_Cells.clear();
+  m_Moves.clear();
+  m_LastTick.clear();
+  m_Held.clear();
+}
+
+bool ReservationTable::IsReserved(size_t tile, uint32_t tick) const {
+  if (auto it = m_Held.find(static_cast<uint32_t>(tile));
+      it != m_Held.end() && it->second <= tick)
+    return true;
+  return m_Cells.contains(CellKey(tile, tick));
+}
+
+bool ReservationTable::IsMoveReserved(size_t from, size_t to,
+                                      uint32_t tick) const {
+  return m_Moves.contains(
+      {static_cast<uint32_t>(from), static_cast<uint32_t>(to), tick});
+}
+
+bool ReservationTable::IsReservedAfter(size_t tile, uint32_t tick) const {
+  const auto key = static_cast<uint32_t>(tile);
+  if (m_Held.contains(key))
+    return true;
+  auto it = m_LastTick.find(key);
+  return it != m_LastTick.end() && it->second > tick;
+}
+
+std::size_t
+ReservationTable::MoveHash::operator()(const Move &move) const noexcept {
+  // same mixing as PathCache::KeyHash
+  std::size_t seed = move.from;
+  seed ^= move.to + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  seed ^= move.tick + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  return seed;
+}
+
+SpaceTimeAStar::SpaceTimeAStar(const Map *map,
+                               std::shared_ptr<FlowFieldCache> fields)
+    : m_Map(map), m_Fields(fields ? std::move(fields)
+                                   : std::make_shared<FlowFieldCache>(map)) {}
+
+void SpaceTimeAStar::Push(size_t tile, uint32_t tick, float g,
+                          uint32_t parent, float h) {
+  const uint64_t key = static_cast<uint64_t>(tile) << 32 | tick;
+  auto [it, inserted] =
+      m_States.try_emplace(key, static_cast<uint32_t>(m_Nodes.size()));
+  if (inserted) {
+    m_Nodes.push_back({static_cast<uint32_t>(tile), tick, g, parent, false});
+  } else {
+    Node &node = m_Nodes[it->second];
+    if (node.closed || node.g <= g)
+      return;
+    node.g = g;
+    node.parent = parent;
+  }
+  m_Frontier.push({g + h, g, it->second});
+}
+
+SpaceTimePath SpaceTimeAStar::FindPath(TilePos start, TilePos goal,
+                                       const ReservationTable &reserved,
+                                       uint32_t window, uint32_t start_tick) {
+  m_ExpandedNodes = 0;
+  m_TimedOut = false;
+  if (!m_Map || !m_Map->IsPassable(start) || !m_Map->IsPassable(goal))
+    return {};
+  if (!m_Map->IsReachable(start, goal))
+    return {};
+
+  // clear previous run
+  m_Nodes.clear();
+  m_States.clear();
+  m_Frontier.clear();
+
+  // exact distance of every tile to the goal, shared with other agents
+  // heading there
+  const auto field = m_Fields->Get(goal);
+  const size_t goal_idx = m_Map->TileToIndex(goal);
+  const uint32_t end_tick = start_tick + window;
+  Push(m_Map->TileToIndex(start), start_tick, 0.0f, kNoParent,
+       field->GetCost(start));
+
+  uint32_t found = kNoParent;
+  while (!m_Frontier.empty()) {
+    const Entry current = m_Frontier.top();
+    m_Frontier.pop();
+    Node &node = m_Nodes[current.node];
+    if (node.closed || current.g > node.g) // stale entry
+      continue;
+    node.closed = true;
+    m_ExpandedNodes++;
+    if (m_ExpandedNodes % kDeadlineInterval == 0 &&
+        std::chrono::steady_clock::now() > m_Deadline) {
+      m_TimedOut = true;
+      return {};
+    }
+
+    // stay at the goal only if nobody passes through it later
+    if ((node.tile == goal_idx &&
+         !reserved.IsReservedAfter(goal_idx, node.tick)) ||
+        node.tick == end_tick) {
+      found = current.node;
+      break;
+    }
+
+    const TilePos tile = m_Map->IndexToTile(node.tile);
+    const uint32_t tick = node.tick;
+    const float g = node.g;
+    const uint32_t parent = current.node;
+    // m_Nodes grows in Push, don't use "node" below
+    if (!reserved.IsReserved(node.tile, tick + 1))
+      Push(node.tile, tick + 1, g + m_Map->GetCost(tile), parent,
+           field->GetCost(tile));
+    for (const Neighbor &next : m_Map->GetNeighbors(tile)) {
+      if (reserved.IsReserved(next.index, tick + 1) ||
+          reserved.IsMoveReserved(next.index, m_Map->TileToIndex(tile), tick))
+        continue;
+      Push(next.index, tick + 1, g + next.cost, parent,
+           field->GetCost(next.pos));
+    }
+  }
+  if (found == kNoParent)
+    return {};
+
+  // reconstruct the path, then follow the field past the window
+  SpaceTimePath path;
+  for (uint32_t i = found; i != kNoParent; i = m_Nodes[i].parent)
+    path.push_back(m_Map->IndexToTile(m_Nodes[i].tile));
+  std::reverse(path.begin(), path.end());
+  while (path.back() != goal) {
+    auto next = field->GetNextTile(path.back());
+    if (!next)
+      break;
+    path.push_back(*next);
+  }
+  return path;
+}
+
+CooperativePlanner::CooperativePlanner(const Map *map, uint32_t window)
+    : m_Map(map), m_Window(std::max(window, 1u)), m_Search(map) {}
+
+std::vector<SpaceTimePath>
+CooperativePlanner::Plan(std::span<const AgentQuery> agents,
+                         std::span<const TilePos> obstacles) {
+  m_ExpandedNodes = 0;
+  std::vector<SpaceTimePath> paths(agents.size());
+  if (!m_Map)
+    return paths;
+
+  // agents in priority order, the first one is planned first
+  std::vector<size_t> order(agents.size());
+  std::iota(order.begin(), order.end(), 0);
+  size_t restarts = 0;
+  size_t k = 0;
+  auto restart = [&]() {
+    m_Reserved.Clear();
+    for (const TilePos tile : obstacles) {
+      if (m_Map->IsTilePosValid(tile))
+        m_Reserved.Hold(m_Map->TileToIndex(tile), 0);
+    }
+    // agents stand on their start at tick 0, nobody else can be there
+    for (const AgentQuery &agent : agents) {
+      if (m_Map->IsTilePosValid(agent.start))
+        m_Reserved.Reserve(m_Map->TileToIndex(agent.start), 0);
+    }
+    k = 0;
+  };
+
+  restart();
+  while (k < order.size()) {
+    const AgentQuery &agent = agents[order[k]];
+    SpaceTimePath &path = paths[order[k]];
+    path = m_Search.FindPath(agent.start, agent.goal, m_Reserved, m_Window);
+    m_ExpandedNodes += m_Search.GetExpandedNodeCount();
+    if (!path.empty()) {
+      m_Reserved.ReservePath(*m_Map, path, 0, m_Window);
+      k++;
+      continue;
+    }
+    if (!m_Map->IsPassable(agent.start) || !m_Map->IsPassable(agent.goal) ||
+        !m_Map->IsReachable(agent.start, agent.goal)) {
+      k++;
+      continue;
+    }
+
+    // Boxed in by the agents planned before, usually one of them walks into
+    // its start at the first tick. It goes ahead of them and the planning
+    // starts over, at most once per agent.
+    if (k > 0 && restarts < agents.size()) {
+      std::rotate(order.begin(), order.begin() + k, order.begin() + k + 1);
+      restarts++;
+      restart();
+      continue;
+    }
+    // take the path it would take alone and leave it to the next replanning
+    auto field = m_Search.GetFlowFields().Get(agent.goal);
+    path.push_back(agent.start);
+    while (auto next = field->GetNextTile(path.back())) {
+      if (*next == path.back())
+        break;
+      path.push_back(*next);
+    }
+    k++;
+  }
+  return paths;
+}
+
+std::vector<TilePos> GoalsAround(const Map &map, TilePos target,
+                                 size_t count) {
+  std::vector<TilePos> goals;
+  if (!map.IsPassable(target) || count == 0)
+    return goals;
+
+  // breadth first from the target, the order of the steps is fixed so the
+  // goals are too
+  std::vector<uint8_t> seen(map.GetTileCount(), 0);
+  std::deque<TilePos> frontier{target};
+  seen[map.TileToIndex(target)] = 1;
+  while (!frontier.empty() && goals.size() < count) {
+    const TilePos tile = frontier.front();
+    frontier.pop_front();
+    goals.push_back(tile);
+    for (const Neighbor &next : map.GetNeighbors(tile)) {
+      if (!seen[next.index]) {
+        seen[next.index] = 1;
+        frontier.push_back(next.pos);
+      }
+    }
+  }
+  return goals;
+}
+
+} // namespace pathfinder
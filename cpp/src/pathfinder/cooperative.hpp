@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "flow_field.hpp"
+#include "utils.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// tile of an agent at every tick, the first one is the start
+using SpaceTimePath = std::vector<TilePos>;
+
+// Space-time cells (tile, tick) and moves taken by agents planned so far.
+//
+// Tiles are flat Map::TileToIndex indices. An agent that stays at its goal
+// holds the tile from its arrival on, for every later tick.
+class ReservationTable {
+public:
+  void Reserve(size_t tile, uint32_t tick);
+  // the move from one tile to another between tick and tick + 1
+  void ReserveMove(size_t from, size_t to, uint32_t tick);
+  void Hold(size_t tile, uint32_t from_tick);
+  // Reserves the cells of the first "ticks" moves of the path, starting at
+  // start_tick, and the moves between them. If the path ends in that range
+  // its last tile is held from then on.
+  void ReservePath(const Map &map, const SpaceTimePath &path,
+                   uint32_t start_tick, uint32_t ticks);
+  void Clear();
+
+  bool IsReserved(size_t tile, uint32_t tick) const;
+  bool IsMoveReserved(size_t from, size_t to, uint32_t tick) const;
+  // true if the tile is reserved or held at any tick after "tick"
+  bool IsReservedAfter(size_t tile, uint32_t tick) const;
+  size_t GetSize() const { return m_Cells.size() + m_Moves.size(); }
+
+private:
+  struct Move {
+    uint32_t from;
+    uint32_t to;
+    uint32_t tick;
+
+    bool operator==(const Move &) const = default;
+  };
+  struct MoveHash {
+    std::size_t operator()(const Move &move) const noexcept;
+  };
+
+  static uint64_t CellKey(size_t tile, uint32_t tick) {
+    return static_cast<uint64_t>(tile) << 32 | tick;
+  }
+
+  std::unordered_set<uint64_t> m_Cells;
+  std::unordered_set<Move, MoveHash> m_Moves;
+  // last reserved tick of every tile that has a reservation
+  std::unordered_map<uint32_t, uint32_t> m_LastTick;
+  // first tick of tiles held for good
+  std::unordered_map<uint32_t, uint32_t> m_Held;
+};
+
+// A* over (tile, tick) states, every tick the agent moves to a neighbour or
+// waits. Cells and moves in the reservation table are avoided, a move into
+// a tile is also refused if someone else comes the opposite way at the same
+// tick (the two would swap places through each other).
+//
+// The heuristic is the exact distance to the goal ignoring other agents,
+// read from a flow field of the goal (the reverse search of WHCA*), so only
+// the detours around reservations cost expansions. A wait costs as much as
+// a straight step onto the tile the agent stands on.
+class SpaceTimeAStar {
+public:
+  SpaceTimeAStar(const Map *map,
+                 std::shared_ptr<FlowFieldCache> fields = nullptr);
+
+  // Path from start_tick on. The search stops at the goal once nobody else
+  // enters it later, or at the best state after "window" ticks, and the
+  // rest of the path follows the flow field without reservations. Empty if
+  // the goal can't be reached or every way out of the start is reserved.
+  SpaceTimePath FindPath(TilePos start, TilePos goal,
+                         const ReservationTable &reserved, uint32_t window,
+                         uint32_t start_tick = 0);
+
+  // Searches still running at the deadline give up with an empty path, the
+  // clock is read every few hundred expansions. No deadline by default.
+  void SetDeadline(std::chrono::steady_clock::time_point deadline) {
+    m_Deadline = deadline;
+  }
+  // true if the last search gave up at the deadline
+  bool HasTimedOut() const { return m_TimedOut; }
+
+  size_t GetExpandedNodeCount() const { return m_ExpandedNodes; }
+  FlowFieldCache &GetFlowFields() { return *m_Fields; }
+
+private:
+  static constexpr uint32_t kNoParent = std::numeric_limits<uint32_t>::max();
+  static constexpr size_t kDeadlineInterval = 256;
+
+  struct Node {
+    uint32_t tile;
+    uint32_t tick;
+    float g;
+    uint32_t parent;
+    bool closed;
+  };
+
+  struct Entry {
+    float f;
+    float g;
+    uint32_t node;
+
+    // smallest f on top, on ties the deeper node as it is closer to the goal
+    bool operator>(const Entry &o) const noexcept {
+      return f > o.f || (f == o.f && g < o.g);
+    }
+  };
+
+  // add a state unless it's known with a lower cost already
+  void Push(size_t tile, uint32_t tick, float g, uint32_t parent, float h);
+
+  const Map *m_Map;
+  std::shared_ptr<FlowFieldCache> m_Fields;
+  std::chrono::steady_clock::time_point m_Deadline =
+      std::chrono::steady_clock::time_point::max();
+  bool m_TimedOut = false;
+  size_t m_ExpandedNodes = 0;
+  std::vector<Node> m_Nodes;
+  // node of every (tile, tick) state seen in the current search
+  std::unordered_map<uint64_t, uint32_t> m_States;
+  utils::PriorityQueue<Entry> m_Frontier;
+};
+
+struct AgentQuery {
+  TilePos start;
+  TilePos goal;
+};
+
+// Windowed Hierarchical Cooperative A* (Silver, "Cooperative Pathfinding").
+//
+// Agents are planned one after the other in priority order, each with a
+// space-time search that avoids the cells the agents before it reserved in
+// the first "window" ticks, and then reserves its own. The paths are free of
+// collisions inside the window, past it they follow the flow fields and the
+// agents should plan again after about half a window.
+class CooperativePlanner {
+public:
+  static constexpr uint32_t kDefaultWindow = 16;
+
+  CooperativePlanner(const Map *map, uint32_t window = kDefaultWindow);
+
+  // Plans all agents from tick 0, the first one has the highest priority.
+  // Reservations of earlier calls are dropped. An agent without a path
+  // around the agents before it moves ahead of them and the planning starts
+  // over, if that keeps failing it gets the path it would take alone
+  // (unreserved). An agent whose goal can't be reached gets an empty path.
+  // Obstacles are tiles taken by others for good (e.g. idle units that are
+  // not planned), nobody enters them.
+  std::vector<SpaceTimePath> Plan(std::span<const AgentQuery> agents,
+                                  std::span<const TilePos> obstacles = {});
+
+  void SetWindow(uint32_t window) { m_Window = std::max(window, 1u); }
+  uint32_t GetWindow() const { return m_Window; }
+  const ReservationTable &GetReservations() const { return m_Reserved; }
+  // expanded by the space-time searches of the last Plan call
+  size_t GetExpandedNodeCount() const { return m_ExpandedNodes; }
+
+private:
+  const Map *m_Map;
+  uint32_t m_Window;
+  size_t m_ExpandedNodes = 0;
+  SpaceTimeAStar m_Search;
+  ReservationTable m_Reserved;
+};
+
+// The passable tiles closest to the target in steps, in the target's
+// component, one goal for every agent of a group order. Fewer if the
+// component is smaller.
+std::vector<TilePos> GoalsAround(const Map &map, TilePos target,
+                                 size_t count);
+
+} // namespace pathfinder
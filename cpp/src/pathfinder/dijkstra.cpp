@@ -1,71 +1,100 @@
-#include <queue>
+#include <cstddef>
+#include <limits>
 
 #include "dijkstra.hpp"
 
 #include "base.hpp"
 #include "map.hpp"
 #include "math.hpp"
+#include "search_state.hpp"
 #include "utils.hpp"
 
 namespace pathfinder {
 
-Path Dijkstra::CalculatePath(WorldPos start_world, WorldPos end_world) {
-  using QueueEntry = utils::QueueEntry;
+template <typename Frontier>
+Path Dijkstra<Frontier>::FindPath(WorldPos start_world, WorldPos end_world) {
+  Begin(start_world, end_world);
+  Step(std::numeric_limits<size_t>::max());
+  return TakePath();
+}
 
+template <typename Frontier>
+void Dijkstra<Frontier>::Begin(WorldPos start_world, WorldPos end_world) {
+  ResetCounters();
+  m_Status = SearchStatus::NOT_FOUND;
   if (!m_Map)
-    return {};
+    return;
 
-  const TilePos start = m_Map->WorldToTile(start_world);
-  const TilePos end = m_Map->WorldToTile(end_world);
+  m_Start = m_Map->WorldToTile(start_world);
+  m_End = m_Map->WorldToTile(end_world);
 
-  if (!m_Map->IsTilePosValid(start) || !m_Map->IsTilePosValid(end))
-    return {};
-  if (start == end)
-    return {};
+  if (!m_Map->IsTilePosValid(m_Start) || !m_Map->IsTilePosValid(m_End))
+    return;
+  if (m_Start == m_End)
+    return;
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(m_Start, m_End))
+    return;
 
   // clear previous run
-  m_CameFrom.clear();
-  m_Cost.clear();
-
-  std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>>
-      frontier;
-  frontier.push({0.0f, start});
-  m_CameFrom[start] = start; // sentinel
-  m_Cost[start] = 0.0f;
+  m_State.Reset(m_Map);
+  m_Frontier.clear();
+
+  const size_t start_idx = m_Map->TileToIndex(m_Start);
+  m_Frontier.push({0.0f, m_Start});
+  CountPush(m_Frontier.size());
+  m_State.Visit(start_idx, 0.0f, start_idx); // sentinel
+  m_Status = SearchStatus::IN_PROGRESS;
+}
 
-  while (!frontier.empty()) {
-    const QueueEntry current = frontier.top();
-    frontier.pop();
+template <typename Frontier>
+SearchStatus Dijkstra<Frontier>::Step(size_t max_expansions) {
+  using QueueEntry = utils::QueueEntry;
 
-    if (current.tile == end) // early exit
-      break;
+  if (m_Status != SearchStatus::IN_PROGRESS)
+    return m_Status;
 
-    for (TilePos next : m_Map->GetNeighbors(current.tile)) {
+  size_t expanded = 0;
+  while (!m_Frontier.empty()) {
+    const QueueEntry current = m_Frontier.top();
+    if (current.tile == m_End) { // early exit
+      m_Status = SearchStatus::FOUND;
+      return m_Status;
+    }
+    if (expanded == max_expansions)
+      return m_Status; // out of budget, the frontier stays for next time
+    m_Frontier.pop();
+
+    const size_t current_idx = m_Map->TileToIndex(current.tile);
+    m_ExpandedNodes++;
+    expanded++;
+    for (const Neighbor &next : m_Map->GetNeighbors(current.tile)) {
       // cost of moving to neighbour (uniform 1.0 matches original BFS)
-      const float newCost = m_Cost[current.tile] + m_Map->GetCost(next);
+      const float newCost = m_State.GetCost(current_idx) + next.cost;
 
-      if (!m_Cost.count(next) || newCost < m_Cost[next]) {
-        m_Cost[next] = newCost;
-        m_CameFrom[next] = current.tile;
-        frontier.push({newCost, next});
+      if (!m_State.IsVisited(next.index) ||
+          newCost < m_State.GetCost(next.index)) {
+        m_State.Visit(next.index, newCost, current_idx);
+        m_Frontier.push({newCost, next.pos});
+        CountPush(m_Frontier.size());
       }
     }
   }
 
-  // reconstruct path
-  if (!m_CameFrom.count(end))
-    return {}; // goal never reached
-
-  Path path;
-  TilePos cur = end;
-  path.push_back(m_Map->TileToWorld(cur));
+  m_Status = m_State.IsVisited(m_Map->TileToIndex(m_End))
+                 ? SearchStatus::FOUND
+                 : SearchStatus::NOT_FOUND;
+  return m_Status;
+}
 
-  while (cur != start) {
-    cur = m_CameFrom[cur];
-    path.push_back(m_Map->TileToWorld(cur));
-  }
-  std::reverse(path.begin(), path.end());
-  return path;
+template <typename Frontier> Path Dijkstra<Frontier>::TakePath() {
+  if (m_Status != SearchStatus::FOUND)
+    return {};
+  // reconstruct path
+  return m_State.ReconstructPath(*m_Map, m_Start, m_End);
 }
 
+template class Dijkstra<utils::PriorityQueue<>>;
+template class Dijkstra<utils::RadixHeap<>>;
+
 } // namespace pathfinder
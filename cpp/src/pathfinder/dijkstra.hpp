@@ -1,26 +1,46 @@
 #pragma once
 
 #include <string_view>
-#include <unordered_map>
 
 #include "base.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
 
 #include "map.hpp"
 #include "math.hpp"
 
 namespace pathfinder {
 
+// Frontier is utils::PriorityQueue (binary heap) or utils::RadixHeap
+template <typename Frontier = utils::PriorityQueue<>>
 class Dijkstra final : public PathFinderBase {
 
 public:
   Dijkstra(const Map *m) : PathFinderBase(m) {}
-  Path CalculatePath(WorldPos start, WorldPos end) override;
   const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override {
+    return m_State.GetMemoryUsage() + m_Frontier.memory_usage();
+  }
+
+  void Begin(WorldPos start, WorldPos end) override;
+  SearchStatus Step(size_t max_expansions) override;
+  Path TakePath() override;
+  bool IsTimeSliced() const override { return true; }
 
 private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
   const std::string_view m_Name = "Dijkstra's Algorithm";
-  std::unordered_map<TilePos, double, TilePosHash> m_Cost;
-  std::unordered_map<TilePos, TilePos, TilePosHash> m_CameFrom;
+  SearchState m_State;
+  Frontier m_Frontier;
+  // query of the running search, kept between the Step calls
+  TilePos m_Start;
+  TilePos m_End;
+  SearchStatus m_Status = SearchStatus::NOT_FOUND;
 };
 
+// implemented in dijkstra.cpp
+extern template class Dijkstra<utils::PriorityQueue<>>;
+extern template class Dijkstra<utils::RadixHeap<>>;
+
 } // namespace pathfinder
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <vector>
+
+#include "dstar_lite.hpp"
+
+#include "base.hpp"
+#include "log.hpp"
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+Path DStarLite::FindPath(WorldPos start_world, WorldPos end_world) {
+  if (!m_Map)
+    return {};
+
+  const TilePos start = m_Map->WorldToTile(start_world);
+  const TilePos end = m_Map->WorldToTile(end_world);
+
+  if (!m_Map->IsTilePosValid(start) || !m_Map->IsTilePosValid(end))
+    return {};
+  if (start == end)
+    return {};
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(start, end))
+    return {};
+
+  m_Start = start;
+  if (m_Goal != end || m_Nodes.size() != m_Map->GetTileCount() ||
+      m_Connectivity != m_Map->GetConnectivity()) {
+    Initialize(end);
+  } else {
+    // keys already in the open list were computed for the previous start,
+    // km keeps them lower bounds of the keys for the new one
+    m_KeyModifier += m_Heuristic(m_LastStart, start);
+    ApplyMapChanges();
+  }
+  m_LastStart = start;
+
+  ComputeShortestPath();
+  return ExtractPath();
+}
+
+void DStarLite::NotifyTilesChanged(const TileRect &area) {
+  if (!m_Map || !m_Goal || area.IsEmpty())
+    return;
+  // entering a tile costs the cost of the tile, so only the edges into the
+  // changed tiles changed, i.e. the rhs of their neighbors. An impassable tile
+  // also blocks the diagonal moves around its corners, so the whole ring
+  // around the area is updated instead of just the neighbors.
+  for (int32_t x = area.min.x() - 1; x <= area.max.x() + 1; x++) {
+    for (int32_t y = area.min.y() - 1; y <= area.max.y() + 1; y++) {
+      const TilePos tile{x, y};
+      if (m_Map->IsTilePosValid(tile))
+        UpdateVertex(tile);
+    }
+  }
+}
+
+void DStarLite::Initialize(TilePos goal) {
+  LOG_DEBUG("new goal ", goal, ", starting over");
+  m_Nodes.assign(m_Map->GetTileCount(), Node{});
+  m_Open.clear();
+  m_Goal = goal;
+  m_KeyModifier = 0.0f;
+  m_MapVersion = m_Map->GetVersion();
+  m_Connectivity = m_Map->GetConnectivity();
+
+  Node &node = m_Nodes[m_Map->TileToIndex(goal)];
+  node.rhs = 0.0f;
+  node.key = {m_Heuristic(m_Start, goal), 0.0f};
+  node.open = true;
+  m_Open.push({node.key, static_cast<uint32_t>(m_Map->TileToIndex(goal))});
+  CountPush(m_Open.size());
+}
+
+void DStarLite::ApplyMapChanges() {
+  for (const MapChange &change : m_Map->GetChangesSince(m_MapVersion))
+    NotifyTilesChanged(change.area);
+  m_MapVersion = m_Map->GetVersion();
+}
+
+DStarLite::Key DStarLite::CalculateKey(TilePos tile) const {
+  const Node &node = m_Nodes[m_Map->TileToIndex(tile)];
+  const float best = std::min(node.g, node.rhs);
+  return {best + m_Heuristic(m_Start, tile) + m_KeyModifier, best};
+}
+
+void DStarLite::UpdateVertex(TilePos tile) {
+  const size_t idx = m_Map->TileToIndex(tile);
+  Node &node = m_Nodes[idx];
+  if (tile != m_Goal) {
+    node.rhs = kInfinity;
+    for (const Neighbor &next : m_Map->GetNeighbors(tile))
+      node.rhs = std::min(node.rhs, next.cost + m_Nodes[next.index].g);
+  }
+
+  if (node.g != node.rhs) {
+    const Key key = CalculateKey(tile);
+    if (node.open && node.key == key)
+      return; // already queued with this key
+    node.key = key;
+    node.open = true;
+    m_Open.push({key, static_cast<uint32_t>(idx)});
+    CountPush(m_Open.size());
+  } else {
+    node.open = false;
+  }
+}
+
+void DStarLite::ComputeShortestPath() {
+  const size_t start_idx = m_Map->TileToIndex(m_Start);
+
+  while (!m_Open.empty()) {
+    const OpenEntry top = m_Open.top();
+    Node &node = m_Nodes[top.index];
+    // skip stale entries, the node was removed or got a new key
+    if (!node.open || node.key != top.key) {
+      m_Open.pop();
+      continue;
+    }
+
+    const Node &start = m_Nodes[start_idx];
+    if (!(top.key < CalculateKey(m_Start)) && start.rhs == start.g)
+      break; // start is consistent and nothing cheaper is left
+
+    m_Open.pop();
+    m_ExpandedNodes++;
+    const TilePos tile = m_Map->IndexToTile(top.index);
+    const Key new_key = CalculateKey(tile);
+
+    if (top.key < new_key) {
+      // key went up since it was queued (km changed), queue it again
+      node.key = new_key;
+      m_Open.push({new_key, top.index});
+      CountPush(m_Open.size());
+    } else if (node.g > node.rhs) {
+      // overconsistent, the tile got cheaper: settle it
+      node.g = node.rhs;
+      node.open = false;
+      for (const Neighbor &previous : m_Map->GetNeighbors(tile))
+        UpdateVertex(previous.pos);
+    } else {
+      // underconsistent, the tile got more expensive: reopen it and
+      // everything that went through it
+      node.g = kInfinity;
+      UpdateVertex(tile);
+      for (const Neighbor &previous : m_Map->GetNeighbors(tile))
+        UpdateVertex(previous.pos);
+    }
+  }
+}
+
+Path DStarLite::ExtractPath() const {
+  if (m_Nodes[m_Map->TileToIndex(m_Start)].g == kInfinity)
+    return {}; // goal not reachable
+
+  // greedily follow the cheapest successor, g holds the cost to the goal
+  Path path;
+  TilePos current = m_Start;
+  path.push_back(m_Map->TileToWorld(current));
+  while (current != m_Goal) {
+    if (path.size() > m_Map->GetTileCount()) {
+      LOG_ERROR("D* Lite path does not reach the goal");
+      return {};
+    }
+    float best_cost = kInfinity;
+    TilePos best = current;
+    for (const Neighbor &next : m_Map->GetNeighbors(current)) {
+      const float cost = next.cost + m_Nodes[next.index].g;
+      if (cost < best_cost) {
+        best_cost = cost;
+        best = next.pos;
+      }
+    }
+    if (best_cost == kInfinity)
+      return {};
+    current = best;
+    path.push_back(m_Map->TileToWorld(current));
+  }
+  return path;
+}
+
+} // namespace pathfinder
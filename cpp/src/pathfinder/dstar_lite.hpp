@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "astar.hpp"
+#include "base.hpp"
+#include "utils.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// D* Lite (Koenig & Likhachev), incremental replanning towards one goal.
+//
+// The search runs backwards from the goal and keeps its tree (g and rhs of
+// every tile) between calls. While the goal stays the same, a call only
+// repairs the part of the tree that depends on tiles whose cost changed
+// since the previous call (taken from Map::GetChangesSince), so small map
+// edits are cheap to replan. A different start just continues the same tree,
+// a different goal, map size or connectivity starts over.
+class DStarLite final : public PathFinderBase {
+
+public:
+  DStarLite(const Map *m) : PathFinderBase(m) { m_Heuristic.map = m; }
+  const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override {
+    return utils::memory_usage(m_Nodes) + m_Open.memory_usage();
+  }
+
+  // Tiles in the area changed cost. Changes made through the map are picked
+  // up by CalculatePath on its own, this is for callers that know better.
+  void NotifyTilesChanged(const TileRect &area);
+
+private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
+  static constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+  struct Key {
+    float primary;   // min(g, rhs) + h + km
+    float secondary; // min(g, rhs)
+
+    bool operator==(const Key &) const = default;
+    bool operator<(const Key &o) const noexcept {
+      return primary < o.primary ||
+             (primary == o.primary && secondary < o.secondary);
+    }
+  };
+
+  struct Node {
+    float g = kInfinity;   // cost to the goal found so far
+    float rhs = kInfinity; // one step lookahead of g
+    Key key{};             // key of the node in the open list
+    bool open = false;
+  };
+
+  // the open list has no decrease-key, outdated entries are skipped when
+  // they get to the top
+  struct OpenEntry {
+    Key key;
+    uint32_t index;
+
+    bool operator>(const OpenEntry &o) const noexcept { return o.key < key; }
+  };
+
+  void Initialize(TilePos goal);
+  void ApplyMapChanges();
+  Key CalculateKey(TilePos tile) const;
+  void UpdateVertex(TilePos tile);
+  void ComputeShortestPath();
+  Path ExtractPath() const;
+
+  const std::string_view m_Name = "D* Lite";
+  heuristic::Grid m_Heuristic;
+  std::vector<Node> m_Nodes;
+  utils::PriorityQueue<OpenEntry> m_Open;
+  std::optional<TilePos> m_Goal;
+  TilePos m_Start;
+  // start of the previous call, km grows by the distance moved since then
+  TilePos m_LastStart;
+  float m_KeyModifier = 0.0f;
+  uint64_t m_MapVersion = 0;
+  // the heuristic depends on it, a different one starts over
+  Connectivity m_Connectivity = Connectivity::FOUR;
+};
+
+} // namespace pathfinder
@@ -0,0 +1,158 @@
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "flow_field.hpp"
+
+#include "base.hpp"
+#include "log.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "parallel_integrator.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+FlowField::FlowField(const Map *map, TilePos target)
+    : m_Map(map), m_Target(target) {
+  if (!m_Map)
+    return;
+  m_MapVersion = m_Map->GetVersion();
+  m_Costs.assign(m_Map->GetTileCount(), kUnreachable);
+  m_Next.assign(m_Map->GetTileCount(), 0);
+  if (m_Map->IsTilePosValid(m_Target))
+    Integrate();
+}
+
+FlowField::FlowField(const Map *map, TilePos target, size_t thread_count)
+    : m_Map(map), m_Target(target) {
+  if (!m_Map)
+    return;
+  m_MapVersion = m_Map->GetVersion();
+  ParallelIntegrator integrator(m_Map, thread_count);
+  integrator.Integrate(m_Target, m_Costs, m_Next);
+  m_ExpandedNodes = integrator.GetExpandedNodeCount();
+}
+
+void FlowField::Integrate() {
+  // Dijkstra from the target with reversed edges: stepping from "tile" to
+  // "current" costs the cost of "current"
+  utils::PriorityQueue<> frontier;
+  const size_t target_idx = m_Map->TileToIndex(m_Target);
+  m_Costs[target_idx] = 0.0f;
+  m_Next[target_idx] = static_cast<uint32_t>(target_idx);
+  frontier.push({0.0f, m_Target});
+
+  while (!frontier.empty()) {
+    const utils::QueueEntry current = frontier.top();
+    frontier.pop();
+
+    const size_t current_idx = m_Map->TileToIndex(current.tile);
+    if (current.cost > m_Costs[current_idx]) // stale entry
+      continue;
+    m_ExpandedNodes++;
+
+    const float step_cost = m_Map->GetCost(current.tile);
+    for (const Neighbor &tile : m_Map->GetNeighbors(current.tile)) {
+      const float newCost = current.cost + tile.step * step_cost;
+      if (newCost < m_Costs[tile.index]) {
+        m_Costs[tile.index] = newCost;
+        m_Next[tile.index] = static_cast<uint32_t>(current_idx);
+        frontier.push({newCost, tile.pos});
+      }
+    }
+  }
+}
+
+float FlowField::GetCost(TilePos p) const {
+  if (!m_Map || !m_Map->IsTilePosValid(p))
+    return kUnreachable;
+  return m_Costs[m_Map->TileToIndex(p)];
+}
+
+std::optional<TilePos> FlowField::GetNextTile(TilePos p) const {
+  if (GetCost(p) == kUnreachable)
+    return {};
+  return m_Map->IndexToTile(m_Next[m_Map->TileToIndex(p)]);
+}
+
+std::optional<WorldPos> FlowField::GetNextStep(WorldPos from) const {
+  if (!m_Map)
+    return {};
+  const auto next = GetNextTile(m_Map->WorldToTile(from));
+  if (!next)
+    return {};
+  return m_Map->TileToWorld(*next);
+}
+
+Path FlowField::GetPath(WorldPos from) const {
+  const TilePos start = m_Map ? m_Map->WorldToTile(from) : TilePos{};
+  if (GetCost(start) == kUnreachable)
+    return {};
+
+  Path path;
+  size_t current = m_Map->TileToIndex(start);
+  path.push_back(m_Map->TileToWorld(start));
+  while (m_Next[current] != current) {
+    current = m_Next[current];
+    path.push_back(m_Map->TileToWorld(m_Map->IndexToTile(current)));
+  }
+  return path;
+}
+
+size_t FlowField::GetMemoryUsage() const {
+  return utils::memory_usage(m_Costs) + utils::memory_usage(m_Next);
+}
+
+FlowFieldCache::FlowFieldCache(const Map *map, size_t memory_cap)
+    : m_Map(map), m_MemoryCap(memory_cap) {}
+
+std::shared_ptr<const FlowField> FlowFieldCache::Get(TilePos target) {
+  if (!m_Map || !m_Map->IsTilePosValid(target))
+    return std::make_shared<const FlowField>(m_Map, target);
+
+  if (m_Map->GetVersion() != m_MapVersion) {
+    if (!m_Entries.empty())
+      LOG_DEBUG("map changed, dropping ", m_Entries.size(), " flow fields");
+    Clear();
+    m_MapVersion = m_Map->GetVersion();
+  }
+
+  const size_t key = m_Map->TileToIndex(target);
+  if (auto it = m_Index.find(key); it != m_Index.end()) {
+    m_Hits++;
+    // move to the front, the iterator stays valid
+    m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+    return *it->second;
+  }
+
+  m_Misses++;
+  auto field = std::make_shared<const FlowField>(m_Map, target);
+  m_Entries.push_front(field);
+  m_Index.emplace(key, m_Entries.begin());
+  m_MemoryUsage += field->GetMemoryUsage();
+  Evict();
+  return field;
+}
+
+void FlowFieldCache::Clear() {
+  m_Entries.clear();
+  m_Index.clear();
+  m_MemoryUsage = 0;
+}
+
+void FlowFieldCache::SetMemoryCap(size_t memory_cap) {
+  m_MemoryCap = memory_cap;
+  Evict();
+}
+
+void FlowFieldCache::Evict() {
+  while (m_MemoryUsage > m_MemoryCap && m_Entries.size() > 1) {
+    const FlowField &field = *m_Entries.back();
+    m_MemoryUsage -= field.GetMemoryUsage();
+    m_Index.erase(m_Map->TileToIndex(field.GetTarget()));
+    m_Entries.pop_back();
+  }
+}
+
+} // namespace pathfinder
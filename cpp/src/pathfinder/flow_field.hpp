@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Flow field towards a single target tile.
+//
+// One reverse Dijkstra from the target fills the integration field (cost
+// of the best path from every tile to the target) and the direction field
+// (the next tile on that path). Any number of entities heading to the same
+// target can then read their next step in O(1) instead of running their own
+// search. The field is immutable once built, so it can be shared; it is a
+// snapshot of the map at GetMapVersion().
+class FlowField {
+public:
+  static constexpr float kUnreachable = std::numeric_limits<float>::max();
+
+  FlowField(const Map *map, TilePos target);
+  // integrates on several threads (see ParallelIntegrator), worth it for
+  // maps of a million tiles and more. thread_count 0 uses every core.
+  FlowField(const Map *map, TilePos target, size_t thread_count);
+
+  FlowField(const FlowField &) = delete;
+  FlowField(FlowField &&) = delete;
+  FlowField &operator=(const FlowField &) = delete;
+  FlowField &operator=(FlowField &&) = delete;
+
+  TilePos GetTarget() const { return m_Target; }
+  uint64_t GetMapVersion() const { return m_MapVersion; }
+  size_t GetExpandedNodeCount() const { return m_ExpandedNodes; }
+
+  // cost of the best path from the tile to the target
+  float GetCost(TilePos p) const;
+  // next tile towards the target, the target itself once there
+  std::optional<TilePos> GetNextTile(TilePos p) const;
+  // center of the next tile towards the target, the target itself once
+  // there, empty for positions off the map or without a path
+  std::optional<WorldPos> GetNextStep(WorldPos from) const;
+  // whole path from the position to the target, mostly for debugging
+  Path GetPath(WorldPos from) const;
+
+  // bytes held by the fields
+  size_t GetMemoryUsage() const;
+
+private:
+  void Integrate();
+
+  const Map *m_Map;
+  const TilePos m_Target;
+  uint64_t m_MapVersion = 0;
+  size_t m_ExpandedNodes = 0;
+  // integration field, indexed by Map::TileToIndex
+  std::vector<float> m_Costs;
+  // direction field, index of the next tile (the target points to itself)
+  std::vector<uint32_t> m_Next;
+};
+
+// Least recently used cache of flow fields, one per target tile.
+//
+// Units that keep asking for the distance or the way to the same places
+// (a base, a resource) share one field per place instead of integrating it
+// again. Fields are only valid for the map version they were built for, the
+// first lookup after the map changed drops all of them. Fields are evicted
+// once the cache holds more than the memory cap, the most recent one is
+// always kept. Evicted fields stay valid for whoever still holds them. Not
+// thread safe, the returned fields are immutable and can be shared.
+class FlowFieldCache {
+public:
+  static constexpr size_t kDefaultMemoryCap = 64 * 1024 * 1024;
+
+  explicit FlowFieldCache(const Map *map,
+                          size_t memory_cap = kDefaultMemoryCap);
+
+  // field towards the target, built on a miss. Targets off the map get an
+  // empty field that is not cached.
+  std::shared_ptr<const FlowField> Get(TilePos target);
+  void Clear();
+
+  // evicts right away if the cache holds more than the new cap
+  void SetMemoryCap(size_t memory_cap);
+  size_t GetMemoryCap() const { return m_MemoryCap; }
+  size_t GetMemoryUsage() const { return m_MemoryUsage; }
+  size_t GetSize() const { return m_Entries.size(); }
+  size_t GetHitCount() const { return m_Hits; }
+  size_t GetMissCount() const { return m_Misses; }
+
+private:
+  using Entries = std::list<std::shared_ptr<const FlowField>>;
+
+  // drop the least recently used fields until the cache fits the cap
+  void Evict();
+
+  const Map *m_Map;
+  size_t m_MemoryCap;
+  size_t m_MemoryUsage = 0;
+  size_t m_Hits = 0;
+  size_t m_Misses = 0;
+  uint64_t m_MapVersion = 0;
+  // most recently used first
+  Entries m_Entries;
+  // by Map::TileToIndex of the target
+  std::unordered_map<size_t, Entries::iterator> m_Index;
+};
+
+} // namespace pathfinder
@@ -0,0 +1,37 @@
+#include <memory>
+#include <span>
+#include <utility>
+
+#include "followed_path.hpp"
+
+#include "base.hpp"
+#include "math.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+FollowedPath::FollowedPath(Path path)
+    : m_Points(std::make_shared<const Path>(std::move(path))) {}
+
+FollowedPath::FollowedPath(std::shared_ptr<const Path> points)
+    : m_Points(std::move(points)) {}
+
+void FollowedPath::clear() {
+  m_Points.reset();
+  m_Next = 0;
+}
+
+std::span<const WorldPos> FollowedPath::remaining() const {
+  if (empty())
+    return {};
+  return std::span<const WorldPos>(*m_Points).subspan(m_Next);
+}
+
+size_t FollowedPath::GetMemoryUsage() const {
+  if (!m_Points)
+    return 0;
+  return utils::memory_usage(*m_Points) /
+         static_cast<size_t>(m_Points.use_count());
+}
+
+} // namespace pathfinder
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <span>
+
+#include "base.hpp"
+
+#include "math.hpp"
+
+namespace pathfinder {
+
+// A path being walked: the points of a path and a cursor to the next one.
+//
+// Reaching a point moves the cursor, O(1) instead of erasing the front of
+// the vector. The points are immutable and reference counted, so entities
+// sent along the same route share one copy, and the object is cheap to
+// move. Iterates over the points not reached yet.
+class FollowedPath {
+public:
+  FollowedPath() = default;
+  // takes the points over, pass an rvalue to avoid a copy
+  explicit FollowedPath(Path path);
+  // shares the points with everyone else following them
+  explicit FollowedPath(std::shared_ptr<const Path> points);
+
+  bool empty() const { return !m_Points || m_Next >= m_Points->size(); }
+  // number of points not reached yet
+  size_t size() const { return empty() ? 0 : m_Points->size() - m_Next; }
+  const WorldPos &front() const { return (*m_Points)[m_Next]; }
+  // the front point is reached, move on to the next one
+  void pop_front() { m_Next++; }
+  void clear();
+
+  std::span<const WorldPos> remaining() const;
+  const WorldPos *begin() const { return remaining().data(); }
+  const WorldPos *end() const { return begin() + size(); }
+
+  // the points, for others to follow the same route
+  const std::shared_ptr<const Path> &GetShared() const { return m_Points; }
+  // bytes of the points, divided among everyone sharing them
+  size_t GetMemoryUsage() const;
+
+private:
+  std::shared_ptr<const Path> m_Points;
+  size_t m_Next = 0;
+};
+
+} // namespace pathfinder
@@ -1,10 +1,9 @@
-#include <queue>
-
 #include "gbfs.hpp"
 
 #include "base.hpp"
 #include "map.hpp"
 #include "math.hpp"
+#include "pathfinder/search_state.hpp"
 #include "pathfinder/utils.hpp"
 
 namespace pathfinder {
@@ -13,7 +12,7 @@ float GBFS::Heuristic(const TilePos &a, const TilePos &b) {
   return static_cast<float>(std::abs(a.x() - b.x()) + std::abs(a.y() - b.y()));
 }
 
-Path GBFS::CalculatePath(WorldPos start_world, WorldPos end_world) {
+Path GBFS::FindPath(WorldPos start_world, WorldPos end_world) {
   using QueueEntry = pathfinder::utils::QueueEntry;
 
   if (!m_Map)
@@ -26,44 +25,39 @@ Path GBFS::CalculatePath(WorldPos start_world, WorldPos end_world) {
     return {};
   if (start == end)
     return {};
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(start, end))
+    return {};
 
-  m_CameFrom.clear();
+  m_State.Reset(m_Map);
+  m_Frontier.clear();
 
-  std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>>
-      frontier;
-  frontier.push({Heuristic(start, end), start});
-  m_CameFrom[start] = start; // sentinel
+  const size_t start_idx = m_Map->TileToIndex(start);
+  m_Frontier.push({Heuristic(start, end), start});
+  CountPush(m_Frontier.size());
+  m_State.Visit(start_idx, 0.0f, start_idx); // sentinel
 
-  while (!frontier.empty()) {
-    const QueueEntry current = frontier.top();
-    frontier.pop();
+  while (!m_Frontier.empty()) {
+    const QueueEntry current = m_Frontier.top();
+    m_Frontier.pop();
 
     if (current.tile == end) // early exit
       break;
 
-    for (TilePos next : m_Map->GetNeighbors(current.tile)) {
-      if (!m_CameFrom.count(next)) // not visited
+    const size_t current_idx = m_Map->TileToIndex(current.tile);
+    m_ExpandedNodes++;
+    for (const Neighbor &next : m_Map->GetNeighbors(current.tile)) {
+      if (!m_State.IsVisited(next.index)) // not visited
       {
-        m_CameFrom[next] = current.tile;
-        frontier.push({Heuristic(end, next), next});
+        m_State.Visit(next.index, 0.0f, current_idx);
+        m_Frontier.push({Heuristic(end, next.pos), next.pos});
+        CountPush(m_Frontier.size());
       }
     }
   }
 
   // reconstruct path
-  if (!m_CameFrom.count(end))
-    return {}; // goal never reached
-
-  Path path;
-  TilePos cur = end;
-  path.push_back(m_Map->TileToWorld(cur));
-
-  while (cur != start) {
-    cur = m_CameFrom[cur];
-    path.push_back(m_Map->TileToWorld(cur));
-  }
-  std::reverse(path.begin(), path.end());
-  return path;
+  return m_State.ReconstructPath(*m_Map, start, end);
 }
 
 } // namespace pathfinder
@@ -1,9 +1,10 @@
 #pragma once
 
 #include <string_view>
-#include <unordered_map>
 
 #include "base.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
 
 #include "map.hpp"
 #include "math.hpp"
@@ -14,13 +15,18 @@ class GBFS final : public PathFinderBase {
 
 public:
   GBFS(const Map *m) : PathFinderBase(m) {}
-  Path CalculatePath(WorldPos start, WorldPos end) override;
   const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override {
+    return m_State.GetMemoryUsage() + m_Frontier.memory_usage();
+  }
 
 private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
   static float Heuristic(const TilePos &a, const TilePos &b);
   const std::string_view m_Name = "Greedy Best First Search";
-  std::unordered_map<TilePos, TilePos, TilePosHash> m_CameFrom;
+  SearchState m_State;
+  utils::PriorityQueue<> m_Frontier;
 };
 
 } // namespace pathfinder
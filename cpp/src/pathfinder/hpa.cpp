@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+#include "hpa.hpp"
+
+#include "base.hpp"
+#include "log.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+namespace {
+
+// area with one more tile on every side
+TileRect Grow(TileRect area) {
+  area.Extend(area.min - TilePos{1, 1});
+  area.Extend(area.max + TilePos{1, 1});
+  return area;
+}
+
+} // namespace
+
+void HPAStar::InitClusters() {
+  const int rows = static_cast<int>(m_Map->GetRows());
+  const int cols = static_cast<int>(m_Map->GetCols());
+  m_ClusterRows = (rows + m_ClusterSize - 1) / m_ClusterSize;
+  m_ClusterCols = (cols + m_ClusterSize - 1) / m_ClusterSize;
+  m_Clusters.assign(m_ClusterRows * m_ClusterCols, Cluster{});
+  m_Borders.assign(m_Clusters.size(), {});
+  for (size_t i = 0; i < m_Clusters.size(); i++) {
+    const int row = static_cast<int>(i / m_ClusterCols) * m_ClusterSize;
+    const int col = static_cast<int>(i % m_ClusterCols) * m_ClusterSize;
+    TileRect &area = m_Clusters[i].area;
+    area.Extend(TilePos{row, col});
+    area.Extend(TilePos{std::min(row + m_ClusterSize, rows) - 1,
+                        std::min(col + m_ClusterSize, cols) - 1});
+  }
+}
+
+size_t HPAStar::ClusterIndex(TilePos p) const {
+  return static_cast<size_t>(p.x() / m_ClusterSize) * m_ClusterCols +
+         static_cast<size_t>(p.y() / m_ClusterSize);
+}
+
+std::optional<size_t> HPAStar::Neighbour(size_t cluster,
+                                         Border border) const {
+  if (border == BOTTOM && cluster / m_ClusterCols + 1 < m_ClusterRows)
+    return cluster + m_ClusterCols;
+  if (border == RIGHT && cluster % m_ClusterCols + 1 < m_ClusterCols)
+    return cluster + 1;
+  return {};
+}
+
+void HPAStar::BuildBorder(size_t cluster, Border border) {
+  auto &transitions = m_Borders[cluster][border];
+  transitions.clear();
+  if (!Neighbour(cluster, border))
+    return;
+
+  // tile pairs along the border, inside first
+  const TileRect &area = m_Clusters[cluster].area;
+  std::vector<Transition> pairs;
+  if (border == BOTTOM) {
+    for (int col = area.min.y(); col <= area.max.y(); col++)
+      pairs.emplace_back(TilePos{area.max.x(), col},
+                         TilePos{area.max.x() + 1, col});
+  } else {
+    for (int row = area.min.x(); row <= area.max.x(); row++)
+      pairs.emplace_back(TilePos{row, area.max.y()},
+                         TilePos{row, area.max.y() + 1});
+  }
+
+  // every run of pairs with the same costs is one entrance, crossing
+  // anywhere in it costs the same
+  auto same_costs = [this](const Transition &a, const Transition &b) {
+    return m_Map->GetCost(a.first) == m_Map->GetCost(b.first) &&
+           m_Map->GetCost(a.second) == m_Map->GetCost(b.second) &&
+           m_Map->IsPassable(a.first) == m_Map->IsPassable(b.first) &&
+           m_Map->IsPassable(a.second) == m_Map->IsPassable(b.second);
+  };
+  for (size_t begin = 0; begin < pairs.size();) {
+    size_t end = begin + 1;
+    while (end < pairs.size() && same_costs(pairs[begin], pairs[end]))
+      end++;
+    // the border can't be crossed here
+    if (!m_Map->IsPassable(pairs[begin].first) ||
+        !m_Map->IsPassable(pairs[begin].second)) {
+      begin = end;
+      continue;
+    }
+    if (static_cast<int>(end - begin) <= kMaxEntranceWidth) {
+      transitions.push_back(pairs[(begin + end - 1) / 2]);
+    } else {
+      transitions.push_back(pairs[begin]);
+      transitions.push_back(pairs[end - 1]);
+    }
+    begin = end;
+  }
+}
+
+bool HPAStar::CollectNodes(size_t cluster) {
+  std::vector<TilePos> nodes;
+  for (const auto &[inside, outside] : m_Borders[cluster][BOTTOM])
+    nodes.push_back(inside);
+  for (const auto &[inside, outside] : m_Borders[cluster][RIGHT])
+    nodes.push_back(inside);
+  // top and left borders are owned by the neighbours
+  if (cluster >= m_ClusterCols) {
+    for (const auto &[inside, outside] :
+         m_Borders[cluster - m_ClusterCols][BOTTOM])
+      nodes.push_back(outside);
+  }
+  if (cluster % m_ClusterCols > 0) {
+    for (const auto &[inside, outside] : m_Borders[cluster - 1][RIGHT])
+      nodes.push_back(outside);
+  }
+
+  auto by_index = [this](TilePos p) { return m_Map->TileToIndex(p); };
+  std::ranges::sort(nodes, {}, by_index);
+  const auto duplicates = std::ranges::unique(nodes);
+  nodes.erase(duplicates.begin(), duplicates.end());
+
+  if (nodes == m_Clusters[cluster].nodes)
+    return false;
+  m_Clusters[cluster].nodes = std::move(nodes);
+  return true;
+}
+
+void HPAStar::BuildClusterEdges(Cluster &cluster) {
+  const size_t n = cluster.nodes.size();
+  cluster.distances.assign(n * n, kUnreachable);
+  for (size_t i = 0; i < n; i++) {
+    SearchArea(cluster.nodes[i], cluster.area);
+    for (size_t j = 0; j < n; j++) {
+      const size_t idx = m_Map->TileToIndex(cluster.nodes[j]);
+      if (m_State.IsVisited(idx))
+        cluster.distances[i * n + j] = m_State.GetCost(idx);
+    }
+  }
+}
+
+uint32_t HPAStar::NodeId(size_t cluster, TilePos tile) const {
+  const auto &nodes = m_Clusters[cluster].nodes;
+  auto it = std::ranges::lower_bound(
+      nodes, m_Map->TileToIndex(tile), {},
+      [this](TilePos p) { return m_Map->TileToIndex(p); });
+  return m_Clusters[cluster].first_node +
+         static_cast<uint32_t>(it - nodes.begin());
+}
+
+void HPAStar::LinkClusters() {
+  // number the nodes cluster by cluster
+  uint32_t node_count = 0;
+  m_NodeCluster.clear();
+  for (size_t c = 0; c < m_Clusters.size(); c++) {
+    m_Clusters[c].first_node = node_count;
+    node_count += static_cast<uint32_t>(m_Clusters[c].nodes.size());
+    m_NodeCluster.resize(node_count, static_cast<uint32_t>(c));
+  }
+
+  m_InterEdges.assign(node_count, {});
+  for (size_t c = 0; c < m_Clusters.size(); c++) {
+    for (Border border : {BOTTOM, RIGHT}) {
+      const auto neighbour = Neighbour(c, border);
+      if (!neighbour)
+        continue;
+      for (const auto &[inside, outside] : m_Borders[c][border]) {
+        const uint32_t a = NodeId(c, inside);
+        const uint32_t b = NodeId(*neighbour, outside);
+        m_InterEdges[a].push_back({b, m_Map->GetCost(outside)});
+        m_InterEdges[b].push_back({a, m_Map->GetCost(inside)});
+      }
+    }
+  }
+}
+
+void HPAStar::UpdateAbstractGraph() {
+  const uint64_t version = m_Map->GetVersion();
+  if (m_BuiltVersion == version)
+    return;
+
+  std::vector<bool> dirty;
+  if (!m_BuiltVersion) {
+    InitClusters();
+    dirty.assign(m_Clusters.size(), true);
+  } else {
+    dirty.assign(m_Clusters.size(), false);
+    for (const MapChange &change : m_Map->GetChangesSince(*m_BuiltVersion)) {
+      const size_t first = ClusterIndex(change.area.min);
+      const size_t last = ClusterIndex(change.area.max);
+      for (size_t row = first / m_ClusterCols; row <= last / m_ClusterCols;
+           row++) {
+        for (size_t col = first % m_ClusterCols;
+             col <= last % m_ClusterCols; col++)
+          dirty[row * m_ClusterCols + col] = true;
+      }
+    }
+  }
+
+  // entrances on all four borders of a changed cluster may move, which
+  // changes the nodes of the neighbours as well
+  std::vector<bool> touched = dirty;
+  for (size_t c = 0; c < m_Clusters.size(); c++) {
+    if (!dirty[c])
+      continue;
+    for (Border border : {BOTTOM, RIGHT}) {
+      BuildBorder(c, border);
+      if (auto neighbour = Neighbour(c, border))
+        touched[*neighbour] = true;
+    }
+    if (c >= m_ClusterCols) {
+      BuildBorder(c - m_ClusterCols, BOTTOM);
+      touched[c - m_ClusterCols] = true;
+    }
+    if (c % m_ClusterCols > 0) {
+      BuildBorder(c - 1, RIGHT);
+      touched[c - 1] = true;
+    }
+  }
+
+  m_RebuiltClusters = 0;
+  for (size_t c = 0; c < m_Clusters.size(); c++) {
+    if (!touched[c])
+      continue;
+    // untouched terrain and same entrances keep the old edges
+    if (CollectNodes(c) || dirty[c]) {
+      BuildClusterEdges(m_Clusters[c]);
+      m_RebuiltClusters++;
+    }
+  }
+  LinkClusters();
+  m_BuiltVersion = version;
+  LOG_DEBUG("rebuilt ", m_RebuiltClusters, " clusters, ",
+            m_InterEdges.size(), " abstract nodes");
+}
+
+void HPAStar::SearchArea(TilePos from, const TileRect &area,
+                         std::optional<TilePos> target) {
+  m_State.Reset(m_Map);
+  m_Frontier.clear();
+
+  const size_t from_idx = m_Map->TileToIndex(from);
+  m_Frontier.push({0.0f, from});
+  CountPush(m_Frontier.size());
+  m_State.Visit(from_idx, 0.0f, from_idx); // sentinel
+
+  while (!m_Frontier.empty()) {
+    const utils::QueueEntry current = m_Frontier.top();
+    m_Frontier.pop();
+
+    if (current.tile == target) // early exit
+      break;
+
+    const size_t current_idx = m_Map->TileToIndex(current.tile);
+    const float current_cost = m_State.GetCost(current_idx);
+    if (current.cost > current_cost) // stale entry
+      continue;
+    m_ExpandedNodes++;
+    for (const Neighbor &next : m_Map->GetNeighbors(current.tile)) {
+      if (!area.Contains(next.pos))
+        continue;
+      const float newCost = current_cost + next.cost;
+      if (!m_State.IsVisited(next.index) ||
+          newCost < m_State.GetCost(next.index)) {
+        m_State.Visit(next.index, newCost, current_idx);
+        m_Frontier.push({newCost, next.pos});
+        CountPush(m_Frontier.size());
+      }
+    }
+  }
+}
+
+void HPAStar::ConnectTile(TilePos tile, std::vector<Edge> &edges) {
+  // the search may step out of the cluster by one tile, so that a tile on
+  // the border can cross it right where it is
+  const size_t cluster = ClusterIndex(tile);
+  const TileRect area = Grow(m_Clusters[cluster].area);
+  SearchArea(tile, area);
+
+  edges.clear();
+  const int row = static_cast<int>(cluster / m_ClusterCols);
+  const int col = static_cast<int>(cluster % m_ClusterCols);
+  for (int r = std::max(row - 1, 0);
+       r <= std::min(row + 1, static_cast<int>(m_ClusterRows) - 1); r++) {
+    for (int c = std::max(col - 1, 0);
+         c <= std::min(col + 1, static_cast<int>(m_ClusterCols) - 1); c++) {
+      const Cluster &neighbour = m_Clusters[r * m_ClusterCols + c];
+      for (size_t i = 0; i < neighbour.nodes.size(); i++) {
+        const size_t idx = m_Map->TileToIndex(neighbour.nodes[i]);
+        if (area.Contains(neighbour.nodes[i]) && m_State.IsVisited(idx))
+          edges.push_back({neighbour.first_node + static_cast<uint32_t>(i),
+                           m_State.GetCost(idx)});
+      }
+    }
+  }
+}
+
+std::vector<TilePos> HPAStar::SearchAbstract(TilePos start, TilePos end) {
+  const uint32_t node_count = static_cast<uint32_t>(m_InterEdges.size());
+  const uint32_t start_id = node_count;
+  const uint32_t end_id = node_count + 1;
+  auto tile_of = [&](uint32_t id) {
+    if (id == start_id)
+      return start;
+    if (id == end_id)
+      return end;
+    const Cluster &cluster = m_Clusters[m_NodeCluster[id]];
+    return cluster.nodes[id - cluster.first_node];
+  };
+
+  // connect start and end to the entrances around them, reversing a path
+  // from u to v only swaps which of the end tiles is paid for
+  ConnectTile(end, m_EndEdges);
+  m_ToEnd.assign(node_count, kUnreachable);
+  for (const Edge &edge : m_EndEdges)
+    m_ToEnd[edge.to] =
+        edge.cost + m_Map->GetCost(end) - m_Map->GetCost(tile_of(edge.to));
+  ConnectTile(start, m_StartEdges);
+
+  // short paths would have to detour through the entrances, so when the
+  // clusters touch, also try going straight inside both of them
+  const size_t start_cluster = ClusterIndex(start);
+  const size_t end_cluster = ClusterIndex(end);
+  const int row_distance =
+      std::abs(static_cast<int>(start_cluster / m_ClusterCols) -
+               static_cast<int>(end_cluster / m_ClusterCols));
+  const int col_distance =
+      std::abs(static_cast<int>(start_cluster % m_ClusterCols) -
+               static_cast<int>(end_cluster % m_ClusterCols));
+  if (row_distance <= 1 && col_distance <= 1) {
+    TileRect area = m_Clusters[start_cluster].area;
+    area.Extend(m_Clusters[end_cluster].area);
+    SearchArea(start, area, end);
+    if (m_State.IsVisited(m_Map->TileToIndex(end)))
+      m_StartEdges.push_back({end_id, m_State.GetCost(m_Map->TileToIndex(end))});
+  }
+
+  // A* over the abstract graph
+  m_NodeCost.assign(node_count + 2, kUnreachable);
+  m_NodeCameFrom.assign(node_count + 2, start_id);
+  m_NodeFrontier.clear();
+  m_NodeCost[start_id] = 0.0f;
+  m_NodeFrontier.push({m_Heuristic(start, end), start_id});
+  CountPush(m_NodeFrontier.size());
+
+  auto relax = [&](uint32_t from, uint32_t to, float edge_cost) {
+    if (edge_cost == kUnreachable)
+      return;
+    const float newCost = m_NodeCost[from] + edge_cost;
+    if (newCost < m_NodeCost[to]) {
+      m_NodeCost[to] = newCost;
+      m_NodeCameFrom[to] = from;
+      m_NodeFrontier.push({newCost + m_Heuristic(tile_of(to), end), to});
+      CountPush(m_NodeFrontier.size());
+    }
+  };
+
+  while (!m_NodeFrontier.empty()) {
+    const NodeEntry current = m_NodeFrontier.top();
+    m_NodeFrontier.pop();
+    if (current.node == end_id) // early exit
+      break;
+    const TilePos current_tile = tile_of(current.node);
+    if (current.cost > m_NodeCost[current.node] + m_Heuristic(current_tile, end))
+      continue; // stale entry
+    m_ExpandedNodes++;
+
+    if (current.node == start_id) {
+      for (const Edge &edge : m_StartEdges)
+        relax(start_id, edge.to, edge.cost);
+      continue;
+    }
+
+    const size_t c = m_NodeCluster[current.node];
+    const Cluster &cluster = m_Clusters[c];
+    const size_t n = cluster.nodes.size();
+    const size_t i = current.node - cluster.first_node;
+    for (size_t j = 0; j < n; j++) {
+      if (j != i)
+        relax(current.node, cluster.first_node + static_cast<uint32_t>(j),
+              cluster.distances[i * n + j]);
+    }
+    for (const Edge &edge : m_InterEdges[current.node])
+      relax(current.node, edge.to, edge.cost);
+    relax(current.node, end_id, m_ToEnd[current.node]);
+  }
+
+  if (m_NodeCost[end_id] == kUnreachable)
+    return {};
+  std::vector<TilePos> waypoints;
+  for (uint32_t id = end_id; id != start_id; id = m_NodeCameFrom[id])
+    waypoints.push_back(tile_of(id));
+  waypoints.push_back(start);
+  std::ranges::reverse(waypoints);
+  return waypoints;
+}
+
+Path HPAStar::CalculateAbstractPath(WorldPos start_world, WorldPos end_world) {
+  if (!m_Map)
+    return {};
+
+  const TilePos start = m_Map->WorldToTile(start_world);
+  const TilePos end = m_Map->WorldToTile(end_world);
+
+  if (!m_Map->IsTilePosValid(start) || !m_Map->IsTilePosValid(end))
+    return {};
+  if (start == end)
+    return {};
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(start, end))
+    return {};
+
+  // also called on its own, not only through CalculatePath, so the count
+  // starts here; rebuilding the clusters counts towards the query
+  m_ExpandedNodes = 0;
+  UpdateAbstractGraph();
+
+  Path waypoints;
+  for (TilePos tile : SearchAbstract(start, end)) {
+    if (tile != start)
+      waypoints.push_back(m_Map->TileToWorld(tile));
+  }
+  return waypoints;
+}
+
+Path HPAStar::RefineSegment(WorldPos from_world, WorldPos to_world) {
+  if (!m_Map)
+    return {};
+
+  const TilePos from = m_Map->WorldToTile(from_world);
+  const TilePos to = m_Map->WorldToTile(to_world);
+
+  if (!m_Map->IsTilePosValid(from) || !m_Map->IsTilePosValid(to))
+    return {};
+  if (from == to)
+    return {};
+
+  m_ExpandedNodes = 0;
+  // only the cluster areas are needed, they don't change with the map, so
+  // refining never builds the abstract graph
+  if (m_Clusters.empty())
+    InitClusters();
+  // waypoints are in the same or neighbouring clusters and start and end
+  // may step one tile out of theirs (see ConnectTile), nothing else needs
+  // to be searched
+  TileRect area = m_Clusters[ClusterIndex(from)].area;
+  area.Extend(m_Clusters[ClusterIndex(to)].area);
+  SearchArea(from, Grow(area), to);
+  return m_State.ReconstructPath(*m_Map, from, to);
+}
+
+size_t HPAStar::GetMemoryUsage() const {
+  return m_State.GetMemoryUsage() + m_Frontier.memory_usage() +
+         utils::memory_usage(m_NodeCost) +
+         utils::memory_usage(m_NodeCameFrom) +
+         utils::memory_usage(m_StartEdges) + utils::memory_usage(m_EndEdges) +
+         utils::memory_usage(m_ToEnd) + m_NodeFrontier.memory_usage();
+}
+
+Path HPAStar::FindPath(WorldPos start_world, WorldPos end_world) {
+  Path waypoints = CalculateAbstractPath(start_world, end_world);
+  if (waypoints.empty())
+    return {};
+
+  Path path;
+  WorldPos from = m_Map->TileToWorld(m_Map->WorldToTile(start_world));
+  size_t expanded = m_ExpandedNodes;
+  for (const WorldPos &to : waypoints) {
+    Path segment = RefineSegment(from, to);
+    expanded += m_ExpandedNodes;
+    // segments share their first tile with the end of the previous one
+    auto first = path.empty() ? segment.begin() : std::next(segment.begin());
+    if (!segment.empty())
+      path.insert(path.end(), first, segment.end());
+    from = to;
+  }
+  m_ExpandedNodes = expanded;
+  return path;
+}
+
+} // namespace pathfinder
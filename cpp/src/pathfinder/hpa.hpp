@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "astar.hpp"
+#include "base.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Hierarchical pathfinding (HPA*).
+//
+// The map is split into square clusters. Tiles on both sides of a cluster
+// border where the path may cross become abstract nodes (entrances), one or
+// two for every run of border tiles with the same costs. Nodes of the same
+// cluster are connected by edges with the cost of the best path inside the
+// cluster, nodes facing each other across a border by an edge with the cost
+// of the tile entered. Queries search this small graph and only the segments
+// between consecutive waypoints are searched on the tile level, each of them
+// inside one or two clusters. The result is close to optimal, but not
+// guaranteed to be optimal.
+//
+// The abstract graph is built lazily and follows Map::GetVersion(), after
+// painting only the clusters touched by the change (and neighbours whose
+// entrances moved) are rebuilt. Refining a segment doesn't need the graph,
+// it only searches the clusters of its ends. An empty segment between two
+// different tiles means the way left them (the entity got pushed away or the
+// waypoint was painted over) and the rest of the path has to be searched
+// again.
+class HPAStar final : public PathFinderBase {
+
+public:
+  static constexpr int kDefaultClusterSize = 10;
+
+  HPAStar(const Map *m, int cluster_size = kDefaultClusterSize)
+      : PathFinderBase(m), m_ClusterSize(cluster_size) {
+    m_Heuristic.map = m;
+  }
+  Path CalculateAbstractPath(WorldPos start, WorldPos end) override;
+  Path RefineSegment(WorldPos from, WorldPos to) override;
+  const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override;
+
+  // clusters whose edges were recomputed by the last abstract graph update
+  size_t GetRebuiltClusterCount() const { return m_RebuiltClusters; }
+  size_t GetAbstractNodeCount() const { return m_InterEdges.size(); }
+
+private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
+  // entrances longer than this get a node at both ends instead of one in
+  // the middle
+  static constexpr int kMaxEntranceWidth = 6;
+  static constexpr float kUnreachable = std::numeric_limits<float>::max();
+
+  // border directions, the top and left borders belong to the neighbour
+  enum Border : uint8_t { BOTTOM, RIGHT };
+
+  // pair of tiles facing each other across a border, first one is in the
+  // cluster owning the border
+  using Transition = std::pair<TilePos, TilePos>;
+
+  struct Cluster {
+    TileRect area;
+    // entrance tiles inside the cluster, sorted by tile index
+    std::vector<TilePos> nodes;
+    // distances[i * nodes.size() + j] is the cost from node i to node j
+    std::vector<float> distances;
+    uint32_t first_node = 0; // id of nodes[0] in the abstract graph
+  };
+
+  struct Edge {
+    uint32_t to;
+    float cost;
+  };
+
+  struct NodeEntry {
+    float cost;
+    uint32_t node;
+
+    bool operator>(const NodeEntry &o) const noexcept { return cost > o.cost; }
+  };
+
+  void UpdateAbstractGraph();
+  void InitClusters();
+  size_t ClusterIndex(TilePos p) const;
+  std::optional<size_t> Neighbour(size_t cluster, Border border) const;
+  void BuildBorder(size_t cluster, Border border);
+  // true if the set of entrance tiles changed
+  bool CollectNodes(size_t cluster);
+  void BuildClusterEdges(Cluster &cluster);
+  void LinkClusters();
+  uint32_t NodeId(size_t cluster, TilePos tile) const;
+
+  // Dijkstra from "from" that never leaves "area", stops at "target" if set
+  void SearchArea(TilePos from, const TileRect &area,
+                  std::optional<TilePos> target = {});
+  // edges from the tile to the entrances in and right around its cluster
+  void ConnectTile(TilePos tile, std::vector<Edge> &edges);
+  // waypoints from start to end, both included, empty if there is no path
+  std::vector<TilePos> SearchAbstract(TilePos start, TilePos end);
+
+  const std::string_view m_Name = "HPA*";
+  const int m_ClusterSize;
+  size_t m_ClusterRows = 0;
+  size_t m_ClusterCols = 0;
+  std::vector<Cluster> m_Clusters;
+  // transitions across the BOTTOM and RIGHT border of every cluster
+  std::vector<std::array<std::vector<Transition>, 2>> m_Borders;
+  // cluster of every abstract node and its edges to other clusters
+  std::vector<uint32_t> m_NodeCluster;
+  std::vector<std::vector<Edge>> m_InterEdges;
+  std::optional<uint64_t> m_BuiltVersion;
+  size_t m_RebuiltClusters = 0;
+
+  // tile level search inside clusters
+  SearchState m_State;
+  utils::PriorityQueue<> m_Frontier;
+
+  // abstract search, start and end get temporary ids after the real nodes
+  heuristic::Grid m_Heuristic;
+  std::vector<float> m_NodeCost;
+  std::vector<uint32_t> m_NodeCameFrom;
+  std::vector<Edge> m_StartEdges;
+  std::vector<Edge> m_EndEdges;
+  std::vector<float> m_ToEnd; // cost of the edge to the end for every node
+  utils::PriorityQueue<NodeEntry> m_NodeFrontier;
+};
+
+} // namespace pathfinder
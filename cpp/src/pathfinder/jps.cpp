@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+#include "jps.hpp"
+
+#include "base.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "search_state.hpp"
+
+namespace pathfinder {
+
+bool JPS::IsForced(TilePos previous, TilePos current, Direction side) const {
+  // turning sideways at "current" is only needed if going sideways first
+  // (through the tile next to "previous") would be more expensive
+  const TilePos side_tile = current + kSteps[side];
+  if (!m_Map->IsPassable(side_tile))
+    return false;
+  const TilePos previous_side = previous + kSteps[side];
+  return !m_Map->IsPassable(previous_side) ||
+         m_Map->GetCost(previous_side) > m_Map->GetCost(current);
+}
+
+bool JPS::HasForcedNeighbor(TilePos previous, TilePos current) const {
+  return IsForced(previous, current, RIGHT) ||
+         IsForced(previous, current, LEFT);
+}
+
+void JPS::BuildRuns() {
+  const int rows = static_cast<int>(m_Map->GetRows());
+  const int cols = static_cast<int>(m_Map->GetCols());
+  m_JumpDistance.assign(m_Map->GetTileCount(), {0, 0, 0, 0});
+  m_PrefixCost.resize(m_Map->GetTileCount());
+  m_PrefixBlocked.resize(m_Map->GetTileCount());
+
+  // the jump point ahead of the next tile is one step further away, so
+  // sweep against the direction of travel
+  auto sweep = [this](TilePos current, Direction d, bool is_jump_point) {
+    const TilePos next = current + kSteps[d];
+    if (!m_Map->IsPassable(next))
+      return; // runs end before impassable tiles
+    const size_t next_idx = m_Map->TileToIndex(next);
+    const int32_t ahead = m_JumpDistance[next_idx][d];
+    int32_t &distance = m_JumpDistance[m_Map->TileToIndex(current)][d];
+    if (is_jump_point)
+      distance = 1;
+    else if (ahead > 0)
+      distance = ahead + 1;
+  };
+
+  // vertical runs stop where they are forced to turn
+  for (int col = 0; col < cols; col++) {
+    for (int row = rows - 2; row >= 0; row--) {
+      const TilePos tile{row, col};
+      sweep(tile, DOWN, HasForcedNeighbor(tile, tile + kSteps[DOWN]));
+    }
+    for (int row = 1; row < rows; row++) {
+      const TilePos tile{row, col};
+      sweep(tile, UP, HasForcedNeighbor(tile, tile + kSteps[UP]));
+    }
+  }
+
+  // horizontal runs stop where a vertical run leads to a jump point
+  auto leads_somewhere = [this](TilePos tile) {
+    const auto &distance = m_JumpDistance[m_Map->TileToIndex(tile)];
+    return distance[DOWN] > 0 || distance[UP] > 0;
+  };
+  for (int row = 0; row < rows; row++) {
+    for (int col = cols - 2; col >= 0; col--) {
+      const TilePos tile{row, col};
+      sweep(tile, RIGHT, leads_somewhere(tile + kSteps[RIGHT]));
+    }
+    for (int col = 1; col < cols; col++) {
+      const TilePos tile{row, col};
+      sweep(tile, LEFT, leads_somewhere(tile + kSteps[LEFT]));
+    }
+  }
+
+  for (int col = 0; col < cols; col++) {
+    double sum = 0.0;
+    uint32_t blocked = 0;
+    for (int row = 0; row < rows; row++) {
+      const TilePos tile{row, col};
+      sum += m_Map->GetCost(tile);
+      blocked += !m_Map->IsPassable(tile);
+      m_PrefixCost[m_Map->TileToIndex(tile)][0] = sum;
+      m_PrefixBlocked[m_Map->TileToIndex(tile)][0] = blocked;
+    }
+  }
+  for (int row = 0; row < rows; row++) {
+    double sum = 0.0;
+    uint32_t blocked = 0;
+    for (int col = 0; col < cols; col++) {
+      const TilePos tile{row, col};
+      sum += m_Map->GetCost(tile);
+      blocked += !m_Map->IsPassable(tile);
+      m_PrefixCost[m_Map->TileToIndex(tile)][1] = sum;
+      m_PrefixBlocked[m_Map->TileToIndex(tile)][1] = blocked;
+    }
+  }
+}
+
+float JPS::RunCost(TilePos from, TilePos to, Direction d) const {
+  const size_t axis = IsVertical(d) ? 0 : 1;
+  // "from" is passable, so equal counts mean that nothing between the
+  // tiles is impassable, "to" is checked on its own for the reverse runs
+  if (m_PrefixBlocked[m_Map->TileToIndex(from)][axis] !=
+          m_PrefixBlocked[m_Map->TileToIndex(to)][axis] ||
+      !m_Map->IsPassable(to))
+    return std::numeric_limits<float>::infinity();
+  const double from_sum = m_PrefixCost[m_Map->TileToIndex(from)][axis];
+  const double to_sum = m_PrefixCost[m_Map->TileToIndex(to)][axis];
+  if (d == DOWN || d == RIGHT) // "from" itself is not entered
+    return static_cast<float>(to_sum - from_sum);
+  // moving against the prefix, "to" is entered but "from" is not
+  return static_cast<float>((from_sum - m_Map->GetCost(from)) -
+                            (to_sum - m_Map->GetCost(to)));
+}
+
+std::optional<TilePos> JPS::Jump(TilePos from, Direction d, TilePos end,
+                                 float &cost) const {
+  cost = 0.0f;
+  int32_t steps = m_JumpDistance[m_Map->TileToIndex(from)][d];
+
+  // the goal is the only jump point that depends on the query, vertical
+  // runs stop at it and horizontal runs stop at its column
+  const TilePos to_goal = end - from;
+  const bool vertical = IsVertical(d);
+  const int32_t goal_steps = vertical ? to_goal.x() * kSteps[d].x()
+                                      : to_goal.y() * kSteps[d].y();
+  if ((!vertical || to_goal.y() == 0) && goal_steps > 0 &&
+      (steps == 0 || goal_steps < steps))
+    steps = goal_steps;
+
+  if (steps == 0)
+    return {};
+  const TilePos to = from + kSteps[d] * steps;
+  cost = RunCost(from, to, d);
+  if (std::isinf(cost))
+    return {}; // only the goal can lie behind an impassable tile
+  return to;
+}
+
+Path JPS::ReconstructPath(TilePos start, TilePos end) const {
+  if (!m_State.IsVisited(m_Map->TileToIndex(end)))
+    return {}; // goal never reached
+
+  // jump points are linked by straight runs, fill in the skipped tiles
+  Path path;
+  TilePos current = end;
+  path.push_back(m_Map->TileToWorld(current));
+  while (current != start) {
+    const TilePos jump_origin =
+        m_Map->IndexToTile(m_State.GetCameFrom(m_Map->TileToIndex(current)));
+    const TilePos diff = jump_origin - current;
+    const TilePos step{(diff.x() > 0) - (diff.x() < 0),
+                       (diff.y() > 0) - (diff.y() < 0)};
+    while (current != jump_origin) {
+      current += step;
+      path.push_back(m_Map->TileToWorld(current));
+    }
+  }
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+size_t JPS::GetMemoryUsage() const {
+  return m_Fallback.GetMemoryUsage() + m_State.GetMemoryUsage() +
+         utils::memory_usage(m_ArrivedFrom) +
+         utils::memory_usage(m_JumpDistance) +
+         utils::memory_usage(m_PrefixCost) +
+         utils::memory_usage(m_PrefixBlocked) + m_Frontier.memory_usage();
+}
+
+Path JPS::FindPath(WorldPos start_world, WorldPos end_world) {
+  if (!m_Map)
+    return {};
+  if (m_Map->GetConnectivity() == Connectivity::EIGHT) {
+    Path path = m_Fallback.CalculatePath(start_world, end_world);
+    CountNested(m_Fallback.GetLastStats());
+    return path;
+  }
+
+  const TilePos start = m_Map->WorldToTile(start_world);
+  const TilePos end = m_Map->WorldToTile(end_world);
+
+  if (!m_Map->IsTilePosValid(start) || !m_Map->IsTilePosValid(end))
+    return {};
+  if (start == end)
+    return {};
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(start, end))
+    return {};
+
+  // clear previous run
+  m_State.Reset(m_Map);
+  m_Frontier.clear();
+  m_ArrivedFrom.resize(m_Map->GetTileCount());
+  if (m_RunsVersion != m_Map->GetVersion()) {
+    BuildRuns();
+    m_RunsVersion = m_Map->GetVersion();
+  }
+
+  const size_t start_idx = m_Map->TileToIndex(start);
+  m_Frontier.push({m_Heuristic(start, end), start, START});
+  CountPush(m_Frontier.size());
+  m_State.Visit(start_idx, 0.0f, start_idx); // sentinel
+  m_ArrivedFrom[start_idx] = 1 << START;
+
+  while (!m_Frontier.empty()) {
+    const JumpEntry current = m_Frontier.top();
+    m_Frontier.pop();
+
+    if (current.tile == end) // early exit
+      break;
+
+    const size_t current_idx = m_Map->TileToIndex(current.tile);
+    const float current_cost = m_State.GetCost(current_idx);
+    // skip stale entries, the tile was reached cheaper in the meantime
+    if (current.cost > current_cost + m_Heuristic(current.tile, end))
+      continue;
+    m_ExpandedNodes++;
+
+    // canonical successors, depending on how we got here
+    std::array<bool, 4> successors{};
+    if (current.direction == START) {
+      successors.fill(true);
+    } else if (IsVertical(current.direction)) {
+      const TilePos previous = current.tile - kSteps[current.direction];
+      successors[current.direction] = true;
+      successors[RIGHT] = IsForced(previous, current.tile, RIGHT);
+      successors[LEFT] = IsForced(previous, current.tile, LEFT);
+    } else {
+      successors[current.direction] = true;
+      successors[DOWN] = true;
+      successors[UP] = true;
+    }
+
+    for (uint8_t d = 0; d < kSteps.size(); d++) {
+      if (!successors[d])
+        continue;
+      const auto direction = static_cast<Direction>(d);
+      float jump_cost = 0.0f;
+      const auto jump_point = Jump(current.tile, direction, end, jump_cost);
+      if (!jump_point)
+        continue;
+
+      const size_t next_idx = m_Map->TileToIndex(*jump_point);
+      const float newCost = current_cost + jump_cost;
+      const uint8_t direction_bit = 1 << direction;
+      if (!m_State.IsVisited(next_idx) ||
+          newCost < m_State.GetCost(next_idx)) {
+        m_State.Visit(next_idx, newCost, current_idx);
+        m_ArrivedFrom[next_idx] = direction_bit;
+      } else if (newCost == m_State.GetCost(next_idx) &&
+                 !(m_ArrivedFrom[next_idx] & direction_bit)) {
+        // equally good, but arriving from another direction allows
+        // different successors, so it has to be expanded as well
+        m_ArrivedFrom[next_idx] |= direction_bit;
+      } else {
+        continue;
+      }
+      m_Frontier.push(
+          {newCost + m_Heuristic(*jump_point, end), *jump_point, direction});
+      CountPush(m_Frontier.size());
+    }
+  }
+
+  return ReconstructPath(start, end);
+}
+
+} // namespace pathfinder
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "astar.hpp"
+#include "base.hpp"
+#include "search_state.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Jump Point Search for 4-connected grids with weighted tiles.
+//
+// Searches only canonical paths: a horizontal run may turn vertical at any
+// tile, but a vertical run only turns horizontal where it is forced to, i.e.
+// where the tile diagonally behind is more expensive than the current one
+// (impassable tiles count as infinitely expensive).
+// Any optimal path can be reordered into such a path without increasing its
+// cost, so the result is optimal. Straight runs are jumped over in one go and
+// only the tiles where a run may end (goal, forced turns, start of a useful
+// vertical run) are inserted into the open list. Inside uniform regions
+// nothing is forced, so only the tiles around cost changes become nodes.
+// The pruning rules only hold for straight moves, on 8-connected maps the
+// search falls back to plain A*.
+class JPS final : public PathFinderBase {
+
+public:
+  JPS(const Map *m) : PathFinderBase(m) {}
+  const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override;
+
+private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
+  // direction index, START means "expand in all directions"
+  enum Direction : uint8_t { DOWN, UP, RIGHT, LEFT, START };
+
+  struct JumpEntry {
+    float cost; // f = g + h
+    TilePos tile;
+    Direction direction; // direction we arrived from
+
+    bool operator>(const JumpEntry &o) const noexcept {
+      return cost > o.cost;
+    }
+  };
+
+  inline static const std::array<TilePos, 4> kSteps = {
+      TilePos{1, 0}, TilePos{-1, 0}, TilePos{0, 1}, TilePos{0, -1}};
+
+  static bool IsVertical(Direction d) { return d == DOWN || d == UP; }
+
+  // jump from "from" in direction d to the next jump point, cost holds the
+  // cost of all tiles entered on the way
+  std::optional<TilePos> Jump(TilePos from, Direction d, TilePos end,
+                              float &cost) const;
+  // precompute distances to the next query-independent jump point and cost
+  // prefix sums for every tile, so that a jump doesn't walk the tiles
+  void BuildRuns();
+  // cost of all tiles entered when moving straight from "from" to "to",
+  // infinity if one of them is impassable
+  float RunCost(TilePos from, TilePos to, Direction d) const;
+  bool HasForcedNeighbor(TilePos previous, TilePos current) const;
+  bool IsForced(TilePos previous, TilePos current, Direction side) const;
+  Path ReconstructPath(TilePos start, TilePos end) const;
+
+  const std::string_view m_Name = "Jump Point Search";
+  heuristic::Manhattan m_Heuristic;
+  AStar<> m_Fallback{m_Map};
+  SearchState m_State;
+  // directions a tile was reached from at its best cost, bit per Direction
+  std::vector<uint8_t> m_ArrivedFrom;
+  // steps to the next jump point in every direction, 0 if there is none
+  std::vector<std::array<int32_t, 4>> m_JumpDistance;
+  // sum of costs of the tile and all tiles above it (vertical) and left of
+  // it (horizontal), double keeps long runs exact
+  std::vector<std::array<double, 2>> m_PrefixCost;
+  // same as m_PrefixCost, but counts the impassable tiles
+  std::vector<std::array<uint32_t, 2>> m_PrefixBlocked;
+  // map version the runs were built for
+  std::optional<uint64_t> m_RunsVersion;
+  utils::PriorityQueue<JumpEntry> m_Frontier;
+};
+
+} // namespace pathfinder
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "landmarks.hpp"
+
+#include "base.hpp"
+#include "log.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'F', 'L', 'A', 'N', 'D', 'M', 'K'};
+constexpr uint32_t kFormatVersion = 1;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t format_version;
+  uint32_t landmark_count;
+  uint64_t rows;
+  uint64_t cols;
+  uint64_t map_hash;
+};
+
+// full Dijkstra from "source", tiles in other components stay at infinity,
+// the keys only grow so the radix heap can be used
+std::vector<float> Distances(const Map &map, TilePos source) {
+  std::vector<float> distances(map.GetTileCount(),
+                               std::numeric_limits<float>::infinity());
+  utils::RadixHeap<> frontier;
+  distances[map.TileToIndex(source)] = 0.0f;
+  frontier.push({0.0f, source});
+  while (!frontier.empty()) {
+    const utils::QueueEntry current = frontier.top();
+    frontier.pop();
+    if (current.cost > distances[map.TileToIndex(current.tile)])
+      continue; // stale
+    for (const Neighbor &next : map.GetNeighbors(current.tile)) {
+      const float cost = current.cost + next.cost;
+      if (cost < distances[next.index]) {
+        distances[next.index] = cost;
+        frontier.push({cost, next.pos});
+      }
+    }
+  }
+  return distances;
+}
+
+} // namespace
+
+uint64_t Landmarks::HashMap(const Map &map) {
+  // FNV-1a over the size, the connectivity and the cost and passability of
+  // every tile
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  const auto add = [&hash](uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      hash ^= (value >> (8 * i)) & 0xff;
+      hash *= 0x100000001b3ULL;
+    }
+  };
+  add(map.GetRows());
+  add(map.GetCols());
+  add(static_cast<uint64_t>(map.GetConnectivity()));
+  for (size_t i = 0; i < map.GetTileCount(); i++) {
+    const TilePos tile = map.IndexToTile(i);
+    add(std::bit_cast<uint32_t>(map.GetCost(tile)) |
+        static_cast<uint64_t>(map.IsPassable(tile)) << 32);
+  }
+  return hash;
+}
+
+Landmarks Landmarks::Build(const Map &map, size_t count) {
+  Landmarks result;
+  result.m_MapHash = HashMap(map);
+  result.m_MapVersion = map.GetVersion();
+  result.m_Rows = map.GetRows();
+  result.m_Cols = map.GetCols();
+  result.m_TileCount = map.GetTileCount();
+  result.m_Connectivity = map.GetConnectivity();
+  count = std::min(count, map.GetTileCount());
+  if (count == 0)
+    return result;
+
+  // farthest point selection: start at the tile farthest from a corner,
+  // then always take the tile farthest from all landmarks picked so far.
+  // Tiles in components not covered yet are infinitely far, so every
+  // component gets a landmark before any of them gets a second one.
+  std::vector<std::vector<float>> tables;
+  std::vector<float> closest = Distances(map, TilePos{0, 0});
+  for (size_t l = 0; l < count; l++) {
+    std::optional<size_t> farthest;
+    for (size_t i = 0; i < closest.size(); i++) {
+      if (map.IsPassable(map.IndexToTile(i)) &&
+          (!farthest || closest[i] > closest[*farthest]))
+        farthest = i;
+    }
+    if (!farthest)
+      break; // nothing passable
+    const TilePos landmark = map.IndexToTile(*farthest);
+    result.m_Landmarks.push_back(landmark);
+    tables.push_back(Distances(map, landmark));
+    if (l == 0)
+      closest = tables.back();
+    else
+      std::ranges::transform(closest, tables.back(), closest.begin(),
+                             [](float a, float b) { return std::min(a, b); });
+  }
+  count = tables.size();
+
+  // quantize, all landmarks of a tile next to each other
+  result.m_Distances.resize(count * result.m_TileCount);
+  for (size_t l = 0; l < count; l++) {
+    const auto &table = tables[l];
+    float max_distance = 0.0f;
+    for (float distance : table) {
+      if (std::isfinite(distance))
+        max_distance = std::max(max_distance, distance);
+    }
+    const float step = std::max(max_distance / (kUnreachable - 1), 1e-6f);
+    result.m_Steps.push_back(step);
+    for (size_t i = 0; i < table.size(); i++) {
+      // rounded down, the real distance is in [q * step, (q + 1) * step)
+      const float q = std::floor(table[i] / step);
+      result.m_Distances[i * count + l] =
+          std::isfinite(table[i])
+              ? static_cast<uint16_t>(std::min(q, kUnreachable - 1.0f))
+              : kUnreachable;
+    }
+  }
+  LOG_INFO("Built ", count, " landmarks for ", result.m_TileCount, " tiles");
+  return result;
+}
+
+float Landmarks::LowerBound(const Map &map, TilePos from, TilePos to) const {
+  const size_t count = m_Landmarks.size();
+  const size_t from_idx = map.TileToIndex(from) * count;
+  const size_t to_idx = map.TileToIndex(to) * count;
+  const float cost_difference = map.GetCost(to) - map.GetCost(from);
+  const bool reversible = m_Connectivity == Connectivity::FOUR;
+
+  float bound = 0.0f;
+  for (size_t l = 0; l < count; l++) {
+    const uint16_t qv = m_Distances[from_idx + l];
+    const uint16_t qt = m_Distances[to_idx + l];
+    if (qv == kUnreachable || qt == kUnreachable)
+      continue;
+    const auto diff = static_cast<float>(static_cast<int32_t>(qt) - qv);
+    // d(L, t) - d(L, v) > (qt - qv - 1) * step
+    bound = std::max(bound, (diff - 1.0f) * m_Steps[l]);
+    // d(v, L) - d(t, L) = d(L, v) - d(L, t) + cost(t) - cost(v)
+    if (reversible)
+      bound = std::max(bound, (-diff - 1.0f) * m_Steps[l] + cost_difference);
+  }
+  return bound;
+}
+
+std::expected<void, std::string>
+Landmarks::Save(const std::filesystem::path &path) const {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file)
+    return std::unexpected("Cannot open " + path.string() + " for writing");
+
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.format_version = kFormatVersion;
+  header.landmark_count = static_cast<uint32_t>(m_Landmarks.size());
+  header.rows = m_Rows;
+  header.cols = m_Cols;
+  header.map_hash = m_MapHash;
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (const TilePos &landmark : m_Landmarks) {
+    const int32_t xy[2] = {landmark.x(), landmark.y()};
+    file.write(reinterpret_cast<const char *>(xy), sizeof(xy));
+  }
+  file.write(reinterpret_cast<const char *>(m_Steps.data()),
+             static_cast<std::streamsize>(m_Steps.size() * sizeof(float)));
+  file.write(reinterpret_cast<const char *>(m_Distances.data()),
+             static_cast<std::streamsize>(m_Distances.size() *
+                                          sizeof(uint16_t)));
+  if (!file)
+    return std::unexpected("Writing " + path.string() + " failed");
+  return {};
+}
+
+std::expected<Landmarks, std::string>
+Landmarks::Load(const std::filesystem::path &path, const Map &map) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return std::unexpected("Cannot open " + path.string());
+
+  FileHeader header{};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!file || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.format_version != kFormatVersion)
+    return std::unexpected(path.string() + " is not a landmark file");
+  if (header.rows != map.GetRows() || header.cols != map.GetCols() ||
+      header.map_hash != HashMap(map))
+    return std::unexpected(path.string() + " was built for a different map");
+  // the count sizes the tables, a broken one must not allocate them
+  if (header.landmark_count == 0 ||
+      header.landmark_count > map.GetTileCount())
+    return std::unexpected(path.string() + " has a broken landmark count");
+
+  Landmarks result;
+  result.m_MapHash = header.map_hash;
+  result.m_MapVersion = map.GetVersion();
+  result.m_Rows = map.GetRows();
+  result.m_Cols = map.GetCols();
+  result.m_TileCount = map.GetTileCount();
+  result.m_Connectivity = map.GetConnectivity();
+  const size_t count = header.landmark_count;
+  for (size_t l = 0; l < count; l++) {
+    int32_t xy[2];
+    file.read(reinterpret_cast<char *>(xy), sizeof(xy));
+    if (!file)
+      return std::unexpected(path.string() + " is truncated");
+    result.m_Landmarks.emplace_back(xy[0], xy[1]);
+    if (!map.IsTilePosValid(result.m_Landmarks.back()))
+      return std::unexpected(path.string() + " has a landmark off the map");
+  }
+  result.m_Steps.resize(count);
+  file.read(reinterpret_cast<char *>(result.m_Steps.data()),
+            static_cast<std::streamsize>(count * sizeof(float)));
+  result.m_Distances.resize(count * result.m_TileCount);
+  file.read(reinterpret_cast<char *>(result.m_Distances.data()),
+            static_cast<std::streamsize>(result.m_Distances.size() *
+                                         sizeof(uint16_t)));
+  if (!file)
+    return std::unexpected(path.string() + " is truncated");
+  return result;
+}
+
+Landmarks Landmarks::LoadOrBuild(const std::filesystem::path &path,
+                                 const Map &map, size_t count) {
+  auto loaded = Load(path, map);
+  if (loaded && loaded->GetLandmarks().size() == count)
+    return std::move(loaded.value());
+  if (!loaded)
+    LOG_INFO("Rebuilding landmarks: ", loaded.error());
+
+  Landmarks result = Build(map, count);
+  if (auto saved = result.Save(path); !saved)
+    LOG_WARNING(saved.error());
+  return result;
+}
+
+std::shared_ptr<const Landmarks> Landmarks::Shared(const Map &map,
+                                                   size_t count) {
+  static std::mutex mutex;
+  static std::vector<std::weak_ptr<const Landmarks>> shared;
+
+  // the hash tells maps apart, a new map can reuse the address of an old one
+  const uint64_t hash = HashMap(map);
+  std::lock_guard lock(mutex);
+  std::erase_if(shared, [](const auto &entry) { return entry.expired(); });
+  for (const auto &entry : shared) {
+    auto landmarks = entry.lock();
+    if (landmarks && landmarks->m_MapHash == hash &&
+        landmarks->m_MapVersion == map.GetVersion() &&
+        landmarks->m_Landmarks.size() == count)
+      return landmarks;
+  }
+  auto landmarks = std::make_shared<const Landmarks>(Build(map, count));
+  shared.push_back(landmarks);
+  return landmarks;
+}
+
+namespace heuristic {
+
+float Landmark::operator()(const TilePos &a, const TilePos &b) const {
+  const float estimate = map && map->GetConnectivity() == Connectivity::EIGHT
+                             ? octile(a, b)
+                             : manhattan(a, b);
+  if (!map || !landmarks || landmarks->GetMapVersion() != map->GetVersion())
+    return estimate;
+  return std::max(estimate, landmarks->LowerBound(*map, a, b));
+}
+
+void Landmark::Refresh() {
+  if (map && landmarks && landmarks->GetMapVersion() != map->GetVersion())
+    landmarks = Landmarks::Shared(*map, landmarks->GetLandmarks().size());
+}
+
+} // namespace heuristic
+
+} // namespace pathfinder
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "astar.hpp"
+#include "base.hpp"
+#include "utils.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Distance tables for the ALT heuristic (A*, landmarks, triangle inequality).
+//
+// A few landmark tiles are picked far apart from each other and a full
+// Dijkstra from each of them gives d(L, v) for every tile. Entering a tile
+// costs the cost of the tile, so the distance back to a landmark follows
+// from the same table: d(v, L) = d(L, v) + cost(L) - cost(v). Together they
+// bound the cost of any path from below:
+//   d(v, t) >= d(L, t) - d(L, v)   and   d(v, t) >= d(v, L) - d(t, L)
+// Diagonal moves cost sqrt(2) times the tile entered, which breaks the
+// identity, so on 8-connected maps only the first bound is used.
+// Distances are stored as uint16 in steps of max distance / 65534 per
+// landmark, rounded so the bound stays a lower bound. The tables are only
+// valid for the map content they were built for, Save() and Load() keep
+// them next to the map so they are not rebuilt on every start.
+class Landmarks {
+public:
+  static constexpr size_t kDefaultCount = 8;
+
+  // run one Dijkstra per landmark over the whole map
+  static Landmarks Build(const Map &map, size_t count = kDefaultCount);
+  // fails if the file is broken or was built for a different map
+  static std::expected<Landmarks, std::string>
+  Load(const std::filesystem::path &path, const Map &map);
+  // load if possible, otherwise build and save for the next time
+  static Landmarks LoadOrBuild(const std::filesystem::path &path,
+                               const Map &map, size_t count = kDefaultCount);
+  std::expected<void, std::string>
+  Save(const std::filesystem::path &path) const;
+  // Tables of the current map content, built once and shared by every
+  // caller while someone holds them. Thread safe, concurrent callers wait
+  // for one build instead of running their own.
+  static std::shared_ptr<const Landmarks> Shared(const Map &map,
+                                                 size_t count = kDefaultCount);
+
+  // lower bound of the cost from "from" to "to", 0 if unknown
+  float LowerBound(const Map &map, TilePos from, TilePos to) const;
+
+  const std::vector<TilePos> &GetLandmarks() const { return m_Landmarks; }
+  // version of the map the tables are valid for
+  uint64_t GetMapVersion() const { return m_MapVersion; }
+
+private:
+  static constexpr uint16_t kUnreachable = UINT16_MAX;
+
+  Landmarks() = default;
+  static uint64_t HashMap(const Map &map);
+
+  uint64_t m_MapHash = 0;
+  uint64_t m_MapVersion = 0;
+  size_t m_Rows = 0;
+  size_t m_Cols = 0;
+  size_t m_TileCount = 0;
+  Connectivity m_Connectivity = Connectivity::FOUR;
+  std::vector<TilePos> m_Landmarks;
+  // size of one quantization step per landmark
+  std::vector<float> m_Steps;
+  // quantized d(L, v), all landmarks of a tile next to each other
+  std::vector<uint16_t> m_Distances;
+};
+
+namespace heuristic {
+
+// ALT heuristic, the better of the landmark bound and the grid distance
+// (see Grid). Falls back to the latter while the map was changed after the
+// tables were made, AStar calls Refresh at the start of every search.
+struct Landmark {
+  static constexpr std::string_view kName = "A* (landmarks)";
+
+  float operator()(const TilePos &a, const TilePos &b) const;
+  // swaps outdated tables for the shared ones of the current map version,
+  // the first search after a change builds them (see Landmarks::Shared)
+  void Refresh();
+  const Map *map = nullptr;
+  std::shared_ptr<const Landmarks> landmarks;
+  Manhattan manhattan;
+  Octile octile;
+};
+
+} // namespace heuristic
+
+// implemented in astar.cpp
+extern template class AStar<heuristic::Landmark>;
+
+} // namespace pathfinder
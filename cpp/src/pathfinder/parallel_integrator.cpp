@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "parallel_integrator.hpp"
+
+#include "flow_field.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+namespace {
+
+constexpr float kUnreachable = FlowField::kUnreachable;
+
+// square blocks of tiles, numbered row by row
+struct BlockGrid {
+  BlockGrid(const Map &map, size_t block_size)
+      : rows(map.GetRows()), cols(map.GetCols()), size(block_size),
+        block_rows((rows + size - 1) / size),
+        block_cols((cols + size - 1) / size) {}
+
+  size_t BlockOf(size_t index) const {
+    return index / cols / size * block_cols + index % cols / size;
+  }
+  // blocks of one colour are a block apart in both directions
+  size_t Colour(size_t block) const {
+    return block / block_cols % 2 * 2 + block % block_cols % 2;
+  }
+
+  size_t rows;
+  size_t cols;
+  size_t size;
+  size_t block_rows;
+  size_t block_cols;
+};
+
+// Reverse Dijkstra inside one block, from the tiles of its edge (and the
+// target if it's in the block). Improvements of tiles just outside go to
+// the blocks they belong to, which are marked dirty. Returns the number of
+// expanded tiles.
+size_t SearchBlock(const Map &map, const BlockGrid &grid, size_t block,
+                   size_t target_idx, std::vector<float> &costs,
+                   std::vector<uint32_t> &next,
+                   std::vector<std::atomic<uint8_t>> &dirty,
+                   utils::PriorityQueue<> &frontier) {
+  const size_t r0 = block / grid.block_cols * grid.size;
+  const size_t c0 = block % grid.block_cols * grid.size;
+  const size_t r1 = std::min(r0 + grid.size, grid.rows);
+  const size_t c1 = std::min(c0 + grid.size, grid.cols);
+  auto inside = [&](TilePos p) {
+    const auto r = static_cast<size_t>(p.x());
+    const auto c = static_cast<size_t>(p.y());
+    return r >= r0 && r < r1 && c >= c0 && c < c1;
+  };
+  auto seed = [&](size_t index) {
+    if (costs[index] != kUnreachable)
+      frontier.push({costs[index], map.IndexToTile(index)});
+  };
+
+  // the inside of the block is settled since its last search, only its
+  // edge could have been improved by the blocks around it
+  frontier.clear();
+  for (size_t r = r0; r < r1; r++) {
+    if (r == r0 || r == r1 - 1) {
+      for (size_t c = c0; c < c1; c++)
+        seed(r * grid.cols + c);
+    } else {
+      seed(r * grid.cols + c0);
+      seed(r * grid.cols + c1 - 1);
+    }
+  }
+  if (grid.BlockOf(target_idx) == block)
+    seed(target_idx);
+
+  size_t expanded = 0;
+  while (!frontier.empty()) {
+    const utils::QueueEntry current = frontier.top();
+    frontier.pop();
+
+    const size_t current_idx = map.TileToIndex(current.tile);
+    if (current.cost > costs[current_idx]) // stale entry
+      continue;
+    expanded++;
+
+    // the same costs as FlowField::Integrate
+    const float step_cost = map.GetCost(current.tile);
+    for (const Neighbor &tile : map.GetNeighbors(current.tile)) {
+      const float newCost = current.cost + tile.step * step_cost;
+      if (newCost < costs[tile.index]) {
+        costs[tile.index] = newCost;
+        next[tile.index] = static_cast<uint32_t>(current_idx);
+        if (inside(tile.pos))
+          frontier.push({newCost, tile.pos});
+        else
+          dirty[grid.BlockOf(tile.index)].store(1, std::memory_order_relaxed);
+      }
+    }
+  }
+  return expanded;
+}
+
+} // namespace
+
+ParallelIntegrator::ParallelIntegrator(const Map *map, size_t thread_count,
+                                       int block_size)
+    : m_Map(map), m_ThreadCount(thread_count),
+      m_BlockSize(std::max(block_size, 2)) {
+  if (m_ThreadCount == 0)
+    m_ThreadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void ParallelIntegrator::Integrate(TilePos target, std::vector<float> &costs,
+                                   std::vector<uint32_t> &next) {
+  m_ExpandedNodes = 0;
+  m_Rounds = 0;
+  if (!m_Map) {
+    costs.clear();
+    next.clear();
+    return;
+  }
+  costs.assign(m_Map->GetTileCount(), kUnreachable);
+  next.assign(m_Map->GetTileCount(), 0);
+  if (!m_Map->IsTilePosValid(target))
+    return;
+
+  const BlockGrid grid(*m_Map, static_cast<size_t>(m_BlockSize));
+  const size_t target_idx = m_Map->TileToIndex(target);
+  costs[target_idx] = 0.0f;
+  next[target_idx] = static_cast<uint32_t>(target_idx);
+
+  // blocks with improved edges, by block number
+  std::vector<std::atomic<uint8_t>> dirty(grid.block_rows * grid.block_cols);
+  // blocks of the current turn, the threads take them one by one
+  std::vector<uint32_t> turn{static_cast<uint32_t>(grid.BlockOf(target_idx))};
+  std::atomic<size_t> next_block = 0;
+  size_t colour = grid.Colour(turn.front());
+  bool done = false;
+
+  // runs on one thread once all of them finished the turn
+  auto end_turn = [&]() noexcept {
+    m_Rounds++;
+    turn.clear();
+    next_block.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < 4 && turn.empty(); i++) {
+      colour = (colour + 1) % 4;
+      for (size_t br = colour / 2; br < grid.block_rows; br += 2) {
+        for (size_t bc = colour % 2; bc < grid.block_cols; bc += 2) {
+          const size_t block = br * grid.block_cols + bc;
+          if (dirty[block].exchange(0, std::memory_order_relaxed))
+            turn.push_back(static_cast<uint32_t>(block));
+        }
+      }
+    }
+    done = turn.empty();
+  };
+  std::barrier turn_done(static_cast<std::ptrdiff_t>(m_ThreadCount),
+                         end_turn);
+
+  std::atomic<size_t> expanded = 0;
+  auto work = [&]() {
+    utils::PriorityQueue<> frontier;
+    size_t local_expanded = 0;
+    while (true) {
+      for (size_t i = next_block.fetch_add(1, std::memory_order_relaxed);
+           i < turn.size();
+           i = next_block.fetch_add(1, std::memory_order_relaxed)) {
+        local_expanded += SearchBlock(*m_Map, grid, turn[i], target_idx,
+                                      costs, next, dirty, frontier);
+      }
+      turn_done.arrive_and_wait();
+      if (done)
+        break;
+    }
+    expanded += local_expanded;
+  };
+
+  {
+    // the calling thread works too, the others are joined at the end
+    std::vector<std::jthread> workers;
+    for (size_t i = 1; i < m_ThreadCount; i++)
+      workers.emplace_back(work);
+    work();
+  }
+  m_ExpandedNodes = expanded;
+}
+
+} // namespace pathfinder
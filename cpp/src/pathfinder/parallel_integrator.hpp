@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Single-source shortest paths to one tile on several threads, for the
+// integration fields of huge maps.
+//
+// The map is cut into square blocks coloured in a 2x2 pattern, blocks of
+// one colour never touch. Colours take turns: the threads share the dirty
+// blocks of the current colour and run a Dijkstra inside each of them,
+// seeded with the block's edge, and write the improvements they find into
+// the edge of the blocks around it, which marks those blocks dirty. Two
+// blocks of one colour are a block apart, so they never write the same
+// tile. A std::barrier ends every turn and its completion picks the next
+// colour with dirty blocks, the integration ends when none is left.
+//
+// Every cost is the sum of the same moves in the same order as in the
+// reverse Dijkstra of FlowField, the costs match it exactly unless two
+// paths of equal cost round differently. Only the next tiles of equally
+// cheap paths may differ.
+class ParallelIntegrator {
+public:
+  static constexpr int kDefaultBlockSize = 64;
+
+  // thread_count 0 uses every core, blocks are at least 2 tiles wide
+  ParallelIntegrator(const Map *map, size_t thread_count = 0,
+                     int block_size = kDefaultBlockSize);
+
+  // Cost of the best path from every tile to the target and the next tile
+  // on it (the target points to itself), by Map::TileToIndex. Tiles without
+  // a path get FlowField::kUnreachable.
+  void Integrate(TilePos target, std::vector<float> &costs,
+                 std::vector<uint32_t> &next);
+
+  size_t GetThreadCount() const { return m_ThreadCount; }
+  int GetBlockSize() const { return m_BlockSize; }
+  // tiles expanded by the block searches of the last run, a tile can be
+  // expanded again when a cheaper path reaches its block later
+  size_t GetExpandedNodeCount() const { return m_ExpandedNodes; }
+  // colour turns of the last run
+  size_t GetRoundCount() const { return m_Rounds; }
+
+private:
+  const Map *m_Map;
+  size_t m_ThreadCount;
+  int m_BlockSize;
+  size_t m_ExpandedNodes = 0;
+  size_t m_Rounds = 0;
+};
+
+} // namespace pathfinder
@@ -0,0 +1,141 @@
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include "path_cache.hpp"
+
+#include "base.hpp"
+#include "log.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+std::size_t PathCache::KeyHash::operator()(const Key &key) const noexcept {
+  std::size_t h = TilePosHash{}(key.start);
+  const auto combine = [&h](std::size_t v) {
+    h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+  };
+  combine(TilePosHash{}(key.goal));
+  combine(static_cast<std::size_t>(key.type));
+  combine(std::hash<uint64_t>{}(key.map_version));
+  return h;
+}
+
+PathCache::PathCache(size_t memory_cap) : m_MemoryCap(memory_cap) {}
+
+size_t PathCache::EntryMemoryUsage(const Path &path) {
+  // std::list nodes link both ways, the hash nodes link forwards and cache
+  // the hash
+  constexpr size_t list_node = sizeof(Entries::value_type) + 2 * sizeof(void *);
+  constexpr size_t index_node =
+      sizeof(std::pair<const Key, Entries::iterator>) + sizeof(void *) +
+      sizeof(std::size_t);
+  return utils::memory_usage(path) + list_node + index_node + sizeof(void *);
+}
+
+const Path *PathCache::Find(const Key &key) {
+  SetMapVersion(key.map_version);
+  auto it = m_Index.find(key);
+  if (it == m_Index.end()) {
+    m_Misses++;
+    return nullptr;
+  }
+  m_Hits++;
+  // move to the front, the iterator stays valid
+  m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+  return &it->second->second;
+}
+
+void PathCache::Insert(const Key &key, Path path) {
+  if (m_MemoryCap == 0)
+    return;
+  SetMapVersion(key.map_version);
+  if (key.map_version < m_MapVersion)
+    return; // already outdated
+
+  m_MemoryUsage += EntryMemoryUsage(path);
+  if (auto it = m_Index.find(key); it != m_Index.end()) {
+    m_MemoryUsage -= EntryMemoryUsage(it->second->second);
+    it->second->second = std::move(path);
+    m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+  } else {
+    m_Entries.emplace_front(key, std::move(path));
+    m_Index.emplace(key, m_Entries.begin());
+  }
+  Evict();
+}
+
+void PathCache::Clear() {
+  m_Entries.clear();
+  m_Index.clear();
+  m_MemoryUsage = 0;
+}
+
+void PathCache::SetMemoryCap(size_t memory_cap) {
+  m_MemoryCap = memory_cap;
+  if (m_MemoryCap == 0)
+    Clear();
+  Evict();
+}
+
+void PathCache::Evict() {
+  while (m_MemoryUsage > m_MemoryCap && m_Entries.size() > 1) {
+    m_MemoryUsage -= EntryMemoryUsage(m_Entries.back().second);
+    m_Index.erase(m_Entries.back().first);
+    m_Entries.pop_back();
+  }
+}
+
+void PathCache::SetMapVersion(uint64_t version) {
+  if (version <= m_MapVersion)
+    return;
+  if (!m_Entries.empty())
+    LOG_DEBUG("map changed, dropping ", m_Entries.size(), " cached paths");
+  Clear();
+  m_MapVersion = version;
+}
+
+CachedPathFinder::CachedPathFinder(const Map *m, PathFinderType type,
+                                   std::shared_ptr<PathCache> cache)
+    : CachedPathFinder(m, utils::create(type, m), type, std::move(cache)) {}
+
+CachedPathFinder::CachedPathFinder(const Map *m,
+                                   std::unique_ptr<PathFinderBase> pathfinder,
+                                   PathFinderType type,
+                                   std::shared_ptr<PathCache> cache)
+    : PathFinderBase(m), m_Type(type), m_PathFinder(std::move(pathfinder)),
+      m_Cache(cache ? std::move(cache) : std::make_shared<PathCache>()) {}
+
+const std::string_view &CachedPathFinder::GetName() const {
+  static const std::string_view none = "None";
+  return m_PathFinder ? m_PathFinder->GetName() : none;
+}
+
+Path CachedPathFinder::FindPath(WorldPos start, WorldPos end) {
+  if (!m_Map || !m_PathFinder)
+    return {};
+
+  const PathCache::Key key{m_Map->WorldToTile(start), m_Map->WorldToTile(end),
+                           m_Type, m_Map->GetVersion()};
+  if (const Path *path = m_Cache->Find(key))
+    return *path;
+
+  Path path = m_PathFinder->CalculatePath(start, end);
+  CountNested(m_PathFinder->GetLastStats());
+  m_Cache->Insert(key, path);
+  return path;
+}
+
+Path CachedPathFinder::CalculateAbstractPath(WorldPos start, WorldPos end) {
+  return m_PathFinder ? m_PathFinder->CalculateAbstractPath(start, end)
+                      : Path{};
+}
+
+Path CachedPathFinder::RefineSegment(WorldPos from, WorldPos to) {
+  return m_PathFinder ? m_PathFinder->RefineSegment(from, to) : Path{};
+}
+
+} // namespace pathfinder
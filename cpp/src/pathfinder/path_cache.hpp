@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "base.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Least recently used cache of finished paths.
+//
+// Entries are keyed by the start and goal tile, the algorithm and the map
+// version the path was calculated for. A path is only valid for its map
+// version, so the first lookup for a newer version drops everything. The
+// least recently used paths are evicted once the entries take more than the
+// memory cap, the most recent one is always kept. An entry counts its points
+// and its nodes in the list and the index, so empty paths of unreachable
+// goals count too. A cap of 0 turns the cache off. Not thread safe.
+class PathCache {
+public:
+  static constexpr size_t kDefaultMemoryCap = 4 * 1024 * 1024;
+
+  struct Key {
+    TilePos start;
+    TilePos goal;
+    PathFinderType type;
+    uint64_t map_version;
+
+    bool operator==(const Key &) const = default;
+  };
+
+  explicit PathCache(size_t memory_cap = kDefaultMemoryCap);
+
+  // cached path or nullptr, the pointer is valid until the next Insert()
+  const Path *Find(const Key &key);
+  void Insert(const Key &key, Path path);
+  void Clear();
+
+  // bytes of an entry holding the path: its points, the list node and the
+  // index node with its bucket
+  static size_t EntryMemoryUsage(const Path &path);
+
+  // evicts right away if the cache holds more than the new cap
+  void SetMemoryCap(size_t memory_cap);
+  size_t GetMemoryCap() const { return m_MemoryCap; }
+  // bytes held by the cached entries, see EntryMemoryUsage
+  size_t GetMemoryUsage() const { return m_MemoryUsage; }
+  size_t GetSize() const { return m_Entries.size(); }
+  size_t GetHitCount() const { return m_Hits; }
+  size_t GetMissCount() const { return m_Misses; }
+
+private:
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const noexcept;
+  };
+  using Entries = std::list<std::pair<Key, Path>>;
+
+  // drop entries of older map versions
+  void SetMapVersion(uint64_t version);
+  // drop the least recently used paths until the cache fits the cap
+  void Evict();
+
+  size_t m_MemoryCap;
+  size_t m_MemoryUsage = 0;
+  size_t m_Hits = 0;
+  size_t m_Misses = 0;
+  uint64_t m_MapVersion = 0;
+  // most recently used first
+  Entries m_Entries;
+  std::unordered_map<Key, Entries::iterator, KeyHash> m_Index;
+};
+
+// Pathfinder that answers repeated queries from a PathCache and asks the
+// wrapped pathfinder otherwise. Several wrappers (e.g. of different types)
+// can share one cache.
+class CachedPathFinder final : public PathFinderBase {
+
+public:
+  // wraps the pathfinder utils::create builds for the type
+  CachedPathFinder(const Map *m, PathFinderType type,
+                   std::shared_ptr<PathCache> cache = nullptr);
+  // Wraps any pathfinder, its paths are cached under "type". Wrappers that
+  // share a cache need distinct types for differently configured
+  // pathfinders (e.g. weights), or they get each other's paths.
+  CachedPathFinder(const Map *m, std::unique_ptr<PathFinderBase> pathfinder,
+                   PathFinderType type,
+                   std::shared_ptr<PathCache> cache = nullptr);
+  const std::string_view &GetName() const override;
+  size_t GetMemoryUsage() const override {
+    return m_PathFinder ? m_PathFinder->GetMemoryUsage() : 0;
+  }
+  // the cache keeps no bounds, hits repeat the one of the last search
+  float GetSuboptimality() const override {
+    return m_PathFinder ? m_PathFinder->GetSuboptimality() : 1.0f;
+  }
+
+  // waypoints and segments are not cached, they go to the wrapped pathfinder
+  Path CalculateAbstractPath(WorldPos start, WorldPos end) override;
+  Path RefineSegment(WorldPos from, WorldPos to) override;
+
+  const PathCache &GetCache() const { return *m_Cache; }
+
+private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
+  const PathFinderType m_Type;
+  std::unique_ptr<PathFinderBase> m_PathFinder;
+  std::shared_ptr<PathCache> m_Cache;
+};
+
+} // namespace pathfinder
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "request_service.hpp"
+
+#include "base.hpp"
+#include "log.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+PathRequestService::PathRequestService(const Map *map, size_t thread_count)
+    : m_Map(map) {
+  if (thread_count == 0) {
+    // leave one core for the game loop
+    const size_t cores = std::thread::hardware_concurrency();
+    thread_count = std::clamp<size_t>(cores > 1 ? cores - 1 : 1, 1, 4);
+  }
+  LOG_DEBUG("starting ", thread_count, " path request workers");
+  for (size_t i = 0; i < thread_count; i++) {
+    m_Workers.emplace_back(
+        [this](std::stop_token stop) { WorkerLoop(stop); });
+  }
+}
+
+PathRequestService::~PathRequestService() {
+  // stop all workers before the first join
+  for (auto &worker : m_Workers)
+    worker.request_stop();
+}
+
+RequestId PathRequestService::Submit(WorldPos start, WorldPos goal,
+                                     PathFinderType type) {
+  RequestId id;
+  {
+    std::lock_guard lock(m_Mutex);
+    id = ++m_LastId;
+    m_Requests.push_back({id, start, goal, type});
+  }
+  m_RequestAdded.notify_one();
+  return id;
+}
+
+std::vector<PathResult> PathRequestService::TakeResults() {
+  std::lock_guard lock(m_Mutex);
+  return std::exchange(m_Results, {});
+}
+
+void PathRequestService::Wait() {
+  std::unique_lock lock(m_Mutex);
+  m_RequestDone.wait(
+      lock, [this] { return m_Requests.empty() && m_Running == 0; });
+}
+
+size_t PathRequestService::GetPendingCount() {
+  std::lock_guard lock(m_Mutex);
+  return m_Requests.size() + m_Running;
+}
+
+std::vector<PathResult>
+PathRequestService::SolveBatch(std::span<const PathRequest> requests) {
+  std::vector<PathResult> results(requests.size());
+  if (requests.empty())
+    return results;
+
+  std::lock_guard batch_lock(m_BatchMutex);
+  Batch batch{requests, results};
+  {
+    std::lock_guard lock(m_Mutex);
+    m_Batch = &batch;
+  }
+  m_RequestAdded.notify_all();
+
+  // the batch lives on this stack, wait for the last worker to let go of it
+  std::unique_lock lock(m_Mutex);
+  m_RequestDone.wait(lock, [&batch] {
+    return batch.done == batch.requests.size() && batch.workers == 0;
+  });
+  m_Batch = nullptr;
+  return results;
+}
+
+void PathRequestService::WorkerLoop(std::stop_token stop) {
+  SearchContext context(m_Map, &m_Stats);
+  while (true) {
+    PathRequest request;
+    Batch *batch = nullptr;
+    {
+      std::unique_lock lock(m_Mutex);
+      m_RequestAdded.wait(lock, stop, [this] {
+        return !m_Requests.empty() || HasBatchWork();
+      });
+      if (stop.stop_requested())
+        return;
+      if (HasBatchWork()) {
+        batch = m_Batch;
+        batch->workers++;
+      } else {
+        request = m_Requests.front();
+        m_Requests.pop_front();
+        m_Running++;
+      }
+    }
+
+    if (batch) {
+      SolveBatchPart(*batch, context);
+      continue;
+    }
+
+    PathResult result = context.Solve(request, true);
+
+    {
+      std::lock_guard lock(m_Mutex);
+      m_Results.push_back(std::move(result));
+      m_Running--;
+    }
+    m_RequestDone.notify_all();
+  }
+}
+
+bool PathRequestService::HasBatchWork() const {
+  return m_Batch && m_Batch->next.load(std::memory_order_relaxed) <
+                        m_Batch->requests.size();
+}
+
+void PathRequestService::SolveBatchPart(Batch &batch,
+                                        SearchContext &context) {
+  // Claim one request at a time, queries differ a lot in length and small
+  // claims keep the workers busy until the end. Every result has its own
+  // slot, so only the counters need the lock.
+  size_t solved = 0;
+  for (size_t i = batch.next++; i < batch.requests.size(); i = batch.next++) {
+    batch.results[i] = context.Solve(batch.requests[i], false);
+    solved++;
+  }
+  {
+    std::lock_guard lock(m_Mutex);
+    batch.done += solved;
+    batch.workers--;
+  }
+  m_RequestDone.notify_all();
+}
+
+PathFinderBase *SearchContext::Get(PathFinderType type) {
+  const auto index = static_cast<size_t>(type);
+  if (index >= m_PathFinders.size())
+    return nullptr;
+  auto &pathfinder = m_PathFinders[index];
+  if (!pathfinder)
+    pathfinder = utils::create(type, m_Map);
+  return pathfinder.get();
+}
+
+PathResult SearchContext::Solve(const PathRequest &request, bool waypoints) {
+  PathResult result{request.id, {}, {}, {}};
+  PathFinderBase *pathfinder = Get(request.type);
+  if (!pathfinder)
+    return result;
+
+  if (waypoints)
+    result.waypoints =
+        pathfinder->CalculateAbstractPath(request.start, request.goal);
+  if (result.waypoints.empty()) {
+    result.path = pathfinder->CalculatePath(request.start, request.goal);
+    result.stats = pathfinder->GetLastStats();
+    if (m_Stats)
+      m_Stats->Add(request.type, pathfinder->GetName(), result.stats);
+  }
+  return result;
+}
+
+} // namespace pathfinder
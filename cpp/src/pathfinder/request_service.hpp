@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "base.hpp"
+#include "search_stats.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// id of a submitted request, 0 is never used
+using RequestId = uint64_t;
+
+struct PathRequest {
+  RequestId id;
+  WorldPos start;
+  WorldPos goal;
+  PathFinderType type;
+};
+
+struct PathResult {
+  RequestId id;
+  // waypoints if the pathfinder is hierarchical (see
+  // PathFinderBase::CalculateAbstractPath), otherwise the full path
+  Path waypoints;
+  Path path;
+  // measurements of the search, empty for waypoints
+  SearchStats stats;
+};
+
+// Pathfinders of one thread, created on first use. A pathfinder keeps the
+// state of its query in members (search state, frontier) and only reads the
+// map, so every thread needs its own instance of each type while all of
+// them share the map. The instances are reused, the buffers stay allocated
+// between queries.
+class SearchContext {
+public:
+  // the statistics of every full path query go to "stats" if set
+  SearchContext(const Map *map, SearchStatsTable *stats = nullptr)
+      : m_Map(map), m_Stats(stats) {}
+
+  // nullptr for unknown types
+  PathFinderBase *Get(PathFinderType type);
+  // Runs the request. Hierarchical pathfinders only return the waypoints
+  // if "waypoints" is set, otherwise the result has the full path.
+  PathResult Solve(const PathRequest &request, bool waypoints);
+
+private:
+  const Map *m_Map;
+  SearchStatsTable *m_Stats;
+  std::array<std::unique_ptr<PathFinderBase>,
+             static_cast<size_t>(PathFinderType::COUNT)>
+      m_PathFinders;
+};
+
+// Runs path requests on a pool of worker threads, so that slow queries
+// don't stall the game loop.
+//
+// Every worker has its own SearchContext, the map is shared and only read.
+// The map must not be painted while requests are running, call Wait()
+// first.
+class PathRequestService {
+public:
+  // thread_count 0 picks one based on the hardware
+  PathRequestService(const Map *map, size_t thread_count = 0);
+  // queued requests are dropped, running ones are finished first
+  ~PathRequestService();
+
+  PathRequestService(const PathRequestService &) = delete;
+  PathRequestService(PathRequestService &&) = delete;
+  PathRequestService &operator=(const PathRequestService &) = delete;
+  PathRequestService &operator=(PathRequestService &&) = delete;
+
+  RequestId Submit(WorldPos start, WorldPos goal, PathFinderType type);
+  // results finished since the last call, in no particular order
+  std::vector<PathResult> TakeResults();
+  // block until all submitted requests are finished
+  void Wait();
+
+  // Solves all requests on the workers and blocks until they are done.
+  // The results are in the order of the requests and always have the full
+  // path, the same as CalculatePath would return. Submitted requests wait
+  // until the batch is done.
+  std::vector<PathResult> SolveBatch(std::span<const PathRequest> requests);
+
+  size_t GetThreadCount() const { return m_Workers.size(); }
+  size_t GetPendingCount();
+  // statistics of all finished full path queries, per pathfinder type
+  SearchStatsTable &GetStats() { return m_Stats; }
+
+private:
+  // batch being solved, workers claim its requests one by one
+  struct Batch {
+    std::span<const PathRequest> requests;
+    std::vector<PathResult> &results;
+    std::atomic<size_t> next = 0;
+    // guarded by m_Mutex
+    size_t done = 0;
+    size_t workers = 0;
+  };
+
+  void WorkerLoop(std::stop_token stop);
+  // true if the batch has requests nobody claimed yet, needs m_Mutex
+  bool HasBatchWork() const;
+  void SolveBatchPart(Batch &batch, SearchContext &context);
+
+  const Map *m_Map;
+  RequestId m_LastId = 0;
+
+  std::mutex m_Mutex;
+  std::condition_variable_any m_RequestAdded;
+  std::condition_variable m_RequestDone;
+  std::deque<PathRequest> m_Requests;
+  std::vector<PathResult> m_Results;
+  size_t m_Running = 0;
+  Batch *m_Batch = nullptr;
+  // one batch at a time
+  std::mutex m_BatchMutex;
+  SearchStatsTable m_Stats;
+
+  // last member, so the threads are stopped and joined before the rest
+  // is destroyed
+  std::vector<std::jthread> m_Workers;
+};
+
+} // namespace pathfinder
@@ -0,0 +1,44 @@
+#include <algorithm>
+#include <vector>
+
+#include "search_state.hpp"
+
+#include "base.hpp"
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+void SearchState::Reset(const Map *map) {
+  const size_t tile_count = map->GetTileCount();
+  if (m_Nodes.size() != tile_count) {
+    // new map size, start over with fresh nodes
+    m_Nodes.assign(tile_count, Node{0.0f, 0, 0});
+    m_Generation = 0;
+  }
+  m_Generation++;
+  if (m_Generation == 0) {
+    // generation counter wrapped around, old stamps could look valid again
+    std::ranges::fill(m_Nodes, Node{0.0f, 0, 0});
+    m_Generation = 1;
+  }
+}
+
+Path SearchState::ReconstructPath(const Map &map, TilePos start,
+                                  TilePos end) const {
+  const size_t start_idx = map.TileToIndex(start);
+  size_t cur = map.TileToIndex(end);
+  if (!IsVisited(cur))
+    return {}; // end not reached
+
+  Path path;
+  path.push_back(map.TileToWorld(end));
+  while (cur != start_idx) {
+    cur = GetCameFrom(cur);
+    path.push_back(map.TileToWorld(map.IndexToTile(cur)));
+  }
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+} // namespace pathfinder
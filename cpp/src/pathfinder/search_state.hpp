@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "base.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Per-tile bookkeeping of a grid search (cost so far and where we came from).
+// Nodes live in a flat array indexed by Map::TileToIndex, which is allocated
+// once per map size. Every node is stamped with the generation of the search
+// that wrote it, so Reset() only bumps the generation instead of clearing.
+class SearchState {
+public:
+  // prepare for a new search on the given map
+  void Reset(const Map *map);
+
+  bool IsVisited(size_t index) const {
+    return m_Nodes[index].generation == m_Generation;
+  }
+
+  // only valid for visited nodes
+  float GetCost(size_t index) const { return m_Nodes[index].cost; }
+  size_t GetCameFrom(size_t index) const { return m_Nodes[index].came_from; }
+
+  void Visit(size_t index, float cost, size_t came_from) {
+    m_Nodes[index] = {cost, static_cast<uint32_t>(came_from), m_Generation};
+  }
+
+  size_t GetMemoryUsage() const { return m_Nodes.capacity() * sizeof(Node); }
+
+  // follow the came-from links from end back to start
+  Path ReconstructPath(const Map &map, TilePos start, TilePos end) const;
+
+private:
+  struct Node {
+    float cost;
+    uint32_t came_from;
+    uint32_t generation;
+  };
+
+  std::vector<Node> m_Nodes;
+  uint32_t m_Generation = 0;
+};
+
+} // namespace pathfinder
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <mutex>
+
+#include "search_stats.hpp"
+
+#include "base.hpp"
+#include "log.hpp"
+
+namespace pathfinder {
+
+void AggregatedStats::Add(const SearchStats &stats) {
+  queries++;
+  if (stats.path_cost > 0.0f)
+    found++;
+
+  total.expanded_nodes += stats.expanded_nodes;
+  total.pushed_nodes += stats.pushed_nodes;
+  total.peak_frontier += stats.peak_frontier;
+  total.memory_bytes += stats.memory_bytes;
+  total.time_ms += stats.time_ms;
+  total.path_cost += stats.path_cost;
+  total.suboptimality += stats.suboptimality;
+
+  peak.expanded_nodes = std::max(peak.expanded_nodes, stats.expanded_nodes);
+  peak.pushed_nodes = std::max(peak.pushed_nodes, stats.pushed_nodes);
+  peak.peak_frontier = std::max(peak.peak_frontier, stats.peak_frontier);
+  peak.memory_bytes = std::max(peak.memory_bytes, stats.memory_bytes);
+  peak.time_ms = std::max(peak.time_ms, stats.time_ms);
+  peak.path_cost = std::max(peak.path_cost, stats.path_cost);
+  peak.suboptimality = std::max(peak.suboptimality, stats.suboptimality);
+}
+
+SearchStats AggregatedStats::Mean() const {
+  if (queries == 0)
+    return {};
+  SearchStats mean;
+  mean.expanded_nodes = total.expanded_nodes / queries;
+  mean.pushed_nodes = total.pushed_nodes / queries;
+  mean.peak_frontier = total.peak_frontier / queries;
+  mean.memory_bytes = total.memory_bytes / queries;
+  mean.time_ms = total.time_ms / static_cast<double>(queries);
+  mean.suboptimality = total.suboptimality / static_cast<float>(queries);
+  // unreachable goals would drag the mean cost down
+  if (found > 0)
+    mean.path_cost = total.path_cost / static_cast<float>(found);
+  return mean;
+}
+
+void SearchStatsTable::Add(PathFinderType type, std::string_view name,
+                           const SearchStats &stats) {
+  const auto index = static_cast<size_t>(type);
+  if (index >= m_Stats.size())
+    return;
+  std::lock_guard lock(m_Mutex);
+  m_Stats[index].name = name;
+  m_Stats[index].Add(stats);
+}
+
+AggregatedStats SearchStatsTable::Get(PathFinderType type) const {
+  const auto index = static_cast<size_t>(type);
+  if (index >= m_Stats.size())
+    return {};
+  std::lock_guard lock(m_Mutex);
+  return m_Stats[index];
+}
+
+void SearchStatsTable::Clear() {
+  std::lock_guard lock(m_Mutex);
+  m_Stats.fill({});
+}
+
+void SearchStatsTable::Log() const {
+  std::lock_guard lock(m_Mutex);
+  for (const AggregatedStats &stats : m_Stats) {
+    if (stats.queries == 0)
+      continue;
+    const SearchStats mean = stats.Mean();
+    LOG_INFO(stats.name, ": ", stats.queries, " queries, ", stats.found,
+             " found, mean expanded ", mean.expanded_nodes, ", pushed ",
+             mean.pushed_nodes, ", frontier ", mean.peak_frontier,
+             ", time ", mean.time_ms, " ms, cost ", mean.path_cost,
+             ", suboptimality ", mean.suboptimality, " (peak ",
+             stats.peak.suboptimality, "), peak memory ",
+             stats.peak.memory_bytes, " B");
+  }
+}
+
+} // namespace pathfinder
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+
+#include "base.hpp"
+
+namespace pathfinder {
+
+// SearchStats of many queries of one pathfinder type
+struct AggregatedStats {
+  std::string_view name;
+  size_t queries = 0;
+  // queries that returned a path
+  size_t found = 0;
+  // sum of every field
+  SearchStats total{.suboptimality = 0.0f};
+  // largest value of every field
+  SearchStats peak;
+
+  void Add(const SearchStats &stats);
+  // total divided by the number of queries
+  SearchStats Mean() const;
+};
+
+// Collects the statistics of every query per PathFinderType, can be filled
+// from several threads
+class SearchStatsTable {
+public:
+  // name is the one of PathFinderBase::GetName, it must outlive the table
+  void Add(PathFinderType type, std::string_view name,
+           const SearchStats &stats);
+  AggregatedStats Get(PathFinderType type) const;
+  void Clear();
+  // one line for every type that ran a query
+  void Log() const;
+
+private:
+  mutable std::mutex m_Mutex;
+  std::array<AggregatedStats, static_cast<size_t>(PathFinderType::COUNT)>
+      m_Stats;
+};
+
+} // namespace pathfinder
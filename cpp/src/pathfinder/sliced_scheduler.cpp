@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "sliced_scheduler.hpp"
+
+#include "base.hpp"
+#include "log.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+SlicedPathScheduler::SlicedPathScheduler(const Map *map, size_t max_running)
+    : m_Map(map), m_MaxRunning(std::max<size_t>(max_running, 1)) {}
+
+RequestId SlicedPathScheduler::Submit(WorldPos start, WorldPos goal,
+                                      PathFinderType type) {
+  const RequestId id = ++m_LastId;
+  m_Queue.push_back({id, start, goal, type});
+  return id;
+}
+
+void SlicedPathScheduler::Cancel(RequestId id) {
+  std::erase_if(m_Queue,
+                [id](const PathRequest &request) { return request.id == id; });
+  std::erase_if(m_Results,
+                [id](const PathResult &result) { return result.id == id; });
+  auto running = std::ranges::find_if(m_Running, [id](const Search &search) {
+    return search.request.id == id;
+  });
+  if (running != m_Running.end()) {
+    m_Idle[static_cast<size_t>(running->request.type)].push_back(
+        std::move(running->pathfinder));
+    m_Running.erase(running);
+  }
+}
+
+std::unique_ptr<PathFinderBase>
+SlicedPathScheduler::AcquirePathFinder(PathFinderType type) {
+  const auto index = static_cast<size_t>(type);
+  if (index >= m_Idle.size())
+    return nullptr;
+  auto &idle = m_Idle[index];
+  if (idle.empty())
+    return utils::create(type, m_Map);
+  auto pathfinder = std::move(idle.back());
+  idle.pop_back();
+  return pathfinder;
+}
+
+void SlicedPathScheduler::StartQueued() {
+  while (m_Running.size() < m_MaxRunning && !m_Queue.empty()) {
+    const PathRequest request = m_Queue.front();
+    m_Queue.pop_front();
+    auto pathfinder = AcquirePathFinder(request.type);
+    if (!pathfinder) {
+      m_Results.push_back({request.id, {}, {}, {}});
+      continue;
+    }
+    pathfinder->Begin(request.start, request.goal);
+    m_Running.push_back({request, std::move(pathfinder), m_Map->GetVersion()});
+  }
+}
+
+size_t SlicedPathScheduler::Update(size_t max_expansions) {
+  size_t used = 0;
+  // budget left over by searches that finish early goes to the others, and
+  // finished searches make room for queued ones in the same frame
+  while (true) {
+    StartQueued();
+    if (used >= max_expansions || m_Running.empty())
+      break;
+
+    const size_t count = m_Running.size();
+    const size_t share = std::max<size_t>((max_expansions - used) / count, 1);
+    const size_t first = m_NextSlice % count;
+    bool progress = false;
+    size_t sliced = 0;
+    for (; sliced < count && used < max_expansions; sliced++) {
+      Search &search = m_Running[(first + sliced) % count];
+      if (search.map_version != m_Map->GetVersion()) {
+        // the frontier was built on the old map, start over
+        LOG_DEBUG("map changed, restarting request ", search.request.id);
+        search.pathfinder->Begin(search.request.start, search.request.goal);
+        search.map_version = m_Map->GetVersion();
+      }
+      const size_t before = search.pathfinder->GetExpandedNodeCount();
+      const SearchStatus status =
+          search.pathfinder->Step(std::min(share, max_expansions - used));
+      const size_t expanded =
+          search.pathfinder->GetExpandedNodeCount() - before;
+      used += expanded;
+      progress |= expanded > 0;
+      if (status == SearchStatus::IN_PROGRESS)
+        continue;
+
+      m_Results.push_back(
+          {search.request.id, {}, search.pathfinder->TakePath(), {}});
+      m_Idle[static_cast<size_t>(search.request.type)].push_back(
+          std::move(search.pathfinder));
+      progress = true;
+    }
+    m_NextSlice = first + sliced;
+    std::erase_if(m_Running,
+                  [](const Search &search) { return !search.pathfinder; });
+    if (!progress)
+      break;
+  }
+  return used;
+}
+
+std::vector<PathResult> SlicedPathScheduler::TakeResults() {
+  return std::exchange(m_Results, {});
+}
+
+} // namespace pathfinder
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "base.hpp"
+#include "request_service.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Runs path requests on the game loop thread, a slice at a time.
+//
+// Every Update expands at most the given number of nodes in total, shared
+// evenly between the running searches, so the time spent on paths per
+// frame stays bounded no matter how many requests are pending. Only a few
+// searches run at once (each holds per-tile state), the rest wait in a
+// queue. Searches are started over if the map changes under them.
+// Pathfinders without a time-sliced search (see
+// PathFinderBase::IsTimeSliced) run to the end in their first slice and can
+// exceed the budget, better send those to a PathRequestService.
+class SlicedPathScheduler {
+public:
+  static constexpr size_t kDefaultMaxRunning = 8;
+
+  SlicedPathScheduler(const Map *map, size_t max_running = kDefaultMaxRunning);
+
+  SlicedPathScheduler(const SlicedPathScheduler &) = delete;
+  SlicedPathScheduler(SlicedPathScheduler &&) = delete;
+  SlicedPathScheduler &operator=(const SlicedPathScheduler &) = delete;
+  SlicedPathScheduler &operator=(SlicedPathScheduler &&) = delete;
+
+  RequestId Submit(WorldPos start, WorldPos goal, PathFinderType type);
+  // drop a request that is no longer needed, its result never arrives
+  void Cancel(RequestId id);
+  // advance the searches, returns the number of nodes expanded
+  size_t Update(size_t max_expansions);
+  // results finished since the last call, in no particular order
+  std::vector<PathResult> TakeResults();
+
+  size_t GetPendingCount() const { return m_Queue.size() + m_Running.size(); }
+  size_t GetRunningCount() const { return m_Running.size(); }
+
+private:
+  struct Search {
+    PathRequest request;
+    std::unique_ptr<PathFinderBase> pathfinder;
+    uint64_t map_version;
+  };
+
+  // move queued requests to the running searches while there is room
+  void StartQueued();
+  std::unique_ptr<PathFinderBase> AcquirePathFinder(PathFinderType type);
+
+  const Map *m_Map;
+  size_t m_MaxRunning;
+  RequestId m_LastId = 0;
+  std::deque<PathRequest> m_Queue;
+  std::vector<Search> m_Running;
+  // the first search to get a slice in the next Update, so that searches
+  // that don't fit into the budget take turns
+  size_t m_NextSlice = 0;
+  std::vector<PathResult> m_Results;
+  // finished searches give their pathfinder back, allocating the per-tile
+  // search state for every request would cost more than a slice
+  std::array<std::vector<std::unique_ptr<PathFinderBase>>,
+             static_cast<size_t>(PathFinderType::COUNT)>
+      m_Idle;
+};
+
+} // namespace pathfinder
@@ -0,0 +1,115 @@
+#include <cmath>
+
+#include "theta_star.hpp"
+
+#include "base.hpp"
+#include "map.hpp"
+#include "math.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+namespace pathfinder {
+
+namespace {
+
+float distance(TilePos a, TilePos b) {
+  const auto dx = static_cast<float>(a.x() - b.x());
+  const auto dy = static_cast<float>(a.y() - b.y());
+  return std::sqrt(dx * dx + dy * dy);
+}
+
+} // namespace
+
+Path ThetaStar::FindPath(WorldPos start_world, WorldPos end_world) {
+  using QueueEntry = utils::QueueEntry;
+
+  if (!m_Map)
+    return {};
+
+  const TilePos start = m_Map->WorldToTile(start_world);
+  const TilePos end = m_Map->WorldToTile(end_world);
+
+  if (!m_Map->IsTilePosValid(start) || !m_Map->IsTilePosValid(end))
+    return {};
+  if (start == end)
+    return {};
+  // no path between different components, don't even start the search
+  if (!m_Map->IsReachable(start, end))
+    return {};
+
+  // clear previous run
+  m_State.Reset(m_Map);
+  m_Closed.Reset(m_Map);
+  m_Frontier.clear();
+
+  const size_t start_idx = m_Map->TileToIndex(start);
+  m_Frontier.push({m_Heuristic(start, end), start});
+  CountPush(m_Frontier.size());
+  m_State.Visit(start_idx, 0.0f, start_idx); // sentinel
+
+  while (!m_Frontier.empty()) {
+    const QueueEntry current = m_Frontier.top();
+    m_Frontier.pop();
+
+    const size_t current_idx = m_Map->TileToIndex(current.tile);
+    // skip stale entries, the tile was reached cheaper in the meantime
+    if (m_Closed.IsVisited(current_idx) ||
+        current.cost > m_State.GetCost(current_idx) +
+                           m_Heuristic(current.tile, end))
+      continue;
+    VerifyParent(current.tile, current_idx);
+    m_Closed.Visit(current_idx, 0.0f, current_idx);
+
+    if (current.tile == end) // early exit
+      break;
+    m_ExpandedNodes++;
+
+    // neighbours are optimistically connected to the parent of this tile,
+    // the start has no parent and connects directly
+    const size_t parent_idx = current_idx == start_idx
+                                  ? current_idx
+                                  : m_State.GetCameFrom(current_idx);
+    const TilePos parent = m_Map->IndexToTile(parent_idx);
+    const float parent_cost = m_State.GetCost(parent_idx);
+    for (const Neighbor &next : m_Map->GetNeighbors(current.tile)) {
+      if (m_Closed.IsVisited(next.index))
+        continue;
+      const float newCost =
+          parent_cost + distance(parent, next.pos) * next.cost;
+
+      if (!m_State.IsVisited(next.index) ||
+          newCost < m_State.GetCost(next.index)) {
+        m_State.Visit(next.index, newCost, parent_idx);
+        m_Frontier.push({newCost + m_Heuristic(next.pos, end), next.pos});
+        CountPush(m_Frontier.size());
+      }
+    }
+  }
+
+  // reconstruct path, only the turning points
+  return m_State.ReconstructPath(*m_Map, start, end);
+}
+
+void ThetaStar::VerifyParent(TilePos tile, size_t index) {
+  const size_t parent_idx = m_State.GetCameFrom(index);
+  const float tile_cost = m_Map->GetCost(tile);
+  if (parent_idx == index ||
+      utils::line_of_sight(*m_Map, m_Map->IndexToTile(parent_idx), tile,
+                           tile_cost))
+    return;
+
+  // blocked, take the cheapest expanded neighbour instead (the one that
+  // reached this tile is always one of them)
+  bool found = false;
+  for (const Neighbor &next : m_Map->GetNeighbors(tile)) {
+    if (!m_Closed.IsVisited(next.index))
+      continue;
+    const float cost = m_State.GetCost(next.index) + next.step * tile_cost;
+    if (!found || cost < m_State.GetCost(index)) {
+      m_State.Visit(index, cost, next.index);
+      found = true;
+    }
+  }
+}
+
+} // namespace pathfinder
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string_view>
+
+#include "astar.hpp"
+#include "base.hpp"
+#include "search_state.hpp"
+#include "utils.hpp"
+
+#include "map.hpp"
+#include "math.hpp"
+
+namespace pathfinder {
+
+// Lazy Theta*, any-angle paths over the tile grid.
+//
+// Works like A*, but a reached tile is connected directly to the parent of
+// the expanded tile, with the Euclidean length times the tile cost. Only
+// when the tile is expanded, the straight line to its parent is checked: it
+// may only touch tiles with the same cost as the tile (utils::line_of_sight).
+// If it doesn't, the tile falls back to the best already expanded neighbour.
+// That is one line check per expansion instead of one per neighbour.
+// Parents are always turning points, so the path contains only those instead
+// of one waypoint per tile. The paths are not guaranteed to be the shortest
+// any-angle paths.
+class ThetaStar final : public PathFinderBase {
+
+public:
+  ThetaStar(const Map *m) : PathFinderBase(m) {}
+  const std::string_view &GetName() const override { return m_Name; }
+  size_t GetMemoryUsage() const override {
+    return m_State.GetMemoryUsage() + m_Closed.GetMemoryUsage() +
+           m_Frontier.memory_usage();
+  }
+
+private:
+  Path FindPath(WorldPos start, WorldPos end) override;
+
+  // check the line to the parent of an expanded tile, reconnect it if needed
+  void VerifyParent(TilePos tile, size_t index);
+
+  const std::string_view m_Name = "Theta*";
+  heuristic::Euclidean m_Heuristic;
+  // cost in the search state is g, came-from is the parent (the previous
+  // turning point), the frontier is ordered by f = g + h
+  SearchState m_State;
+  // expanded tiles, their cost is final
+  SearchState m_Closed;
+  utils::PriorityQueue<> m_Frontier;
+};
+
+} // namespace pathfinder
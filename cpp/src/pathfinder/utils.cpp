@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <memory>
 
 #include "utils.hpp"
@@ -6,13 +10,77 @@
 #include "log.hpp"
 #include "map.hpp"
 #include "math.hpp"
+#include "pathfinder/astar.hpp"
 #include "pathfinder/bfs.hpp"
+#include "pathfinder/bidirectional.hpp"
+#include "pathfinder/bounded_astar.hpp"
 #include "pathfinder/dijkstra.hpp"
+#include "pathfinder/dstar_lite.hpp"
 #include "pathfinder/gbfs.hpp"
+#include "pathfinder/hpa.hpp"
+#include "pathfinder/jps.hpp"
+#include "pathfinder/landmarks.hpp"
+#include "pathfinder/theta_star.hpp"
+#include "tile.hpp"
 
 namespace pathfinder {
 namespace utils {
 
+float cheapest_tile_cost() {
+  static const float cost =
+      std::ranges::min_element(tile_types, {}, [](const auto &item) {
+        return item.second.cost;
+      })->second.cost;
+  return cost;
+}
+
+bool line_of_sight(const Map &map, TilePos from, TilePos to, float cost) {
+  const int32_t nx = std::abs(to.x() - from.x());
+  const int32_t ny = std::abs(to.y() - from.y());
+  const int32_t sx = to.x() > from.x() ? 1 : -1;
+  const int32_t sy = to.y() > from.y() ? 1 : -1;
+  const auto is_clear = [&map, cost](TilePos p) {
+    return map.IsPassable(p) && map.GetCost(p) == cost;
+  };
+
+  TilePos p = from;
+  for (int32_t ix = 0, iy = 0; ix < nx || iy < ny;) {
+    // compare where the segment crosses the next vertical and horizontal
+    // tile border, scaled to integers
+    const int64_t decision = static_cast<int64_t>(1 + 2 * ix) * ny -
+                             static_cast<int64_t>(1 + 2 * iy) * nx;
+    if (decision == 0) {
+      // exactly through a corner, both side tiles are touched
+      if (!is_clear(p + TilePos{sx, 0}) || !is_clear(p + TilePos{0, sy}))
+        return false;
+      p += TilePos{sx, sy};
+      ix++;
+      iy++;
+    } else if (decision < 0) {
+      p += TilePos{sx, 0};
+      ix++;
+    } else {
+      p += TilePos{0, sy};
+      iy++;
+    }
+    if (!is_clear(p))
+      return false;
+  }
+  return true;
+}
+
+float path_cost(const Map &map, const Path &path) {
+  float cost = 0.0f;
+  for (size_t i = 1; i < path.size(); i++) {
+    const TilePos a = map.WorldToTile(path[i - 1]);
+    const TilePos b = map.WorldToTile(path[i]);
+    const auto dx = static_cast<float>(a.x() - b.x());
+    const auto dy = static_cast<float>(a.y() - b.y());
+    cost += std::sqrt(dx * dx + dy * dy) * map.GetCost(b);
+  }
+  return cost;
+}
+
 std::unique_ptr<PathFinderBase> create(PathFinderType type, const Map *map) {
   using namespace pathfinder;
   switch (type) {
@@ -21,9 +89,36 @@ std::unique_ptr<PathFinderBase> create(PathFinderType type, const Map *map) {
   case PathFinderType::BFS:
     return std::make_unique<BFS>(map);
   case PathFinderType::DIJKSTRA:
-    return std::make_unique<Dijkstra>(map);
+    return std::make_unique<Dijkstra<>>(map);
   case PathFinderType::GBFS:
     return std::make_unique<GBFS>(map);
+  case PathFinderType::ASTAR:
+    return std::make_unique<AStar<>>(map);
+  case PathFinderType::JPS:
+    return std::make_unique<JPS>(map);
+  case PathFinderType::HPA:
+    return std::make_unique<HPAStar>(map);
+  case PathFinderType::DSTAR_LITE:
+    return std::make_unique<DStarLite>(map);
+  case PathFinderType::BIDIRECTIONAL_DIJKSTRA:
+    return std::make_unique<BidirectionalDijkstra>(map);
+  case PathFinderType::BIDIRECTIONAL_ASTAR:
+    return std::make_unique<BidirectionalAStar>(map);
+  case PathFinderType::THETA_STAR:
+    return std::make_unique<ThetaStar>(map);
+  case PathFinderType::ALT: {
+    // built in memory, the demo map only exists at runtime, and shared by
+    // the pathfinders of every thread
+    heuristic::Landmark landmark;
+    landmark.map = map;
+    if (map)
+      landmark.landmarks = Landmarks::Shared(*map);
+    return std::make_unique<AStar<heuristic::Landmark>>(map, landmark);
+  }
+  case PathFinderType::WEIGHTED_ASTAR:
+    return std::make_unique<WeightedAStar>(map);
+  case PathFinderType::FOCAL_ASTAR:
+    return std::make_unique<FocalAStar>(map);
   case PathFinderType::COUNT:
     LOG_WARNING("Incorrect pathfinder type");
     return nullptr;
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <queue>
+#include <vector>
 
 #include "pathfinder/base.hpp"
 
@@ -18,6 +25,106 @@ struct QueueEntry {
   bool operator>(const QueueEntry &o) const noexcept { return cost > o.cost; }
 };
 
+// Min-heap that keeps its storage between searches
+template <typename T = QueueEntry>
+class PriorityQueue
+    : public std::priority_queue<T, std::vector<T>, std::greater<>> {
+public:
+  void clear() { this->c.clear(); }
+  // all entries, in heap order
+  const std::vector<T> &entries() const { return this->c; }
+  size_t memory_usage() const { return this->c.capacity() * sizeof(T); }
+};
+
+// Radix heap, a drop-in replacement of PriorityQueue for monotone searches.
+//
+// Only works if nothing cheaper than the last popped entry is pushed, which
+// holds for Dijkstra and for A* with a consistent heuristic (not for GBFS).
+// Costs are non-negative floats, whose bit patterns order the same way as
+// the values. Entries go to the bucket of the highest bit in which their key
+// differs from the last popped key, so bucket 0 holds the entries equal to
+// it and every entry moves to a lower bucket at most 32 times. Push is O(1),
+// pop amortized O(1) for 32-bit keys, instead of O(log n) of a binary heap.
+template <typename T = QueueEntry> class RadixHeap {
+public:
+  void push(const T &entry) {
+    m_Buckets[BucketIndex(Key(entry))].push_back(entry);
+    m_Size++;
+  }
+  // not const, the heap may have to redistribute a bucket first
+  const T &top() {
+    Refill();
+    return m_Buckets[0].back();
+  }
+  void pop() {
+    Refill();
+    m_Buckets[0].pop_back();
+    if (--m_Size == 0)
+      m_Last = 0; // nothing left, any key is fine again
+  }
+  bool empty() const { return m_Size == 0; }
+  size_t size() const { return m_Size; }
+  size_t memory_usage() const {
+    size_t bytes = 0;
+    for (const auto &bucket : m_Buckets)
+      bytes += bucket.capacity() * sizeof(T);
+    return bytes;
+  }
+  void clear() {
+    for (auto &bucket : m_Buckets)
+      bucket.clear();
+    m_Size = 0;
+    m_Last = 0;
+  }
+
+private:
+  // entries are never treated as cheaper than the last popped one, this
+  // only matters for float rounding
+  uint32_t Key(const T &entry) const {
+    return std::max(std::bit_cast<uint32_t>(entry.cost), m_Last);
+  }
+  size_t BucketIndex(uint32_t key) const {
+    return std::bit_width(key ^ m_Last);
+  }
+  // move the smallest entries to bucket 0
+  void Refill() {
+    if (!m_Buckets[0].empty())
+      return;
+    size_t i = 1;
+    while (m_Buckets[i].empty())
+      i++;
+    auto &bucket = m_Buckets[i];
+    m_Last = Key(*std::ranges::min_element(
+        bucket, {}, [this](const T &entry) { return Key(entry); }));
+    for (const T &entry : bucket)
+      m_Buckets[BucketIndex(Key(entry))].push_back(entry);
+    bucket.clear();
+  }
+
+  std::array<std::vector<T>, 33> m_Buckets;
+  size_t m_Size = 0;
+  uint32_t m_Last = 0;
+};
+
+// bytes allocated by a vector
+template <typename T> size_t memory_usage(const std::vector<T> &v) {
+  return v.capacity() * sizeof(T);
+}
+
+// cost of the cheapest tile type, used to keep heuristics admissible
+float cheapest_tile_cost();
+
+// True if every tile touched by the segment between the centers of "from"
+// and "to" (except "from" itself) is passable and costs "cost". Walks the
+// tiles like a DDA (supercover: a segment through a tile corner touches
+// both side tiles).
+bool line_of_sight(const Map &map, TilePos from, TilePos to, float cost);
+
+// Cost of following the path: every segment costs its length in tiles
+// times the cost of the tile it ends in, like the moves of the searches.
+// Any-angle segments are only exact if their tiles all cost the same.
+float path_cost(const Map &map, const Path &path);
+
 std::unique_ptr<pathfinder::PathFinderBase>
 create(pathfinder::PathFinderType type, const Map *map);
 
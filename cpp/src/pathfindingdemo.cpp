@@ -1,6 +1,9 @@
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <queue>
+#include <utility>
 #include <vector>
 
 #include "pathfindingdemo.hpp"
@@ -13,11 +16,23 @@
 #include "tile.hpp"
 #include "user_input.hpp"
 
-PathFindingDemo::PathFindingDemo(int width, int height) : m_Map(width, height) {
+namespace {
+
+// a step onto water takes 100 frames, a tick that takes three times that
+// long is stuck
+constexpr uint32_t kCooperativeStallFrames = 300;
+
+} // namespace
+
+PathFindingDemo::PathFindingDemo(int width, int height)
+    : m_Map(width, height), m_PathRequests((const Map *)&m_Map),
+      m_SlicedPaths((const Map *)&m_Map),
+      m_FlowFields((const Map *)&m_Map), m_Cooperative((const Map *)&m_Map),
+      m_JointPlanner((const Map *)&m_Map, {2000, 50.0}) {
   LOG_DEBUG(".");
   // set default pathfinder method
-  m_PathFinder = pathfinder::utils::create(pathfinder::PathFinderType::DIJKSTRA,
-                                           (const Map *)&m_Map);
+  m_PathFinder =
+      pathfinder::utils::create(m_PathFinderType, (const Map *)&m_Map);
 }
 
 PathFindingDemo::~PathFindingDemo() { LOG_DEBUG("."); }
@@ -92,7 +107,34 @@ void PathFindingDemo::UpdateWorld() {
 
   float time_delta = 1.0f;
 
+  ApplyPathResults();
+  FollowCooperativePlan();
+
   for (auto &entity : m_Entities) {
+    // refine the next segment of a hierarchical path
+    if (entity->NeedsRefinement()) {
+      auto waypoint = entity->PopWaypoint();
+      auto segment =
+          m_PathFinder->RefineSegment(entity->GetPosition(), waypoint.value());
+      const bool arrived = m_Map.WorldToTile(entity->GetPosition()) ==
+                           m_Map.WorldToTile(waypoint.value());
+      if (segment.empty() && !arrived) {
+        // the segment left the clusters of the waypoints, search the rest
+        // of the way again on the workers, they keep the abstract graph
+        const auto &waypoints = entity->GetWaypoints();
+        const WorldPos goal =
+            waypoints.empty() ? waypoint.value() : *std::prev(waypoints.end());
+        ForgetPathRequests(entity);
+        entity->SetPath(pathfinder::Path{});
+        auto id = m_PathRequests.Submit(entity->GetPosition(), goal,
+                                        m_PathFinderType);
+        m_PendingPaths[id] = entity;
+        LOG_INFO("Path request ", id, " replaces a broken path segment");
+      } else {
+        entity->SetPathSegment(std::move(segment));
+      }
+    }
+
     // calculate the velocity
     auto current_pos = entity->GetPosition();
     double tile_velocity_coeff = m_Map.GetTileVelocityCoeff(current_pos);
@@ -131,17 +173,44 @@ void PathFindingDemo::HandleActions(const std::vector<UserAction> &actions) {
   for (const auto &action : actions) {
     if (action.type == UserAction::Type::EXIT) {
       LOG_INFO("Exit requested");
+      m_PathRequests.GetStats().Log();
       m_ExitRequested = true;
     } else if (action.type == UserAction::Type::SET_MOVE_TARGET) {
       WorldPos target_pos =
           m_Camera.WindowToWorld(std::get<WindowPos>(action.Argument));
+      if (m_CooperativeMode && m_SelectedEntities.size() > 1) {
+        PlanCooperativeMove(target_pos);
+        continue;
+      }
+      if (m_FlowFieldMode && m_SelectedEntities.size() > 1) {
+        // one search for the whole group
+        auto field = GetFlowField(target_pos);
+        for (auto &selected_entity : m_SelectedEntities) {
+          if (auto sp = selected_entity.lock()) {
+            ForgetPathRequests(sp);
+            sp->SetFlowField(field);
+          }
+        }
+        LOG_INFO("Group of ", m_SelectedEntities.size(),
+                 " entities follows flow field to ", target_pos);
+        continue;
+      }
       for (auto &selected_entity : m_SelectedEntities) {
         LOG_INFO("Calculating path to target: ", target_pos);
         if (auto sp = selected_entity.lock()) {
-          auto path =
-              m_PathFinder->CalculatePath(sp->GetPosition(), target_pos);
-          sp->SetPath(path);
-          LOG_INFO("Done, path node count: ", path.size());
+          // only the latest order of the entity counts
+          ForgetPathRequests(sp);
+          // only some pathfinders can split a search, the others would
+          // stall the frame and run on the workers instead
+          if (m_TimeSlicedMode && m_PathFinder->IsTimeSliced()) {
+            auto id = m_SlicedPaths.Submit(sp->GetPosition(), target_pos,
+                                           m_PathFinderType);
+            m_PendingSlicedPaths[id] = sp;
+          } else {
+            auto id = m_PathRequests.Submit(sp->GetPosition(), target_pos,
+                                            m_PathFinderType);
+            m_PendingPaths[id] = sp;
+          }
         } else {
           LOG_INFO("Cannot calculate path for destroyed entity "
                    "(weak_ptr.lock() failed)");
@@ -152,7 +221,37 @@ void PathFindingDemo::HandleActions(const std::vector<UserAction> &actions) {
       PathFinderType type =
           static_cast<PathFinderType>(std::get<int32_t>(action.Argument));
       m_PathFinder = pathfinder::utils::create(type, (const Map *)&m_Map);
+      m_PathFinderType = type;
+      LOG_INFO("Switched to path finding method: ", m_PathFinder->GetName());
+    } else if (action.type == UserAction::Type::NEXT_PATHFINDER) {
+      // there are more pathfinders than number keys, cycle through them
+      using namespace pathfinder;
+      auto next = static_cast<int>(m_PathFinderType) + 1;
+      if (next >= static_cast<int>(PathFinderType::COUNT))
+        next = static_cast<int>(PathFinderType::LINEAR);
+      m_PathFinderType = static_cast<PathFinderType>(next);
+      m_PathFinder = pathfinder::utils::create(m_PathFinderType, &m_Map);
       LOG_INFO("Switched to path finding method: ", m_PathFinder->GetName());
+    } else if (action.type == UserAction::Type::TOGGLE_FLOW_FIELD) {
+      m_FlowFieldMode = !m_FlowFieldMode;
+      LOG_INFO("Flow field for group orders ",
+               m_FlowFieldMode ? "enabled" : "disabled");
+    } else if (action.type == UserAction::Type::TOGGLE_DIAGONALS) {
+      // the workers read the map, let them finish first
+      m_PathRequests.Wait();
+      const bool diagonals =
+          m_Map.GetConnectivity() == Connectivity::FOUR;
+      m_Map.SetConnectivity(diagonals ? Connectivity::EIGHT
+                                      : Connectivity::FOUR);
+      LOG_INFO("Diagonal moves ", diagonals ? "enabled" : "disabled");
+    } else if (action.type == UserAction::Type::TOGGLE_TIME_SLICING) {
+      m_TimeSlicedMode = !m_TimeSlicedMode;
+      LOG_INFO("Time-sliced path requests ",
+               m_TimeSlicedMode ? "enabled" : "disabled");
+    } else if (action.type == UserAction::Type::TOGGLE_COOPERATIVE) {
+      m_CooperativeMode = !m_CooperativeMode;
+      LOG_INFO("Cooperative planning for group orders ",
+               m_CooperativeMode ? "enabled" : "disabled");
     } else if (action.type == UserAction::Type::CAMERA_PAN) {
       const auto &window_pan = std::get<WindowPos>(action.Argument);
       WorldPos world_pan{window_pan.x(), window_pan.y()};
@@ -182,6 +281,202 @@ void PathFindingDemo::HandleActions(const std::vector<UserAction> &actions) {
   };
 }
 
+std::shared_ptr<const pathfinder::FlowField>
+PathFindingDemo::GetFlowField(WorldPos target) {
+  const TilePos target_tile = m_Map.WorldToTile(target);
+  const size_t misses = m_FlowFields.GetMissCount();
+  auto field = m_FlowFields.Get(target_tile);
+  if (m_FlowFields.GetMissCount() != misses)
+    LOG_INFO("Flow field to ", target_tile, " done, expanded nodes: ",
+             field->GetExpandedNodeCount());
+  return field;
+}
+
+void PathFindingDemo::PlanCooperativeMove(WorldPos target) {
+  std::vector<std::shared_ptr<Entity>> entities;
+  for (auto &selected_entity : m_SelectedEntities) {
+    if (auto sp = selected_entity.lock())
+      entities.push_back(sp);
+  }
+  // the closest entities go first and take the goals next to the target,
+  // the others find their way around them
+  std::ranges::sort(entities, {}, [&target](const auto &entity) {
+    return entity->GetPosition().DistanceTo(target);
+  });
+  const TilePos target_tile = m_Map.WorldToTile(target);
+  auto goals = pathfinder::GoalsAround(m_Map, target_tile, entities.size());
+  entities.resize(std::min(entities.size(), goals.size()));
+
+  CooperativeGroup group;
+  for (size_t i = 0; i < entities.size(); i++) {
+    ForgetPathRequests(entities[i]);
+    group.entities.push_back(entities[i]);
+    group.agents.push_back(
+        {m_Map.WorldToTile(entities[i]->GetPosition()), goals[i]});
+  }
+  m_CooperativeGroup = std::move(group);
+  PlanCooperativeGroup(true);
+  LOG_INFO("Group of ", entities.size(), " entities planned around ",
+           target_tile,
+           m_CooperativeGroup->windowed ? " in windows" : " by CBS",
+           ", expanded nodes: ",
+           m_CooperativeGroup->windowed
+               ? m_Cooperative.GetExpandedNodeCount()
+               : m_JointPlanner.GetExpandedNodeCount());
+}
+
+void PathFindingDemo::PlanCooperativeGroup(bool new_order) {
+  CooperativeGroup &group = *m_CooperativeGroup;
+  for (size_t i = 0; i < group.entities.size(); i++) {
+    if (auto entity = group.entities[i].lock())
+      group.agents[i].start = m_Map.WorldToTile(entity->GetPosition());
+  }
+  // CBS if it finds the optimal plan in time, windowed planning otherwise.
+  // CBS already failed for a group planned again, or its plan got stuck.
+  group.windowed = true;
+  if (new_order) {
+    auto joint = m_JointPlanner.Solve(group.agents);
+    if (joint.status == pathfinder::ConflictBasedSearch::Status::SOLVED) {
+      group.paths = std::move(joint.paths);
+      group.windowed = false;
+    }
+  }
+  if (group.windowed) {
+    // the collisions of the others aren't planned, keep off their tiles
+    std::vector<TilePos> obstacles;
+    for (const auto &entity : m_Entities) {
+      const bool member = std::ranges::any_of(
+          group.entities,
+          [&entity](const auto &weak) { return weak.lock() == entity; });
+      if (!member)
+        obstacles.push_back(m_Map.WorldToTile(entity->GetPosition()));
+    }
+    group.paths = m_Cooperative.Plan(group.agents, obstacles);
+  }
+  // the first tick centres the entities on their start tiles
+  group.tick = 0;
+  group.tick_frames = 0;
+  for (size_t i = 0; i < group.entities.size(); i++) {
+    auto entity = group.entities[i].lock();
+    if (entity && !group.paths[i].empty())
+      entity->SetPath(
+          pathfinder::Path{m_Map.TileToWorld(group.agents[i].start)});
+  }
+}
+
+void PathFindingDemo::FollowCooperativePlan() {
+  if (!m_CooperativeGroup)
+    return;
+  CooperativeGroup &group = *m_CooperativeGroup;
+  for (const auto &weak_entity : group.entities) {
+    auto entity = weak_entity.lock();
+    if (entity && !entity->GetPath().empty()) {
+      // still on the way to the tile of this tick, unless something the
+      // plan doesn't know about is in the way
+      if (++group.tick_frames > kCooperativeStallFrames) {
+        LOG_INFO("Group of ", group.entities.size(),
+                 " entities got stuck, planned again");
+        PlanCooperativeGroup(false);
+      }
+      return;
+    }
+  }
+
+  group.tick++;
+  group.tick_frames = 0;
+  const bool arrived = std::ranges::all_of(
+      group.paths, [&group](const auto &path) {
+        return group.tick >= path.size();
+      });
+  if (arrived) {
+    m_CooperativeGroup.reset();
+    return;
+  }
+  // collisions are only avoided inside the window, plan the rest again
+  // halfway through it
+  if (group.windowed && group.tick >= m_Cooperative.GetWindow() / 2) {
+    PlanCooperativeGroup(false);
+    LOG_DEBUG("Group of ", group.entities.size(), " entities planned again");
+    return;
+  }
+
+  // entities that wait get the tile they stand on
+  for (size_t i = 0; i < group.entities.size(); i++) {
+    const auto &path = group.paths[i];
+    auto entity = group.entities[i].lock();
+    if (!entity || path.empty())
+      continue;
+    const TilePos tile = path[std::min<size_t>(group.tick, path.size() - 1)];
+    entity->SetPath(pathfinder::Path{m_Map.TileToWorld(tile)});
+  }
+}
+
+void PathFindingDemo::UpdatePaths(size_t max_expansions) {
+  if (m_SlicedPaths.GetPendingCount() > 0)
+    m_SlicedPaths.Update(max_expansions);
+}
+
+void PathFindingDemo::ApplyPathResults() {
+  ApplyPathResults(m_PathRequests.TakeResults(), m_PendingPaths);
+  ApplyPathResults(m_SlicedPaths.TakeResults(), m_PendingSlicedPaths);
+}
+
+void PathFindingDemo::ApplyPathResults(
+    std::vector<pathfinder::PathResult> results,
+    std::unordered_map<pathfinder::RequestId, std::weak_ptr<Entity>>
+        &pending) {
+  for (auto &result : results) {
+    auto it = pending.find(result.id);
+    if (it == pending.end())
+      continue; // superseded by a newer request
+    if (auto entity = it->second.lock()) {
+      if (!result.waypoints.empty()) {
+        LOG_INFO("Path request ", result.id,
+                 " done, waypoint count: ", result.waypoints.size());
+        entity->SetWaypoints(std::move(result.waypoints));
+      } else {
+        LOG_INFO("Path request ", result.id,
+                 " done, path node count: ", result.path.size());
+        entity->SetPath(std::move(result.path));
+      }
+    }
+    pending.erase(it);
+  }
+}
+
+void PathFindingDemo::ForgetPathRequests(
+    const std::shared_ptr<Entity> &entity) {
+  auto forget = [&entity](const auto &item) {
+    auto pending = item.second.lock();
+    return pending == nullptr || pending == entity;
+  };
+  std::erase_if(m_PendingPaths, forget);
+  if (m_CooperativeGroup) {
+    // the rest of the group keeps its plan
+    auto &group = *m_CooperativeGroup;
+    for (size_t i = 0; i < group.entities.size();) {
+      auto member = group.entities[i].lock();
+      if (member == nullptr || member == entity) {
+        group.entities.erase(group.entities.begin() + i);
+        group.agents.erase(group.agents.begin() + i);
+        group.paths.erase(group.paths.begin() + i);
+      } else {
+        i++;
+      }
+    }
+  }
+  // searches on the game loop thread would still eat into the budget
+  for (auto it = m_PendingSlicedPaths.begin();
+       it != m_PendingSlicedPaths.end();) {
+    if (forget(*it)) {
+      m_SlicedPaths.Cancel(it->first);
+      it = m_PendingSlicedPaths.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 void PathFindingDemo::DeselectEntities() {
   std::for_each(m_SelectedEntities.begin(), m_SelectedEntities.end(),
                 [](auto &x) {
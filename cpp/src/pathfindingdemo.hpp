@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <queue>
+#include <unordered_map>
 #include <vector>
 
 #include "camera.hpp"
@@ -10,6 +12,11 @@
 #include "log.hpp"
 #include "map.hpp"
 #include "pathfinder/base.hpp"
+#include "pathfinder/cbs.hpp"
+#include "pathfinder/cooperative.hpp"
+#include "pathfinder/flow_field.hpp"
+#include "pathfinder/request_service.hpp"
+#include "pathfinder/sliced_scheduler.hpp"
 #include "user_input.hpp"
 
 using Collision = std::pair<std::weak_ptr<Entity>, std::weak_ptr<Entity>>;
@@ -20,6 +27,20 @@ struct SelectionBox {
   bool active;
 };
 
+// Entities of a cooperative order walk their space-time paths in lockstep,
+// the next tick starts once all of them reached the tile of the current one
+struct CooperativeGroup {
+  std::vector<std::weak_ptr<Entity>> entities;
+  // one query and one path per entity
+  std::vector<pathfinder::AgentQuery> agents;
+  std::vector<pathfinder::SpaceTimePath> paths;
+  uint32_t tick = 0;
+  // frames spent on the current tick, see FollowCooperativePlan
+  uint32_t tick_frames = 0;
+  // windowed plans are made again every half window, CBS plans are kept
+  bool windowed = false;
+};
+
 class PathFindingDemo {
 public:
   PathFindingDemo(int width, int height);
@@ -38,6 +59,8 @@ public:
   void AddEntity(std::shared_ptr<Entity> e);
   void CreateMap();
   void UpdateWorld();
+  // advance the time-sliced path requests by at most max_expansions nodes
+  void UpdatePaths(size_t max_expansions);
   void HandleActions(const std::vector<UserAction> &actions);
   WorldPos GetRandomPosition() const;
 
@@ -51,12 +74,54 @@ public:
 
 private:
   const std::vector<Collision> &GetEntityCollisions();
+  std::shared_ptr<const pathfinder::FlowField> GetFlowField(WorldPos target);
+  // plans the selected entities together so they don't run into each other
+  void PlanCooperativeMove(WorldPos target);
+  // Plans the cooperative group from the tiles its entities stand on, the
+  // other entities are obstacles. CBS is only tried for a new order, plans
+  // made again go straight to windowed planning.
+  void PlanCooperativeGroup(bool new_order);
+  // moves the cooperative group on by a tick once it is done with the last
+  void FollowCooperativePlan();
+  // hand finished path requests to their entities
+  void ApplyPathResults();
+  void ApplyPathResults(
+      std::vector<pathfinder::PathResult> results,
+      std::unordered_map<pathfinder::RequestId, std::weak_ptr<Entity>>
+          &pending);
+  void ForgetPathRequests(const std::shared_ptr<Entity> &entity);
 
   bool m_ExitRequested = false;
   Map m_Map;
   Camera m_Camera;
   std::vector<std::shared_ptr<Entity>> m_Entities;
+  pathfinder::PathFinderType m_PathFinderType =
+      pathfinder::PathFinderType::DIJKSTRA;
   std::unique_ptr<pathfinder::PathFinderBase> m_PathFinder;
+  // paths are calculated off the game loop thread, entities keep their old
+  // path until the result of their latest request arrives
+  pathfinder::PathRequestService m_PathRequests;
+  std::unordered_map<pathfinder::RequestId, std::weak_ptr<Entity>>
+      m_PendingPaths;
+  // alternatively the requests are searched on the game loop thread, a few
+  // nodes per frame (the ids are separate from the ones above)
+  bool m_TimeSlicedMode = false;
+  pathfinder::SlicedPathScheduler m_SlicedPaths;
+  std::unordered_map<pathfinder::RequestId, std::weak_ptr<Entity>>
+      m_PendingSlicedPaths;
+  // group move orders share one flow field per target tile, recent fields
+  // are kept for the next orders to the same tile
+  bool m_FlowFieldMode = true;
+  pathfinder::FlowFieldCache m_FlowFields;
+  // or plan them with reservations of each other's way, each to its own
+  // tile around the target (takes precedence over the flow field)
+  bool m_CooperativeMode = false;
+  pathfinder::CooperativePlanner m_Cooperative;
+  // optimal plans for small groups, given up after 50 ms
+  pathfinder::ConflictBasedSearch m_JointPlanner;
+  // only the latest cooperative order is followed, the entities of an older
+  // one stop on their next tile
+  std::optional<CooperativeGroup> m_CooperativeGroup;
   std::vector<std::weak_ptr<Entity>> m_SelectedEntities;
   SelectionBox m_SelectionBox;
 };
@@ -6,9 +6,9 @@
 // we could use array here, but this is more explicit,
 // and we don't access tile_types that often, so it should be ok
 const std::unordered_map<TileType, Tile> tile_types = {
-    {TileType::GRASS, Tile{1.0, 0, 200, 0, 255}},
-    {TileType::WOOD, Tile{1.0, 132, 68, 0, 255}},
-    {TileType::ROAD, Tile{0.5, 20, 20, 20, 255}},
-    {TileType::WATER, Tile{10.0, 0, 50, 200, 255}},
-    {TileType::WALL, Tile{1000.0, 144, 33, 0, 255}},
+    {TileType::GRASS, Tile{1.0, 0, 200, 0, 255, true}},
+    {TileType::WOOD, Tile{1.0, 132, 68, 0, 255, true}},
+    {TileType::ROAD, Tile{0.5, 20, 20, 20, 255, true}},
+    {TileType::WATER, Tile{10.0, 0, 50, 200, 255, true}},
+    {TileType::WALL, Tile{1000.0, 144, 33, 0, 255, false}},
 };
@@ -9,6 +9,7 @@
 struct Tile {
   float cost;
   uint8_t R, G, B, A;
+  bool passable; // impassable tiles are never entered by a path
 };
 
 enum class TileType {
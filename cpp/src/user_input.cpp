@@ -83,12 +83,42 @@ void UserInput::GetActions_keyboard(const SDL_Event &event) {
   case '2':
   case '3':
   case '4':
+  case '5':
+  case '6':
+  case '7':
+  case '8':
+  case '9':
     if (key_down) {
       int selection = kbd_event.key - '0';
       m_Actions.emplace_back(UserAction::Type::SELECT_PATHFINDER, selection);
       LOG_INFO("Pathfinder selected: ", selection);
     }
     break;
+  case 'n':
+    if (key_down) {
+      m_Actions.emplace_back(UserAction::Type::NEXT_PATHFINDER);
+    }
+    break;
+  case 'f':
+    if (key_down) {
+      m_Actions.emplace_back(UserAction::Type::TOGGLE_FLOW_FIELD);
+    }
+    break;
+  case 'd':
+    if (key_down) {
+      m_Actions.emplace_back(UserAction::Type::TOGGLE_DIAGONALS);
+    }
+    break;
+  case 't':
+    if (key_down) {
+      m_Actions.emplace_back(UserAction::Type::TOGGLE_TIME_SLICING);
+    }
+    break;
+  case 'c':
+    if (key_down) {
+      m_Actions.emplace_back(UserAction::Type::TOGGLE_COOPERATIVE);
+    }
+    break;
   default:
     LOG_INFO("Key '", static_cast<char>(kbd_event.key), "' not mapped");
     break;
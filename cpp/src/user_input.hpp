@@ -17,6 +17,11 @@ public:
     EXIT,
     SET_MOVE_TARGET,
     SELECT_PATHFINDER,
+    NEXT_PATHFINDER,
+    TOGGLE_FLOW_FIELD,
+    TOGGLE_DIAGONALS,
+    TOGGLE_TIME_SLICING,
+    TOGGLE_COOPERATIVE,
     CAMERA_PAN,
     CAMERA_ZOOM,
     SELECTION_START,
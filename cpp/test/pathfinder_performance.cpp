@@ -0,0 +1,1259 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "map.hpp"
+#include "pathfinder/astar.hpp"
+#include "pathfinder/base.hpp"
+#include "pathfinder/bidirectional.hpp"
+#include "pathfinder/bounded_astar.hpp"
+#include "pathfinder/cbs.hpp"
+#include "pathfinder/cooperative.hpp"
+#include "pathfinder/dijkstra.hpp"
+#include "pathfinder/dstar_lite.hpp"
+#include "pathfinder/flow_field.hpp"
+#include "pathfinder/followed_path.hpp"
+#include "pathfinder/hpa.hpp"
+#include "pathfinder/jps.hpp"
+#include "pathfinder/landmarks.hpp"
+#include "pathfinder/parallel_integrator.hpp"
+#include "pathfinder/request_service.hpp"
+#include "pathfinder/search_stats.hpp"
+#include "pathfinder/sliced_scheduler.hpp"
+#include "pathfinder/theta_star.hpp"
+#include "pathfinder/utils.hpp"
+
+/**
+ * @file pathfinder_performance.cpp
+ * @brief Performance tests for the pathfinding algorithms
+ *
+ * Runs the same set of queries through several pathfinders and
+ * compares the number of expanded nodes and the wall time.
+ */
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+using Duration = std::chrono::duration<double, std::milli>;
+using Query = std::pair<TilePos, TilePos>;
+
+/**
+ * @brief Scaled-up version of the demo map: big uniform grass and water
+ * regions with roads, bridges and walls painted over them
+ */
+void PaintDemoLikeMap(Map &map, int scale) {
+    auto s = [scale](int x, int y) { return TilePos{x * scale, y * scale}; };
+    const unsigned r = static_cast<unsigned>(scale);
+    map.PaintCircle(s(50, 50), 10 * r, TileType::WATER);
+    map.PaintCircle(s(75, 100), 50 * r, TileType::WATER);
+    map.PaintLine(s(0, 0), s(100, 100), 3.0 * scale, TileType::WATER);
+    map.PaintLine(s(17, 6), s(100, 6), 5.0 * scale, TileType::ROAD);
+    map.PaintLine(s(10, 17), s(10, 100), 5.0 * scale, TileType::ROAD);
+    map.PaintLine(s(50, 75), s(70, 75), 5.0 * scale, TileType::WOOD);
+    map.PaintLine(s(95, 26), s(95, 60), 5.0 * scale, TileType::WOOD);
+    map.PaintLine(s(71, 60), s(90, 60), 1.0 * scale, TileType::WALL);
+    map.PaintLine(s(71, 60), s(71, 75), 1.0 * scale, TileType::WALL);
+    map.PaintLine(s(72, 73), s(95, 73), 1.0 * scale, TileType::WALL);
+}
+
+/**
+ * @brief Random start/end pairs with a path between them, fixed seed so the
+ * runs are comparable
+ */
+std::vector<Query> RandomQueries(const Map &map, size_t count) {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> row(0, static_cast<int>(map.GetRows()) - 1);
+    std::uniform_int_distribution<int> col(0, static_cast<int>(map.GetCols()) - 1);
+    std::vector<Query> queries;
+    queries.reserve(count);
+    while (queries.size() < count) {
+        const TilePos start{row(gen), col(gen)};
+        const TilePos end{row(gen), col(gen)};
+        if (map.IsReachable(start, end)) {
+            queries.emplace_back(start, end);
+        }
+    }
+    return queries;
+}
+
+float PathCost(const Map &map, const pathfinder::Path &path) {
+    float cost = 0.0f;
+    for (size_t i = 1; i < path.size(); i++) {
+        const TilePos a = map.WorldToTile(path[i - 1]);
+        const TilePos b = map.WorldToTile(path[i]);
+        const bool diagonal = a.x() != b.x() && a.y() != b.y();
+        cost += (diagonal ? std::numbers::sqrt2_v<float> : 1.0f) * map.GetCost(b);
+    }
+    return cost;
+}
+
+struct RunResult {
+    double total_ms = 0.0;
+    size_t expanded = 0;
+    std::vector<float> costs;
+};
+
+/**
+ * @brief Run all queries and collect time, expansions and path costs
+ */
+RunResult RunQueries(const Map &map, pathfinder::PathFinderBase &pf,
+                     const std::vector<Query> &queries) {
+    RunResult result;
+    for (const auto &[start, end] : queries) {
+        auto t0 = Clock::now();
+        auto path = pf.CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+        auto t1 = Clock::now();
+        result.total_ms += Duration(t1 - t0).count();
+        result.expanded += pf.GetExpandedNodeCount();
+        result.costs.push_back(PathCost(map, path));
+    }
+    return result;
+}
+
+/**
+ * @brief Random start/end pairs that are at least min_distance tiles apart
+ */
+std::vector<Query> LongQueries(const Map &map, size_t count, int min_distance) {
+    std::vector<Query> queries;
+    for (const auto &query : RandomQueries(map, count * 20)) {
+        const TilePos diff = query.second - query.first;
+        if (std::abs(diff.x()) + std::abs(diff.y()) >= min_distance) {
+            queries.push_back(query);
+        }
+        if (queries.size() == count) {
+            break;
+        }
+    }
+    return queries;
+}
+
+void PrintResult(const std::string &name, const RunResult &r, size_t queries) {
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCHMARK] " << name << ":\n"
+              << "  Total time: " << r.total_ms << " ms\n"
+              << "  Average time per query: " << r.total_ms / queries << " ms\n"
+              << "  Expanded nodes per query: " << r.expanded / queries << std::endl;
+}
+
+/**
+ * @brief Dijkstra over the whole map without early exit, the frontier sees
+ * the same push/pop sequence as in a real search
+ * @return number of push and pop operations
+ */
+template <typename Frontier>
+size_t FloodFill(const Map &map, TilePos start, Frontier &frontier) {
+    std::vector<float> costs(map.GetTileCount(), std::numeric_limits<float>::max());
+    size_t operations = 1;
+    frontier.clear();
+    costs[map.TileToIndex(start)] = 0.0f;
+    frontier.push({0.0f, start});
+    while (!frontier.empty()) {
+        const pathfinder::utils::QueueEntry current = frontier.top();
+        frontier.pop();
+        operations++;
+        if (current.cost > costs[map.TileToIndex(current.tile)]) {
+            continue;
+        }
+        for (const Neighbor &next : map.GetNeighbors(current.tile)) {
+            const float cost = current.cost + next.cost;
+            if (cost < costs[next.index]) {
+                costs[next.index] = cost;
+                frontier.push({cost, next.pos});
+                operations++;
+            }
+        }
+    }
+    return operations;
+}
+
+/**
+ * @brief Neighbours the way Map::GetNeighbors used to return them: a fresh
+ * vector per call and a bounds check per candidate, costs looked up after
+ */
+std::vector<TilePos> AllocatingNeighbors(const Map &map, TilePos center) {
+    std::vector<TilePos> neighbours;
+    neighbours.reserve(4);
+    for (TilePos step : {TilePos{1, 0}, TilePos{-1, 0}, TilePos{0, 1}, TilePos{0, -1}}) {
+        if (map.IsPassable(center + step)) {
+            neighbours.push_back(center + step);
+        }
+    }
+    return neighbours;
+}
+
+} // namespace
+
+TEST(PathfinderPerformance, NeighborIteration) {
+    std::cout << "\n=== Neighbour iteration: vector vs fixed-capacity list ===\n" << std::endl;
+
+    const int SCALE = 10; // 1000x1000 tiles
+    const size_t NUM_SWEEPS = 5;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+
+    // sum of neighbour costs over every tile of the map, the sums are
+    // compared so the compiler can't drop the loops
+    double vector_sum = 0.0, list_sum = 0.0;
+    auto t0 = Clock::now();
+    for (size_t sweep = 0; sweep < NUM_SWEEPS; sweep++) {
+        for (size_t i = 0; i < map.GetTileCount(); i++) {
+            for (TilePos next : AllocatingNeighbors(map, map.IndexToTile(i))) {
+                vector_sum += map.GetCost(next);
+            }
+        }
+    }
+    const double vector_ms = Duration(Clock::now() - t0).count();
+    t0 = Clock::now();
+    for (size_t sweep = 0; sweep < NUM_SWEEPS; sweep++) {
+        for (size_t i = 0; i < map.GetTileCount(); i++) {
+            for (const Neighbor &next : map.GetNeighbors(map.IndexToTile(i))) {
+                list_sum += next.cost;
+            }
+        }
+    }
+    const double list_ms = Duration(Clock::now() - t0).count();
+
+    // whole searches use the list, for reference
+    pathfinder::Dijkstra dijkstra(&map);
+    auto queries = LongQueries(map, 5, 100 * SCALE);
+    auto dijkstra_result = RunQueries(map, dijkstra, queries);
+
+    const double calls = static_cast<double>(NUM_SWEEPS * map.GetTileCount());
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCHMARK] " << calls / 1e6 << " M calls\n"
+              << "  std::vector: " << vector_ms << " ms, " << vector_ms * 1e6 / calls << " ns/call\n"
+              << "  NeighborList: " << list_ms << " ms, " << list_ms * 1e6 / calls << " ns/call"
+              << std::endl;
+    PrintResult("Dijkstra", dijkstra_result, queries.size());
+
+    EXPECT_DOUBLE_EQ(vector_sum, list_sum);
+}
+
+TEST(PathfinderPerformance, JumpPointSearchExpansions) {
+    std::cout << "\n=== Jump Point Search vs Dijkstra / A* ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 100;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = RandomQueries(map, NUM_QUERIES);
+
+    pathfinder::Dijkstra dijkstra(&map);
+    pathfinder::AStar<> astar(&map);
+    pathfinder::JPS jps(&map);
+
+    auto dijkstra_result = RunQueries(map, dijkstra, queries);
+    auto astar_result = RunQueries(map, astar, queries);
+    auto jps_result = RunQueries(map, jps, queries);
+
+    PrintResult("Dijkstra", dijkstra_result, NUM_QUERIES);
+    PrintResult("A*", astar_result, NUM_QUERIES);
+    PrintResult("JPS", jps_result, NUM_QUERIES);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "\nJPS expands " << static_cast<double>(dijkstra_result.expanded) / jps_result.expanded
+              << "x fewer nodes than Dijkstra and "
+              << static_cast<double>(astar_result.expanded) / jps_result.expanded
+              << "x fewer than A*" << std::endl;
+
+    // JPS must stay optimal
+    int mismatches = 0;
+    for (size_t i = 0; i < NUM_QUERIES; i++) {
+        if (std::abs(dijkstra_result.costs[i] - jps_result.costs[i]) > 1e-3f) {
+            mismatches++;
+        }
+    }
+    EXPECT_EQ(mismatches, 0) << "JPS path costs should match Dijkstra";
+    EXPECT_LT(jps_result.expanded, dijkstra_result.expanded)
+        << "JPS should expand fewer nodes than Dijkstra";
+}
+
+TEST(PathfinderPerformance, HierarchicalLongQueries) {
+    std::cout << "\n=== HPA* vs A* on long queries ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 50;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = LongQueries(map, NUM_QUERIES, 100 * SCALE);
+    ASSERT_EQ(queries.size(), NUM_QUERIES);
+
+    pathfinder::AStar<> astar(&map);
+    pathfinder::HPAStar hpa(&map);
+
+    // first query builds the whole abstract graph
+    auto t0 = Clock::now();
+    hpa.CalculateAbstractPath(map.TileToWorld(queries[0].first),
+                              map.TileToWorld(queries[0].second));
+    const double build_ms = Duration(Clock::now() - t0).count();
+    const size_t total_clusters = hpa.GetRebuiltClusterCount();
+
+    auto astar_result = RunQueries(map, astar, queries);
+    auto hpa_result = RunQueries(map, hpa, queries);
+
+    PrintResult("A*", astar_result, NUM_QUERIES);
+    PrintResult("HPA*", hpa_result, NUM_QUERIES);
+
+    double cost_ratio = 0.0;
+    for (size_t i = 0; i < NUM_QUERIES; i++) {
+        cost_ratio += hpa_result.costs[i] / astar_result.costs[i];
+    }
+    cost_ratio /= NUM_QUERIES;
+
+    // a small lake painted over the map, only the clusters around it change
+    map.PaintCircle(TilePos{50 * SCALE, 20 * SCALE}, 4, TileType::WATER);
+    t0 = Clock::now();
+    hpa.CalculateAbstractPath(map.TileToWorld(queries[0].first),
+                              map.TileToWorld(queries[0].second));
+    const double rebuild_ms = Duration(Clock::now() - t0).count();
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "\nAbstract graph: " << hpa.GetAbstractNodeCount() << " nodes in "
+              << total_clusters << " clusters, built in " << build_ms << " ms\n"
+              << "After painting: " << hpa.GetRebuiltClusterCount()
+              << " clusters rebuilt in " << rebuild_ms << " ms\n"
+              << "Average HPA* path cost: " << cost_ratio << "x optimal" << std::endl;
+
+    EXPECT_LT(hpa_result.expanded, astar_result.expanded)
+        << "HPA* should expand fewer nodes than A*";
+    EXPECT_LT(hpa.GetRebuiltClusterCount(), total_clusters / 10)
+        << "painting should only rebuild the clusters around the change";
+}
+
+TEST(PathfinderPerformance, FlowFieldGroupOrder) {
+    std::cout << "\n=== Group move order: flow field vs path per entity ===\n" << std::endl;
+
+    const int SCALE = 1; // the demo map, 100x100 tiles
+    const size_t NUM_ENTITIES = 500;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    // every entity somewhere else, all heading to the same target
+    auto queries = RandomQueries(map, NUM_ENTITIES);
+    const TilePos target{90, 90};
+
+    pathfinder::AStar<> astar(&map);
+    size_t astar_expanded = 0;
+    auto t0 = Clock::now();
+    for (const auto &query : queries) {
+        astar.CalculatePath(map.TileToWorld(query.first), map.TileToWorld(target));
+        astar_expanded += astar.GetExpandedNodeCount();
+    }
+    const double astar_ms = Duration(Clock::now() - t0).count();
+
+    t0 = Clock::now();
+    pathfinder::FlowField field(&map, target);
+    const double field_ms = Duration(Clock::now() - t0).count();
+
+    // reading the steps is what the entities do every frame, entities
+    // walled off from the target don't get one
+    size_t reachable = 0;
+    for (const auto &query : queries) {
+        reachable += map.IsReachable(query.first, target);
+    }
+    t0 = Clock::now();
+    size_t steps = 0;
+    for (const auto &query : queries) {
+        steps += field.GetNextStep(map.TileToWorld(query.first)).has_value();
+    }
+    const double steps_ms = Duration(Clock::now() - t0).count();
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCHMARK] A* for each of " << NUM_ENTITIES << " entities: "
+              << astar_ms << " ms, " << astar_expanded << " expanded nodes\n"
+              << "[BENCHMARK] Flow field: " << field_ms << " ms, "
+              << field.GetExpandedNodeCount() << " expanded nodes\n"
+              << "[BENCHMARK] Next step for all entities: " << steps_ms << " ms" << std::endl;
+
+    EXPECT_EQ(steps, reachable);
+    EXPECT_LT(field.GetExpandedNodeCount(), astar_expanded / 10)
+        << "one flow field should be much cheaper than a search per entity";
+}
+
+TEST(PathfinderPerformance, IncrementalReplanning) {
+    std::cout << "\n=== Replanning after small map edits: D* Lite vs A* ===\n" << std::endl;
+
+    const int SCALE = 2;
+    const int NUM_EDITS = 100;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    const auto start = map.TileToWorld(TilePos{5, 5});
+    const auto end = map.TileToWorld(TilePos{190, 185});
+
+    pathfinder::DStarLite dstar(&map);
+    pathfinder::AStar<> astar(&map);
+    auto t0 = Clock::now();
+    auto path = dstar.CalculatePath(start, end);
+    const double initial_ms = Duration(Clock::now() - t0).count();
+    const size_t initial_expanded = dstar.GetExpandedNodeCount();
+
+    // gates closing on the current path and opening again
+    std::mt19937 gen(11);
+    double dstar_ms = 0.0, astar_ms = 0.0;
+    size_t dstar_expanded = 0, astar_expanded = 0;
+    TilePos gate;
+    for (int i = 0; i < NUM_EDITS; i++) {
+        if (i % 2 == 0) {
+            std::uniform_int_distribution<size_t> on_path(1, path.size() - 2);
+            gate = map.WorldToTile(path[on_path(gen)]);
+            map.PaintRectangle(gate - TilePos{1, 1}, gate + TilePos{1, 1}, TileType::WALL);
+        } else {
+            map.PaintRectangle(gate - TilePos{1, 1}, gate + TilePos{1, 1}, TileType::GRASS);
+        }
+
+        t0 = Clock::now();
+        path = dstar.CalculatePath(start, end);
+        dstar_ms += Duration(Clock::now() - t0).count();
+        dstar_expanded += dstar.GetExpandedNodeCount();
+
+        t0 = Clock::now();
+        auto reference = astar.CalculatePath(start, end);
+        astar_ms += Duration(Clock::now() - t0).count();
+        astar_expanded += astar.GetExpandedNodeCount();
+
+        ASSERT_NEAR(PathCost(map, path), PathCost(map, reference), 1e-2);
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCHMARK] D* Lite initial plan: " << initial_ms << " ms, "
+              << initial_expanded << " expanded nodes\n"
+              << "[BENCHMARK] D* Lite replan: " << dstar_ms / NUM_EDITS << " ms, "
+              << dstar_expanded / NUM_EDITS << " expanded nodes per edit\n"
+              << "[BENCHMARK] A* from scratch: " << astar_ms / NUM_EDITS << " ms, "
+              << astar_expanded / NUM_EDITS << " expanded nodes per edit" << std::endl;
+
+    EXPECT_LT(dstar_expanded, astar_expanded)
+        << "repairing the tree should expand fewer nodes than searching again";
+}
+
+TEST(PathfinderPerformance, BidirectionalLongQueries) {
+    std::cout << "\n=== Bidirectional vs one-sided search on long queries ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 50;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = LongQueries(map, NUM_QUERIES, 100 * SCALE);
+    ASSERT_EQ(queries.size(), NUM_QUERIES);
+
+    pathfinder::Dijkstra dijkstra(&map);
+    pathfinder::BidirectionalDijkstra bidijkstra(&map);
+    pathfinder::AStar<> astar(&map);
+    pathfinder::BidirectionalAStar biastar(&map);
+
+    auto dijkstra_result = RunQueries(map, dijkstra, queries);
+    auto bidijkstra_result = RunQueries(map, bidijkstra, queries);
+    auto astar_result = RunQueries(map, astar, queries);
+    auto biastar_result = RunQueries(map, biastar, queries);
+
+    PrintResult("Dijkstra", dijkstra_result, NUM_QUERIES);
+    PrintResult("Bidirectional Dijkstra", bidijkstra_result, NUM_QUERIES);
+    PrintResult("A*", astar_result, NUM_QUERIES);
+    PrintResult("Bidirectional A*", biastar_result, NUM_QUERIES);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "\nBidirectional Dijkstra expands "
+              << static_cast<double>(dijkstra_result.expanded) / bidijkstra_result.expanded
+              << "x fewer nodes than Dijkstra, bidirectional A* "
+              << static_cast<double>(astar_result.expanded) / biastar_result.expanded
+              << "x fewer than A*" << std::endl;
+
+    // both must stay optimal
+    int mismatches = 0;
+    for (size_t i = 0; i < NUM_QUERIES; i++) {
+        if (std::abs(dijkstra_result.costs[i] - bidijkstra_result.costs[i]) > 1e-2f ||
+            std::abs(dijkstra_result.costs[i] - biastar_result.costs[i]) > 1e-2f) {
+            mismatches++;
+        }
+    }
+    EXPECT_EQ(mismatches, 0) << "bidirectional path costs should match Dijkstra";
+    EXPECT_LT(bidijkstra_result.expanded, dijkstra_result.expanded)
+        << "bidirectional Dijkstra should expand fewer nodes than Dijkstra";
+}
+
+TEST(PathfinderPerformance, RadixHeapFrontier) {
+    std::cout << "\n=== Radix heap vs binary heap frontier ===\n" << std::endl;
+
+    const int SCALE = 10; // 1000x1000 tiles
+    const size_t NUM_FILLS = 3;
+    const size_t NUM_QUERIES = 10;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+
+    // raw frontier throughput
+    pathfinder::utils::PriorityQueue<> heap;
+    pathfinder::utils::RadixHeap<> radix;
+    double heap_ms = 0.0, radix_ms = 0.0;
+    size_t heap_ops = 0, radix_ops = 0;
+    for (size_t i = 0; i < NUM_FILLS; i++) {
+        const TilePos start{static_cast<int>(i) * 300 + 50, 500};
+        auto t0 = Clock::now();
+        heap_ops += FloodFill(map, start, heap);
+        heap_ms += Duration(Clock::now() - t0).count();
+        t0 = Clock::now();
+        radix_ops += FloodFill(map, start, radix);
+        radix_ms += Duration(Clock::now() - t0).count();
+    }
+    ASSERT_EQ(heap_ops, radix_ops);
+
+    // whole searches
+    auto queries = LongQueries(map, NUM_QUERIES, 100 * SCALE);
+    ASSERT_EQ(queries.size(), NUM_QUERIES);
+    pathfinder::Dijkstra dijkstra(&map);
+    pathfinder::Dijkstra<pathfinder::utils::RadixHeap<>> radix_dijkstra(&map);
+    auto dijkstra_result = RunQueries(map, dijkstra, queries);
+    auto radix_result = RunQueries(map, radix_dijkstra, queries);
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCHMARK] Flood fill of " << map.GetTileCount() << " tiles, "
+              << heap_ops / NUM_FILLS << " push/pop per fill\n"
+              << "  Binary heap: " << heap_ms / NUM_FILLS << " ms, "
+              << heap_ops / heap_ms / 1000.0 << " M ops/s\n"
+              << "  Radix heap: " << radix_ms / NUM_FILLS << " ms, "
+              << radix_ops / radix_ms / 1000.0 << " M ops/s" << std::endl;
+    PrintResult("Dijkstra (binary heap)", dijkstra_result, NUM_QUERIES);
+    PrintResult("Dijkstra (radix heap)", radix_result, NUM_QUERIES);
+
+    for (size_t i = 0; i < NUM_QUERIES; i++) {
+        EXPECT_NEAR(dijkstra_result.costs[i], radix_result.costs[i], 1e-2f);
+    }
+    EXPECT_LT(radix_ms, heap_ms) << "radix heap should be faster than the binary heap";
+}
+
+TEST(PathfinderPerformance, ThetaStarWaypoints) {
+    std::cout << "\n=== Theta* vs A*: waypoints per path ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 50;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = RandomQueries(map, NUM_QUERIES);
+
+    pathfinder::AStar<> astar(&map);
+    pathfinder::ThetaStar theta(&map);
+    size_t astar_waypoints = 0, theta_waypoints = 0;
+    auto count = [&map](pathfinder::PathFinderBase &pf, const Query &query) {
+        return pf.CalculatePath(map.TileToWorld(query.first), map.TileToWorld(query.second)).size();
+    };
+    for (const auto &query : queries) {
+        astar_waypoints += count(astar, query);
+        theta_waypoints += count(theta, query);
+    }
+    auto astar_result = RunQueries(map, astar, queries);
+    auto theta_result = RunQueries(map, theta, queries);
+
+    PrintResult("A*", astar_result, NUM_QUERIES);
+    PrintResult("Theta*", theta_result, NUM_QUERIES);
+    std::cout << "[BENCHMARK] Waypoints per path: A* " << astar_waypoints / NUM_QUERIES
+              << ", Theta* " << theta_waypoints / NUM_QUERIES << std::endl;
+
+    EXPECT_LT(theta_waypoints * 5, astar_waypoints)
+        << "any-angle paths should only contain the turning points";
+}
+
+TEST(PathfinderPerformance, LandmarkHeuristic) {
+    std::cout << "\n=== ALT (landmarks) vs Manhattan A* ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 50;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = LongQueries(map, NUM_QUERIES, 100 * SCALE);
+    ASSERT_EQ(queries.size(), NUM_QUERIES);
+
+    const auto path = std::filesystem::temp_directory_path() / "pathfinder_performance_landmarks.bin";
+    auto t0 = Clock::now();
+    auto landmarks = std::make_shared<const pathfinder::Landmarks>(pathfinder::Landmarks::Build(map));
+    const double build_ms = Duration(Clock::now() - t0).count();
+    ASSERT_TRUE(landmarks->Save(path).has_value());
+    t0 = Clock::now();
+    auto loaded = pathfinder::Landmarks::Load(path, map);
+    const double load_ms = Duration(Clock::now() - t0).count();
+    ASSERT_TRUE(loaded.has_value()) << loaded.error();
+    const auto file_size = std::filesystem::file_size(path);
+    std::filesystem::remove(path);
+
+    pathfinder::heuristic::Landmark heuristic;
+    heuristic.map = &map;
+    heuristic.landmarks = landmarks;
+    pathfinder::AStar<> astar(&map);
+    pathfinder::AStar<pathfinder::heuristic::Landmark> alt(&map, heuristic);
+    auto astar_result = RunQueries(map, astar, queries);
+    auto alt_result = RunQueries(map, alt, queries);
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCHMARK] " << landmarks->GetLandmarks().size() << " landmarks: build "
+              << build_ms << " ms, load " << load_ms << " ms, " << file_size / 1024 << " KiB on disk"
+              << std::endl;
+    PrintResult("A*", astar_result, NUM_QUERIES);
+    PrintResult("A* (landmarks)", alt_result, NUM_QUERIES);
+
+    for (size_t i = 0; i < NUM_QUERIES; i++) {
+        EXPECT_NEAR(astar_result.costs[i], alt_result.costs[i], 1e-2f);
+    }
+    EXPECT_LT(alt_result.expanded * 3, astar_result.expanded * 2)
+        << "landmarks should expand far fewer nodes than Manhattan";
+    EXPECT_LT(load_ms, build_ms) << "loading the tables should beat rebuilding them";
+}
+
+TEST(PathfinderPerformance, EightConnectedMovement) {
+    std::cout << "\n=== 4-connected vs 8-connected movement ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 50;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = LongQueries(map, NUM_QUERIES, 100 * SCALE);
+    ASSERT_EQ(queries.size(), NUM_QUERIES);
+
+    pathfinder::AStar<> astar(&map);
+    pathfinder::Dijkstra dijkstra(&map);
+    auto four = RunQueries(map, astar, queries);
+    map.SetConnectivity(Connectivity::EIGHT);
+    auto eight = RunQueries(map, astar, queries);
+    auto eight_dijkstra = RunQueries(map, dijkstra, queries);
+
+    double four_cost = 0.0, eight_cost = 0.0;
+    for (size_t i = 0; i < NUM_QUERIES; i++) {
+        four_cost += four.costs[i];
+        eight_cost += eight.costs[i];
+        EXPECT_NEAR(eight.costs[i], eight_dijkstra.costs[i], 1e-2f);
+    }
+    PrintResult("A* (4-connected)", four, NUM_QUERIES);
+    PrintResult("A* (8-connected, octile)", eight, NUM_QUERIES);
+    PrintResult("Dijkstra (8-connected)", eight_dijkstra, NUM_QUERIES);
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCHMARK] Path cost 8-connected / 4-connected: " << eight_cost / four_cost
+              << std::endl;
+
+    EXPECT_LT(eight_cost, four_cost * 0.9) << "diagonal moves should shorten long paths";
+}
+
+TEST(PathfinderPerformance, UnreachableGoals) {
+    std::cout << "\n=== Walled off goals: component check vs full search ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 50;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    // a closed ring of walls, painting it updates the components
+    auto t0 = Clock::now();
+    map.PaintRectangle(TilePos{150, 240}, TilePos{151, 271}, TileType::WALL);
+    map.PaintRectangle(TilePos{180, 240}, TilePos{181, 271}, TileType::WALL);
+    map.PaintRectangle(TilePos{150, 240}, TilePos{181, 241}, TileType::WALL);
+    map.PaintRectangle(TilePos{150, 270}, TilePos{181, 271}, TileType::WALL);
+    const double paint_ms = Duration(Clock::now() - t0).count();
+
+    const TilePos goal{165, 255};
+    std::vector<Query> queries;
+    for (const auto &query : RandomQueries(map, NUM_QUERIES)) {
+        queries.emplace_back(query.first, goal);
+        ASSERT_FALSE(map.IsReachable(query.first, goal));
+    }
+
+    // without the components a search only gives up after flooding
+    // everything reachable from the start
+    pathfinder::utils::PriorityQueue<> heap;
+    double flood_ms = 0.0;
+    for (const auto &query : queries) {
+        t0 = Clock::now();
+        FloodFill(map, query.first, heap);
+        flood_ms += Duration(Clock::now() - t0).count();
+    }
+
+    pathfinder::AStar<> astar(&map);
+    auto rejected = RunQueries(map, astar, queries);
+
+    PrintResult("A* (rejected)", rejected, NUM_QUERIES);
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCHMARK] Flood of the start component: " << flood_ms / NUM_QUERIES
+              << " ms per query\n"
+              << "[BENCHMARK] Painting the ring with component updates: " << paint_ms
+              << " ms" << std::endl;
+
+    EXPECT_EQ(rejected.expanded, 0);
+    EXPECT_LT(rejected.total_ms * 100, flood_ms)
+        << "rejecting by component should be far cheaper than searching";
+}
+
+TEST(PathfinderPerformance, TimeSlicedFrameBudget) {
+    std::cout << "\n=== Many orders at once: blocking vs time-sliced ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 100;
+    const size_t BUDGET = 20000; // nodes per frame
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = LongQueries(map, NUM_QUERIES, 100 * SCALE);
+    ASSERT_EQ(queries.size(), NUM_QUERIES);
+
+    // all searches in the frame the orders were given
+    pathfinder::AStar<> astar(&map);
+    auto blocking = RunQueries(map, astar, queries);
+
+    pathfinder::SlicedPathScheduler scheduler(&map);
+    for (const auto &[start, end] : queries) {
+        scheduler.Submit(map.TileToWorld(start), map.TileToWorld(end),
+                         pathfinder::PathFinderType::ASTAR);
+    }
+    size_t frames = 0, results = 0, expanded = 0, max_frame_expanded = 0;
+    double total_ms = 0.0, max_frame_ms = 0.0;
+    while (scheduler.GetPendingCount() > 0) {
+        auto t0 = Clock::now();
+        const size_t frame_expanded = scheduler.Update(BUDGET);
+        const double frame_ms = Duration(Clock::now() - t0).count();
+        results += scheduler.TakeResults().size();
+        frames++;
+        expanded += frame_expanded;
+        total_ms += frame_ms;
+        max_frame_ms = std::max(max_frame_ms, frame_ms);
+        max_frame_expanded = std::max(max_frame_expanded, frame_expanded);
+    }
+
+    PrintResult("A* (blocking)", blocking, NUM_QUERIES);
+    std::cout << std::fixed << std::setprecision(3)
+              << "[BENCHMARK] Time-sliced, " << BUDGET << " nodes per frame:\n"
+              << "  Frames: " << frames << ", total time: " << total_ms << " ms\n"
+              << "  Longest frame: " << max_frame_ms << " ms (blocking: "
+              << blocking.total_ms << " ms in one frame)\n"
+              << "  Expanded nodes: " << expanded << std::endl;
+
+    EXPECT_EQ(results, NUM_QUERIES);
+    EXPECT_EQ(expanded, blocking.expanded);
+    EXPECT_LE(max_frame_expanded, BUDGET);
+    EXPECT_LT(max_frame_ms * 10, blocking.total_ms)
+        << "a frame should only take a slice of the blocking time";
+}
+
+TEST(PathfinderPerformance, BoundedSuboptimalSearch) {
+    std::cout << "\n=== Weighted A* and focal search vs A* ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 50;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = LongQueries(map, NUM_QUERIES, 100 * SCALE);
+    ASSERT_EQ(queries.size(), NUM_QUERIES);
+
+    pathfinder::AStar<> astar(&map);
+    auto optimal = RunQueries(map, astar, queries);
+    PrintResult("A*", optimal, NUM_QUERIES);
+
+    pathfinder::WeightedAStar weighted(&map);
+    pathfinder::FocalAStar focal(&map);
+    for (float weight : {1.2f, 1.5f, 2.0f, 3.0f}) {
+        weighted.SetWeight(weight);
+        focal.SetWeight(weight);
+        for (pathfinder::BoundedAStarBase *pf :
+             std::initializer_list<pathfinder::BoundedAStarBase *>{&weighted, &focal}) {
+            // the reported factor is only available right after each query
+            RunResult result;
+            double worst = 1.0, cost_ratio = 0.0, reported = 0.0;
+            for (size_t i = 0; i < NUM_QUERIES; i++) {
+                const auto &[start, end] = queries[i];
+                auto t0 = Clock::now();
+                auto path = pf->CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+                result.total_ms += Duration(Clock::now() - t0).count();
+                result.expanded += pf->GetExpandedNodeCount();
+                const float ratio = PathCost(map, path) / optimal.costs[i];
+                EXPECT_LE(ratio, weight + 1e-3f) << pf->GetName();
+                EXPECT_GE(pf->GetSuboptimality(), ratio - 1e-3f) << pf->GetName();
+                reported += pf->GetSuboptimality();
+                worst = std::max(worst, static_cast<double>(ratio));
+                cost_ratio += ratio;
+            }
+            std::ostringstream name;
+            name << pf->GetName() << " (weight " << std::fixed << std::setprecision(1) << weight << ")";
+            PrintResult(name.str(), result, NUM_QUERIES);
+            std::cout << std::fixed << std::setprecision(3)
+                      << "  Cost / optimal: mean " << cost_ratio / NUM_QUERIES << ", worst "
+                      << worst << ", mean reported " << reported / NUM_QUERIES << std::endl;
+            if (pf == &weighted && weight >= 2.0f) {
+                EXPECT_LT(result.expanded, optimal.expanded)
+                    << "large weights should expand fewer nodes than A*";
+            }
+        }
+    }
+}
+
+TEST(PathfinderPerformance, SearchStatsPerType) {
+    std::cout << "\n=== Search statistics of every pathfinder type ===\n" << std::endl;
+
+    const int SCALE = 2; // 200x200 tiles
+    const size_t NUM_QUERIES = 30;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = LongQueries(map, NUM_QUERIES, 100 * SCALE);
+    ASSERT_EQ(queries.size(), NUM_QUERIES);
+
+    pathfinder::SearchStatsTable table;
+    for (int t = static_cast<int>(pathfinder::PathFinderType::BFS);
+         t < static_cast<int>(pathfinder::PathFinderType::COUNT); t++) {
+        const auto type = static_cast<pathfinder::PathFinderType>(t);
+        auto pf = pathfinder::utils::create(type, &map);
+        ASSERT_NE(pf, nullptr);
+        double outside_ms = 0.0;
+        for (const auto &[start, end] : queries) {
+            auto t0 = Clock::now();
+            pf->CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+            outside_ms += Duration(Clock::now() - t0).count();
+            table.Add(type, pf->GetName(), pf->GetLastStats());
+        }
+        // the measured time covers the search, the statistics add little
+        const auto stats = table.Get(type);
+        EXPECT_LE(stats.total.time_ms, outside_ms) << pf->GetName();
+        EXPECT_EQ(stats.found, NUM_QUERIES) << pf->GetName();
+    }
+
+    std::cout << std::left << std::setw(24) << "[BENCHMARK] type" << std::right
+              << std::setw(10) << "expanded" << std::setw(10) << "pushed"
+              << std::setw(10) << "frontier" << std::setw(10) << "time ms"
+              << std::setw(10) << "cost" << std::setw(10) << "subopt" << std::setw(12)
+              << "peak KiB" << std::endl;
+    for (int t = static_cast<int>(pathfinder::PathFinderType::BFS);
+         t < static_cast<int>(pathfinder::PathFinderType::COUNT); t++) {
+        const auto stats = table.Get(static_cast<pathfinder::PathFinderType>(t));
+        const auto mean = stats.Mean();
+        std::cout << std::left << std::setw(24) << std::string(stats.name) << std::right
+                  << std::fixed << std::setprecision(2) << std::setw(10)
+                  << mean.expanded_nodes << std::setw(10) << mean.pushed_nodes
+                  << std::setw(10) << mean.peak_frontier << std::setw(10) << mean.time_ms
+                  << std::setw(10) << mean.path_cost << std::setw(10)
+                  << mean.suboptimality << std::setw(12)
+                  << stats.peak.memory_bytes / 1024 << std::endl;
+    }
+}
+
+TEST(PathfinderPerformance, BatchSolveScaling) {
+    std::cout << "\n=== Batch of requests solved on several workers ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_QUERIES = 200;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    std::vector<pathfinder::PathRequest> requests;
+    pathfinder::RequestId id = 0;
+    for (const auto &[start, end] : RandomQueries(map, NUM_QUERIES)) {
+        requests.push_back({++id, map.TileToWorld(start), map.TileToWorld(end),
+                            pathfinder::PathFinderType::ASTAR});
+    }
+
+    pathfinder::AStar<> astar(&map);
+    auto sequential = RunQueries(map, astar, [&] {
+        std::vector<Query> queries;
+        for (const auto &request : requests) {
+            queries.emplace_back(map.WorldToTile(request.start), map.WorldToTile(request.goal));
+        }
+        return queries;
+    }());
+    std::cout << std::fixed << std::setprecision(0) << "[BENCHMARK] Sequential: "
+              << NUM_QUERIES / sequential.total_ms * 1000.0 << " queries/s" << std::endl;
+
+    const unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+    double best_ms = std::numeric_limits<double>::max();
+    for (size_t threads : {1, 2, 4, 8}) {
+        pathfinder::PathRequestService service(&map, threads);
+        service.SolveBatch(requests); // creates the pathfinders of the workers
+        auto t0 = Clock::now();
+        auto results = service.SolveBatch(requests);
+        const double ms = Duration(Clock::now() - t0).count();
+        ASSERT_EQ(results.size(), NUM_QUERIES);
+        for (size_t i = 0; i < NUM_QUERIES; i++) {
+            ASSERT_FLOAT_EQ(PathCost(map, results[i].path), sequential.costs[i]);
+        }
+        if (threads <= cores) {
+            best_ms = std::min(best_ms, ms);
+        }
+        std::cout << std::fixed << std::setprecision(0) << "[BENCHMARK] " << threads
+                  << " workers: " << NUM_QUERIES / ms * 1000.0 << " queries/s, speedup "
+                  << std::setprecision(2) << sequential.total_ms / ms << std::endl;
+    }
+    if (cores >= 2) {
+        EXPECT_LT(best_ms, sequential.total_ms) << "more workers should solve the batch faster";
+    }
+}
+
+TEST(PathfinderPerformance, FlowFieldCacheRepeatedTargets) {
+    std::cout << "\n=== Distance queries of many units to a few targets ===\n" << std::endl;
+
+    const int SCALE = 3; // 300x300 tiles
+    const size_t NUM_TARGETS = 8;
+    const size_t NUM_QUERIES = 50000;
+
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    auto queries = RandomQueries(map, NUM_TARGETS);
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<size_t> target(0, 2);
+    std::uniform_int_distribution<int> coord(0, 100 * SCALE - 1);
+
+    // half of the targets fit, the orders move between them over time
+    pathfinder::FlowFieldCache cache(&map);
+    const size_t field_size = cache.Get(queries[0].second)->GetMemoryUsage();
+    cache.SetMemoryCap(NUM_TARGETS / 2 * field_size);
+
+    double sum = 0.0;
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < NUM_QUERIES; i++) {
+        // every thousand queries the three targets in use shift by one
+        const TilePos goal = queries[(i / 1000 + target(gen)) % NUM_TARGETS].second;
+        auto field = cache.Get(goal);
+        const TilePos from{coord(gen), coord(gen)};
+        if (field->GetCost(from) != pathfinder::FlowField::kUnreachable) {
+            sum += field->GetCost(from);
+        }
+        if (auto next = field->GetNextTile(from)) {
+            sum += next->x();
+        }
+    }
+    const double ms = Duration(Clock::now() - t0).count();
+
+    pathfinder::Dijkstra dijkstra(&map);
+    auto single = RunQueries(map, dijkstra, {{queries[1].first, queries[1].second}});
+    std::cout << std::fixed << std::setprecision(3) << "[BENCHMARK] " << NUM_QUERIES
+              << " distance and next tile queries: " << ms << " ms, " << cache.GetMissCount()
+              << " fields built, " << cache.GetHitCount() << " hits, memory "
+              << cache.GetMemoryUsage() / 1024 << " KiB of " << cache.GetMemoryCap() / 1024
+              << " KiB\n"
+              << "  One Dijkstra search for comparison: " << single.total_ms << " ms" << std::endl;
+    EXPECT_LE(cache.GetMemoryUsage(), cache.GetMemoryCap());
+    EXPECT_LT(cache.GetMissCount(), NUM_QUERIES / 100) << "most queries should hit the cache";
+    EXPECT_GT(sum, 0.0);
+}
+
+TEST(PathfinderPerformance, CooperativeCrowd) {
+    std::cout << "\n=== Two groups crossing through a narrow gap ===\n" << std::endl;
+
+    const int ROWS = 30;
+    const int COLS = 41;
+    const size_t MAX_TICKS = 400;
+    const uint32_t WINDOW = 16;
+
+    // a wall splits the map, a gap of four tiles in the middle
+    Map map(ROWS, COLS);
+    map.PaintRectangle({0, COLS / 2}, {ROWS - 1, COLS / 2}, TileType::WALL);
+    map.PaintRectangle({13, COLS / 2}, {16, COLS / 2}, TileType::GRASS);
+
+    // two blocks of 4x4 agents, each one swaps sides with the other
+    std::vector<pathfinder::AgentQuery> agents;
+    const TilePos left_target{15, 6};
+    const TilePos right_target{15, COLS - 7};
+    auto left_goals = pathfinder::GoalsAround(map, right_target, 16);
+    auto right_goals = pathfinder::GoalsAround(map, left_target, 16);
+    for (int i = 0; i < 16; i++) {
+        agents.push_back({TilePos{13 + i / 4, 4 + i % 4}, left_goals[i]});
+    }
+    for (int i = 0; i < 16; i++) {
+        agents.push_back({TilePos{13 + i / 4, COLS - 8 + i % 4}, right_goals[i]});
+    }
+
+    struct Outcome {
+        size_t ticks = 0;
+        size_t stalls = 0;
+        size_t conflicts = 0;
+        size_t arrived = 0;
+        double ms = 0.0; // flow fields or planning
+    };
+    auto count_arrived = [&agents](const std::vector<TilePos> &pos) {
+        size_t arrived = 0;
+        for (size_t i = 0; i < agents.size(); i++) {
+            arrived += pos[i] == agents[i].goal;
+        }
+        return arrived;
+    };
+
+    // Every agent steps down its own flow field and waits while the next
+    // tile is taken, as the demo entities do without planning.
+    Outcome independent;
+    {
+        pathfinder::FlowFieldCache fields(&map);
+        std::vector<TilePos> pos;
+        std::vector<size_t> occupied(map.GetTileCount(), 0);
+        for (const auto &agent : agents) {
+            pos.push_back(agent.start);
+            occupied[map.TileToIndex(agent.start)]++;
+        }
+        auto t0 = Clock::now();
+        for (; independent.ticks < MAX_TICKS; independent.ticks++) {
+            if (count_arrived(pos) == agents.size()) {
+                break;
+            }
+            for (size_t i = 0; i < agents.size(); i++) {
+                if (pos[i] == agents[i].goal) {
+                    continue;
+                }
+                auto next = fields.Get(agents[i].goal)->GetNextTile(pos[i]);
+                if (!next || occupied[map.TileToIndex(*next)] > 0) {
+                    independent.stalls++;
+                    continue;
+                }
+                occupied[map.TileToIndex(pos[i])]--;
+                occupied[map.TileToIndex(*next)]++;
+                pos[i] = *next;
+            }
+        }
+        independent.ms = Duration(Clock::now() - t0).count();
+        independent.arrived = count_arrived(pos);
+    }
+
+    // WHCA*, all agents plan again every half window and follow their
+    // paths blindly in between
+    Outcome cooperative;
+    {
+        pathfinder::CooperativePlanner planner(&map, WINDOW);
+        std::vector<TilePos> pos;
+        for (const auto &agent : agents) {
+            pos.push_back(agent.start);
+        }
+        std::vector<pathfinder::AgentQuery> queries = agents;
+        std::vector<pathfinder::SpaceTimePath> paths;
+        size_t expanded = 0;
+        for (; cooperative.ticks < MAX_TICKS; cooperative.ticks++) {
+            if (count_arrived(pos) == agents.size()) {
+                break;
+            }
+            const size_t step = cooperative.ticks % (WINDOW / 2);
+            if (step == 0) {
+                for (size_t i = 0; i < agents.size(); i++) {
+                    queries[i].start = pos[i];
+                }
+                auto t0 = Clock::now();
+                paths = planner.Plan(queries);
+                cooperative.ms += Duration(Clock::now() - t0).count();
+                expanded += planner.GetExpandedNodeCount();
+            }
+            const std::vector<TilePos> before = pos;
+            for (size_t i = 0; i < agents.size(); i++) {
+                if (step + 1 < paths[i].size()) {
+                    pos[i] = paths[i][step + 1];
+                }
+                if (pos[i] == before[i] && pos[i] != agents[i].goal) {
+                    cooperative.stalls++;
+                }
+            }
+            for (size_t i = 0; i < agents.size(); i++) {
+                for (size_t j = i + 1; j < agents.size(); j++) {
+                    const bool swapped = pos[i] == before[j] && pos[j] == before[i];
+                    cooperative.conflicts += pos[i] == pos[j] || swapped;
+                }
+            }
+        }
+        cooperative.arrived = count_arrived(pos);
+        std::cout << "  Cooperative planning expanded " << expanded << " nodes" << std::endl;
+    }
+
+    for (const auto &[name, r] : {std::pair{"Independent", independent},
+                                  std::pair{"Cooperative", cooperative}}) {
+        std::cout << std::fixed << std::setprecision(3) << "[BENCHMARK] " << std::left
+                  << std::setw(12) << name << std::right << " arrived " << std::setw(2)
+                  << r.arrived << "/" << agents.size() << " after " << std::setw(3) << r.ticks
+                  << " ticks, stalls: " << std::setw(5) << r.stalls
+                  << ", conflicts: " << r.conflicts << ", time: " << r.ms << " ms"
+                  << std::endl;
+    }
+    EXPECT_EQ(cooperative.arrived, agents.size());
+    EXPECT_EQ(cooperative.conflicts, 0);
+    EXPECT_LT(cooperative.stalls, independent.stalls);
+}
+
+TEST(PathfinderPerformance, ConflictBasedSearchScaling) {
+    std::cout << "\n=== Optimal joint plans in the walled maze, growing groups ===\n" << std::endl;
+
+    // the walled part of the demo map, on grass
+    Map map(100, 100);
+    map.PaintLine(TilePos{71, 60}, TilePos{90, 60}, 1.0, TileType::WALL);
+    map.PaintLine(TilePos{77, 67}, TilePos{100, 67}, 1.0, TileType::WALL);
+    map.PaintLine(TilePos{71, 60}, TilePos{71, 75}, 1.0, TileType::WALL);
+    map.PaintLine(TilePos{72, 73}, TilePos{95, 73}, 1.0, TileType::WALL);
+    map.PaintLine(TilePos{95, 73}, TilePos{95, 90}, 1.0, TileType::WALL);
+    map.PaintLine(TilePos{71, 81}, TilePos{71, 100}, 1.0, TileType::WALL);
+    map.PaintLine(TilePos{72, 81}, TilePos{90, 81}, 1.0, TileType::WALL);
+    map.PaintLine(TilePos{89, 87}, TilePos{89, 100}, 1.0, TileType::WALL);
+    map.PaintLine(TilePos{84, 81}, TilePos{84, 96}, 1.0, TileType::WALL);
+    map.PaintLine(TilePos{78, 87}, TilePos{78, 100}, 1.0, TileType::WALL);
+
+    // distinct starts and goals inside the maze, fixed seed
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> row(70, 99);
+    std::uniform_int_distribution<int> col(60, 99);
+    std::vector<pathfinder::AgentQuery> all;
+    std::vector<bool> start_used(map.GetTileCount()), goal_used(map.GetTileCount());
+    while (all.size() < 32) {
+        const TilePos start{row(gen), col(gen)};
+        const TilePos goal{row(gen), col(gen)};
+        if (!map.IsReachable(start, goal) || start_used[map.TileToIndex(start)] ||
+            goal_used[map.TileToIndex(goal)]) {
+            continue;
+        }
+        start_used[map.TileToIndex(start)] = true;
+        goal_used[map.TileToIndex(goal)] = true;
+        all.push_back({start, goal});
+    }
+
+    auto status_name = [](pathfinder::ConflictBasedSearch::Status status) {
+        switch (status) {
+        case pathfinder::ConflictBasedSearch::Status::SOLVED:
+            return "solved";
+        case pathfinder::ConflictBasedSearch::Status::NODE_LIMIT:
+            return "node limit";
+        case pathfinder::ConflictBasedSearch::Status::TIME_LIMIT:
+            return "time limit";
+        default:
+            return "no solution";
+        }
+    };
+
+    pathfinder::ConflictBasedSearch cbs(&map, {20000, 1000.0});
+    std::cout << std::left << std::setw(10) << "  agents" << std::setw(14) << "status"
+              << std::right << std::setw(10) << "CT nodes" << std::setw(12) << "expanded"
+              << std::setw(12) << "time ms" << std::setw(10) << "cost" << std::setw(12)
+              << "conflicts" << std::endl;
+    size_t solved = 0;
+    for (size_t count : {2, 4, 8, 12, 16, 24, 32}) {
+        const std::span<const pathfinder::AgentQuery> agents(all.data(), count);
+        auto t0 = Clock::now();
+        auto result = cbs.Solve(agents);
+        const double ms = Duration(Clock::now() - t0).count();
+        std::cout << std::left << std::setw(10) << "  " + std::to_string(count) << std::setw(14)
+                  << status_name(result.status) << std::right << std::setw(10)
+                  << cbs.GetNodeCount() << std::setw(12) << cbs.GetExpandedNodeCount()
+                  << std::fixed << std::setprecision(3) << std::setw(12) << ms
+                  << std::setprecision(1) << std::setw(10) << result.cost << std::setw(12)
+                  << result.conflicts << std::endl;
+        if (result.status == pathfinder::ConflictBasedSearch::Status::SOLVED) {
+            solved++;
+            EXPECT_EQ(pathfinder::CountConflicts(result.paths), 0);
+        }
+        // the limits bound the work no matter how many agents
+        EXPECT_LE(cbs.GetNodeCount(), cbs.GetLimits().max_nodes);
+        EXPECT_LT(ms, 4 * cbs.GetLimits().max_time_ms);
+    }
+    std::cout << "[BENCHMARK] CBS solved " << solved << " of 7 group sizes within "
+              << cbs.GetLimits().max_nodes << " nodes and " << cbs.GetLimits().max_time_ms
+              << " ms" << std::endl;
+    EXPECT_GE(solved, 2) << "small groups should always be solved";
+}
+
+TEST(PathfinderPerformance, ParallelIntegrationScaling) {
+    std::cout << "\n=== Distance field of a 1000x1000 map on several threads ===\n" << std::endl;
+
+    const int SCALE = 10; // 1000x1000 tiles
+    Map map(100 * SCALE, 100 * SCALE);
+    PaintDemoLikeMap(map, SCALE);
+    const TilePos target{30 * SCALE, 40 * SCALE};
+
+    auto t0 = Clock::now();
+    const pathfinder::FlowField reference(&map, target);
+    const double sequential_ms = Duration(Clock::now() - t0).count();
+    std::cout << std::fixed << std::setprecision(3) << "  Sequential Dijkstra: " << sequential_ms
+              << " ms, expanded " << reference.GetExpandedNodeCount() << std::endl;
+
+    std::vector<float> costs;
+    std::vector<uint32_t> next;
+    for (size_t threads : {1, 2, 4, 8}) {
+        pathfinder::ParallelIntegrator integrator(&map, threads);
+        t0 = Clock::now();
+        integrator.Integrate(target, costs, next);
+        const double ms = Duration(Clock::now() - t0).count();
+
+        float worst = 0.0f;
+        for (size_t idx = 0; idx < map.GetTileCount(); idx++) {
+            const float expected = reference.GetCost(map.IndexToTile(idx));
+            if (expected == pathfinder::FlowField::kUnreachable) {
+                ASSERT_EQ(costs[idx], expected);
+            } else if (expected > 0.0f) {
+                worst = std::max(worst, std::abs(costs[idx] - expected) / expected);
+            }
+        }
+        std::cout << "[BENCHMARK] " << threads << " threads: " << std::setprecision(3) << ms
+                  << " ms (" << std::setprecision(2) << sequential_ms / ms
+                  << "x sequential), expanded " << integrator.GetExpandedNodeCount() << " in "
+                  << integrator.GetRoundCount() << " turns, worst relative difference "
+                  << std::scientific << worst << std::fixed << std::endl;
+        EXPECT_LE(worst, 1e-5f);
+    }
+    std::cout << "  " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+}
+
+TEST(PathfinderPerformance, FollowedPathCursor) {
+    std::cout << "\n=== Walking a long route: erase from front vs cursor ===\n" << std::endl;
+
+    const size_t NUM_ENTITIES = 50;
+    const size_t NUM_POINTS = 5000;
+
+    pathfinder::Path route;
+    for (size_t i = 0; i < NUM_POINTS; i++) {
+        route.push_back(WorldPos{static_cast<float>(i), static_cast<float>(i % 7)});
+    }
+
+    // every entity gets a copy and erases every reached point
+    double erase_sum = 0.0;
+    auto t0 = Clock::now();
+    size_t copied_bytes = 0;
+    for (size_t e = 0; e < NUM_ENTITIES; e++) {
+        pathfinder::Path path = route;
+        copied_bytes += path.capacity() * sizeof(WorldPos);
+        while (!path.empty()) {
+            erase_sum += path.front().y();
+            path.erase(path.begin());
+        }
+    }
+    const double erase_ms = Duration(Clock::now() - t0).count();
+
+    // every entity shares the route and moves its cursor
+    double cursor_sum = 0.0;
+    t0 = Clock::now();
+    const auto shared = std::make_shared<const pathfinder::Path>(route);
+    std::vector<pathfinder::FollowedPath> paths;
+    for (size_t e = 0; e < NUM_ENTITIES; e++) {
+        paths.emplace_back(shared);
+    }
+    size_t shared_bytes = 0;
+    for (const auto &path : paths) {
+        shared_bytes += path.GetMemoryUsage();
+    }
+    for (auto &path : paths) {
+        while (!path.empty()) {
+            cursor_sum += path.front().y();
+            path.pop_front();
+        }
+    }
+    const double cursor_ms = Duration(Clock::now() - t0).count();
+
+    std::cout << std::fixed << std::setprecision(3) << "[BENCHMARK] " << NUM_ENTITIES
+              << " entities, " << NUM_POINTS << " points each\n"
+              << "  Erase from front: " << erase_ms << " ms, " << copied_bytes / 1024
+              << " KiB of copies\n"
+              << "  Shared cursor:    " << cursor_ms << " ms, " << shared_bytes / 1024
+              << " KiB (speedup " << std::setprecision(1) << erase_ms / cursor_ms << "x)"
+              << std::endl;
+    EXPECT_EQ(erase_sum, cursor_sum);
+    EXPECT_LT(cursor_ms, erase_ms);
+    EXPECT_LT(shared_bytes, copied_bytes / NUM_ENTITIES + 64);
+}
@@ -0,0 +1,2273 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "map.hpp"
+#include "math.hpp"
+#include "movingai.hpp"
+#include "pathfinder/astar.hpp"
+#include "pathfinder/base.hpp"
+#include "pathfinder/bfs.hpp"
+#include "pathfinder/bidirectional.hpp"
+#include "pathfinder/bounded_astar.hpp"
+#include "pathfinder/cbs.hpp"
+#include "pathfinder/cooperative.hpp"
+#include "pathfinder/dijkstra.hpp"
+#include "pathfinder/dstar_lite.hpp"
+#include "pathfinder/flow_field.hpp"
+#include "pathfinder/followed_path.hpp"
+#include "pathfinder/gbfs.hpp"
+#include "pathfinder/hpa.hpp"
+#include "pathfinder/jps.hpp"
+#include "pathfinder/landmarks.hpp"
+#include "pathfinder/parallel_integrator.hpp"
+#include "pathfinder/path_cache.hpp"
+#include "pathfinder/request_service.hpp"
+#include "pathfinder/search_state.hpp"
+#include "pathfinder/search_stats.hpp"
+#include "pathfinder/sliced_scheduler.hpp"
+#include "pathfinder/theta_star.hpp"
+#include "pathfinder/utils.hpp"
+#include "tile.hpp"
+
+namespace {
+
+// Small version of the demo map: water, roads, a bridge and some walls
+void PaintTestMap(Map &map) {
+  map.PaintCircle(TilePos{25, 25}, 8, TileType::WATER);
+  map.PaintLine(TilePos{0, 0}, TilePos{50, 50}, 2.0, TileType::WATER);
+  map.PaintLine(TilePos{8, 3}, TilePos{50, 3}, 3.0, TileType::ROAD);
+  map.PaintLine(TilePos{5, 8}, TilePos{5, 50}, 3.0, TileType::ROAD);
+  map.PaintLine(TilePos{25, 35}, TilePos{35, 35}, 3.0, TileType::WOOD);
+  map.PaintLine(TilePos{36, 30}, TilePos{45, 30}, 1.0, TileType::WALL);
+  map.PaintLine(TilePos{36, 30}, TilePos{36, 45}, 1.0, TileType::WALL);
+}
+
+// Random blobs and strokes of all tile types
+void PaintRandomMap(Map &map, unsigned seed) {
+  std::mt19937 gen(seed);
+  const int rows = static_cast<int>(map.GetRows());
+  const int cols = static_cast<int>(map.GetCols());
+  std::uniform_int_distribution<int> row_dist(0, rows - 1);
+  std::uniform_int_distribution<int> col_dist(0, cols - 1);
+  std::uniform_int_distribution<int> type_dist(0, 4);
+  std::uniform_int_distribution<unsigned> radius_dist(1, 6);
+  for (int i = 0; i < 12; i++) {
+    auto type = static_cast<TileType>(type_dist(gen));
+    map.PaintCircle(TilePos{row_dist(gen), col_dist(gen)}, radius_dist(gen),
+                    type);
+    type = static_cast<TileType>(type_dist(gen));
+    map.PaintLine(TilePos{row_dist(gen), col_dist(gen)},
+                  TilePos{row_dist(gen), col_dist(gen)}, 1.0 + i % 3, type);
+  }
+}
+
+// Sum of costs of all tiles entered along the path (start tile excluded),
+// diagonal steps cost sqrt(2) times the tile
+float PathCost(const Map &map, const pathfinder::Path &path) {
+  float cost = 0.0f;
+  for (size_t i = 1; i < path.size(); i++) {
+    const TilePos a = map.WorldToTile(path[i - 1]);
+    const TilePos b = map.WorldToTile(path[i]);
+    const float step = a.x() != b.x() && a.y() != b.y()
+                           ? std::numbers::sqrt2_v<float>
+                           : 1.0f;
+    cost += step * map.GetCost(b);
+  }
+  return cost;
+}
+
+// Every step of the path has to move to a neighbouring tile, diagonals only
+// on 8-connected maps, never into a wall and never past its corner
+bool IsPathContinuous(const Map &map, const pathfinder::Path &path) {
+  const auto &wall = tile_types.at(TileType::WALL);
+  for (size_t i = 1; i < path.size(); i++) {
+    TilePos a = map.WorldToTile(path[i - 1]);
+    TilePos b = map.WorldToTile(path[i]);
+    const int dx = std::abs(a.x() - b.x());
+    const int dy = std::abs(a.y() - b.y());
+    if (map.GetTileAt(b) == &wall)
+      return false;
+    if (dx + dy == 1)
+      continue;
+    if (map.GetConnectivity() != Connectivity::EIGHT || dx != 1 || dy != 1)
+      return false;
+    if (map.GetTileAt(TilePos{a.x(), b.y()}) == &wall ||
+        map.GetTileAt(TilePos{b.x(), a.y()}) == &wall)
+      return false;
+  }
+  return true;
+}
+
+const std::vector<std::pair<TilePos, TilePos>> test_queries = {
+    {TilePos{1, 1}, TilePos{48, 48}},  {TilePos{48, 1}, TilePos{1, 48}},
+    {TilePos{40, 40}, TilePos{2, 2}},  {TilePos{10, 30}, TilePos{44, 33}},
+    {TilePos{25, 25}, TilePos{49, 0}}, {TilePos{0, 49}, TilePos{38, 38}},
+};
+
+// Times two agents stand on the same tile or swap tiles in the first
+// "ticks" ticks, agents stay on the last tile of their path
+size_t CountConflicts(const std::vector<pathfinder::SpaceTimePath> &paths,
+                      size_t ticks) {
+  auto at = [](const pathfinder::SpaceTimePath &path, size_t tick) {
+    return path[std::min(tick, path.size() - 1)];
+  };
+  size_t conflicts = 0;
+  for (size_t tick = 0; tick <= ticks; tick++) {
+    for (size_t i = 0; i < paths.size(); i++) {
+      for (size_t j = i + 1; j < paths.size(); j++) {
+        if (paths[i].empty() || paths[j].empty())
+          continue;
+        if (at(paths[i], tick) == at(paths[j], tick))
+          conflicts++;
+        else if (tick > 0 && at(paths[i], tick) == at(paths[j], tick - 1) &&
+                 at(paths[j], tick) == at(paths[i], tick - 1))
+          conflicts++;
+      }
+    }
+  }
+  return conflicts;
+}
+
+} // namespace
+
+TEST(Map, TileIndex) {
+  // Test that flat tile index is row * cols + col and round-trips
+  Map map(4, 7);
+  ASSERT_EQ(map.GetTileCount(), 28);
+  ASSERT_EQ(map.TileToIndex(TilePos{2, 3}), 2 * 7 + 3);
+  for (size_t i = 0; i < map.GetTileCount(); i++) {
+    ASSERT_EQ(map.TileToIndex(map.IndexToTile(i)), i);
+  }
+}
+
+TEST(Map, VersionAndChanges) {
+  // Test that painting bumps the version and records the painted area
+  Map map(30, 30);
+  ASSERT_EQ(map.GetVersion(), 0);
+  map.PaintRectangle(TilePos{2, 3}, TilePos{5, 8}, TileType::WATER);
+  ASSERT_EQ(map.GetVersion(), 1);
+  // painting the same again changes nothing
+  map.PaintRectangle(TilePos{2, 3}, TilePos{5, 8}, TileType::WATER);
+  ASSERT_EQ(map.GetVersion(), 1);
+  map.PaintLine(TilePos{20, 0}, TilePos{20, 10}, 1.0, TileType::ROAD);
+  ASSERT_EQ(map.GetVersion(), 2);
+
+  auto changes = map.GetChangesSince(0);
+  ASSERT_EQ(changes.size(), 2);
+  ASSERT_EQ(changes[0].version, 1);
+  ASSERT_EQ(changes[0].area.min, (TilePos{2, 3}));
+  ASSERT_EQ(changes[0].area.max, (TilePos{4, 7}));
+  ASSERT_TRUE(changes[1].area.Contains(TilePos{20, 5}));
+  ASSERT_EQ(map.GetChangesSince(1).size(), 1);
+  ASSERT_TRUE(map.GetChangesSince(2).empty());
+}
+
+TEST(Map, ChangeLogIsBounded) {
+  // Test that many paints keep the change log short while the changes since
+  // any version still cover every painted tile
+  Map map(30, 30);
+  // tile painted by every version, the first one at index 0
+  std::vector<TilePos> painted;
+  for (int i = 0; i < 300; i++) {
+    const TilePos tile{i % 30, i * 7 % 30};
+    map.PaintRectangle(tile, tile + TilePos{1, 1},
+                       i / 30 % 2 ? TileType::ROAD : TileType::WATER);
+    if (map.GetVersion() > painted.size())
+      painted.push_back(tile);
+  }
+  ASSERT_GT(map.GetVersion(), Map::kMaxChanges);
+  ASSERT_LE(map.GetChangesSince(0).size(), Map::kMaxChanges);
+  for (uint64_t version : {uint64_t{0}, uint64_t{100}, map.GetVersion() - 1}) {
+    for (uint64_t v = version; v < map.GetVersion(); v++) {
+      const TilePos tile = painted[v];
+      const auto changes = map.GetChangesSince(version);
+      ASSERT_TRUE(std::ranges::any_of(changes, [&](const MapChange &c) {
+        return c.version > version && c.area.Contains(tile);
+      })) << tile << " since " << version;
+    }
+  }
+  // the newest changes are kept as they are
+  ASSERT_EQ(map.GetChangesSince(map.GetVersion() - 1).size(), 1);
+  ASSERT_EQ(map.GetChangesSince(map.GetVersion() - 1)[0].area.min,
+            painted.back());
+}
+
+TEST(Map, Neighbors) {
+  // Test that interior and border tiles get the right neighbours, indices
+  // and costs, also on maps too thin to have an interior
+  Map map(6, 9);
+  map.PaintRectangle(TilePos{2, 4}, TilePos{3, 5}, TileType::WATER);
+  for (size_t i = 0; i < map.GetTileCount(); i++) {
+    const TilePos tile = map.IndexToTile(i);
+    std::set<size_t> expected;
+    for (TilePos step : {TilePos{1, 0}, TilePos{-1, 0}, TilePos{0, 1},
+                         TilePos{0, -1}}) {
+      if (map.IsTilePosValid(tile + step))
+        expected.insert(map.TileToIndex(tile + step));
+    }
+    std::set<size_t> found;
+    for (const Neighbor &next : map.GetNeighbors(tile)) {
+      ASSERT_EQ(next.index, map.TileToIndex(next.pos));
+      ASSERT_EQ(next.cost, map.GetCost(next.pos));
+      found.insert(next.index);
+    }
+    ASSERT_EQ(found, expected);
+  }
+  ASSERT_EQ(map.GetNeighbors(TilePos{1, 4})[0].cost,
+            tile_types.at(TileType::WATER).cost);
+
+  Map row(1, 5);
+  ASSERT_EQ(row.GetNeighbors(TilePos{0, 2}).size(), 2);
+  Map single(1, 1);
+  ASSERT_TRUE(single.GetNeighbors(TilePos{0, 0}).empty());
+}
+
+TEST(Map, DiagonalNeighbors) {
+  // Test that 8-connected maps add the diagonals with sqrt(2) costs, except
+  // the ones that would cut the corner of a wall, and never lead into walls
+  Map map(7, 9);
+  map.PaintRectangle(TilePos{3, 4}, TilePos{4, 5}, TileType::WALL);
+  map.PaintRectangle(TilePos{0, 8}, TilePos{1, 9}, TileType::WATER);
+  const uint64_t version = map.GetVersion();
+  map.SetConnectivity(Connectivity::EIGHT);
+  ASSERT_EQ(map.GetVersion(), version + 1);
+  ASSERT_TRUE(map.GetChangesSince(version).back().area.Contains(
+      TilePos{6, 8}));
+  map.SetConnectivity(Connectivity::EIGHT);
+  ASSERT_EQ(map.GetVersion(), version + 1);
+
+  const Tile *wall = &tile_types.at(TileType::WALL);
+  for (size_t i = 0; i < map.GetTileCount(); i++) {
+    const TilePos tile = map.IndexToTile(i);
+    std::set<size_t> expected;
+    for (int dx = -1; dx <= 1; dx++) {
+      for (int dy = -1; dy <= 1; dy++) {
+        const TilePos next = tile + TilePos{dx, dy};
+        if ((dx == 0 && dy == 0) || !map.IsTilePosValid(next) ||
+            map.GetTileAt(next) == wall)
+          continue;
+        if (dx != 0 && dy != 0 &&
+            (map.GetTileAt(tile + TilePos{dx, 0}) == wall ||
+             map.GetTileAt(tile + TilePos{0, dy}) == wall))
+          continue;
+        expected.insert(map.TileToIndex(next));
+      }
+    }
+    std::set<size_t> found;
+    for (const Neighbor &next : map.GetNeighbors(tile)) {
+      const bool diagonal =
+          next.pos.x() != tile.x() && next.pos.y() != tile.y();
+      ASSERT_EQ(next.index, map.TileToIndex(next.pos));
+      ASSERT_FLOAT_EQ(next.step,
+                      diagonal ? std::numbers::sqrt2_v<float> : 1.0f);
+      ASSERT_FLOAT_EQ(next.cost, next.step * map.GetCost(next.pos));
+      found.insert(next.index);
+    }
+    ASSERT_EQ(found, expected) << tile;
+  }
+  // a wall tile can still be left in every direction, next to it the wall
+  // and the diagonals across its corners are missing
+  ASSERT_EQ(map.GetNeighbors(TilePos{3, 4}).size(), 8);
+  ASSERT_EQ(map.GetNeighbors(TilePos{2, 4}).size(), 5);
+
+  map.SetConnectivity(Connectivity::FOUR);
+  ASSERT_EQ(map.GetNeighbors(TilePos{2, 2}).size(), 4);
+}
+
+TEST(Map, Components) {
+  // Test that the incrementally updated components match a flood fill of
+  // the passable tiles after every paint, blocking and opening tiles
+  Map map(30, 30);
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<int> dist(0, 29);
+  for (int i = 0; i < 60; i++) {
+    const TileType type = i % 3 == 2 ? TileType::GRASS : TileType::WALL;
+    if (i % 2)
+      map.PaintLine(TilePos{dist(gen), dist(gen)},
+                    TilePos{dist(gen), dist(gen)}, 1.0, type);
+    else
+      map.PaintCircle(TilePos{dist(gen), dist(gen)}, 1 + i % 4, type);
+
+    // reference labels, one flood fill per component
+    std::vector<int> reference(map.GetTileCount(), -1);
+    int components = 0;
+    for (size_t idx = 0; idx < map.GetTileCount(); idx++) {
+      if (!map.IsPassable(map.IndexToTile(idx)) || reference[idx] >= 0)
+        continue;
+      std::vector<TilePos> stack{map.IndexToTile(idx)};
+      reference[idx] = components;
+      while (!stack.empty()) {
+        const TilePos tile = stack.back();
+        stack.pop_back();
+        for (const Neighbor &next : map.GetNeighbors(tile)) {
+          if (reference[next.index] < 0) {
+            reference[next.index] = components;
+            stack.push_back(next.pos);
+          }
+        }
+      }
+      components++;
+    }
+
+    // same partition, possibly different labels
+    std::map<int, uint32_t> labels;
+    std::set<uint32_t> used;
+    for (size_t idx = 0; idx < map.GetTileCount(); idx++) {
+      const uint32_t component = map.GetComponent(map.IndexToTile(idx));
+      if (reference[idx] < 0) {
+        ASSERT_EQ(component, Map::kNoComponent);
+        continue;
+      }
+      auto [it, inserted] = labels.try_emplace(reference[idx], component);
+      ASSERT_EQ(it->second, component) << map.IndexToTile(idx);
+      if (inserted) {
+        ASSERT_TRUE(used.insert(component).second) << map.IndexToTile(idx);
+      }
+    }
+  }
+
+  // a wall across the map splits it, a hole joins both sides again
+  Map split(10, 10);
+  ASSERT_TRUE(split.IsReachable(TilePos{0, 0}, TilePos{9, 9}));
+  split.PaintRectangle(TilePos{0, 5}, TilePos{10, 6}, TileType::WALL);
+  ASSERT_FALSE(split.IsReachable(TilePos{0, 0}, TilePos{9, 9}));
+  ASSERT_FALSE(split.IsReachable(TilePos{0, 0}, TilePos{0, 5}));
+  ASSERT_TRUE(split.IsReachable(TilePos{0, 0}, TilePos{9, 4}));
+  split.PaintRectangle(TilePos{7, 5}, TilePos{8, 6}, TileType::WATER);
+  ASSERT_TRUE(split.IsReachable(TilePos{0, 0}, TilePos{9, 9}));
+  ASSERT_FALSE(split.IsReachable(TilePos{0, 0}, TilePos{20, 0}));
+}
+
+TEST(Map, PaintCircleOnNonSquareMap) {
+  // Test that circles near the edge of a non-square map stay on the map
+  Map map(10, 40);
+  map.PaintCircle(TilePos{35, 5}, 6, TileType::WATER);
+  ASSERT_EQ(map.GetTileAt(TilePos{5, 35}), &tile_types.at(TileType::WATER));
+  ASSERT_EQ(map.GetTileAt(TilePos{5, 5}), &tile_types.at(TileType::GRASS));
+}
+
+TEST(SearchState, ResetInvalidatesNodes) {
+  // Test that Reset() forgets all nodes of the previous search
+  Map map(5, 5);
+  pathfinder::SearchState state;
+  state.Reset(&map);
+  state.Visit(3, 1.5f, 2);
+  ASSERT_TRUE(state.IsVisited(3));
+  ASSERT_FALSE(state.IsVisited(4));
+  ASSERT_FLOAT_EQ(state.GetCost(3), 1.5f);
+  ASSERT_EQ(state.GetCameFrom(3), 2);
+  state.Reset(&map);
+  ASSERT_FALSE(state.IsVisited(3));
+
+  // different map size reallocates the nodes
+  Map bigger(10, 10);
+  state.Reset(&bigger);
+  state.Visit(99, 0.0f, 99);
+  ASSERT_TRUE(state.IsVisited(99));
+}
+
+TEST(SearchState, RepeatedQueries) {
+  // Test that reusing the pathfinders gives the same result every time
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::BFS bfs(&map);
+  pathfinder::Dijkstra dijkstra(&map);
+  pathfinder::GBFS gbfs(&map);
+  for (pathfinder::PathFinderBase *pf :
+       std::vector<pathfinder::PathFinderBase *>{&bfs, &dijkstra, &gbfs}) {
+    const auto start = map.TileToWorld(TilePos{1, 1});
+    const auto end = map.TileToWorld(TilePos{48, 48});
+    auto first = pf->CalculatePath(start, end);
+    ASSERT_FALSE(first.empty());
+    ASSERT_TRUE(IsPathContinuous(map, first));
+    // unrelated query in between
+    pf->CalculatePath(map.TileToWorld(TilePos{40, 2}),
+                      map.TileToWorld(TilePos{3, 30}));
+    auto second = pf->CalculatePath(start, end);
+    ASSERT_EQ(first.size(), second.size());
+    ASSERT_FLOAT_EQ(PathCost(map, first), PathCost(map, second));
+  }
+}
+
+TEST(RadixHeap, SameOrderAsPriorityQueue) {
+  // Test that a monotone workload pops the same costs from both queues
+  std::mt19937 gen(5);
+  const float costs[] = {0.0f, 0.5f, 1.0f, 10.0f, 1000.0f};
+  std::uniform_int_distribution<int> pick(0, 4);
+  std::uniform_int_distribution<int> fanout(0, 4);
+  pathfinder::utils::PriorityQueue<> heap;
+  pathfinder::utils::RadixHeap<> radix;
+  heap.push({0.0f, TilePos{0, 0}});
+  radix.push({0.0f, TilePos{0, 0}});
+
+  for (int i = 0; i < 20000 && !heap.empty(); i++) {
+    ASSERT_EQ(radix.size(), heap.size());
+    const float cost = heap.top().cost;
+    ASSERT_EQ(radix.top().cost, cost);
+    heap.pop();
+    radix.pop();
+    // like a search: push the popped cost plus one of the tile costs
+    for (int n = fanout(gen); n > 0 && heap.size() < 1000; n--) {
+      const float next = cost + costs[pick(gen)];
+      heap.push({next, TilePos{i, n}});
+      radix.push({next, TilePos{i, n}});
+    }
+  }
+  radix.clear();
+  ASSERT_TRUE(radix.empty());
+
+  // once empty, the heap can be reused for a new search
+  radix.push({5.0f, TilePos{1, 1}});
+  radix.pop();
+  radix.push({1.0f, TilePos{2, 2}});
+  radix.push({0.5f, TilePos{3, 3}});
+  ASSERT_EQ(radix.top().cost, 0.5f);
+}
+
+TEST(RadixHeap, DijkstraSameCost) {
+  // Test that Dijkstra gives the same costs with either frontier
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::Dijkstra dijkstra(&map);
+  pathfinder::Dijkstra<pathfinder::utils::RadixHeap<>> radix(&map);
+  for (const auto &[start, end] : test_queries) {
+    auto reference = dijkstra.CalculatePath(map.TileToWorld(start),
+                                            map.TileToWorld(end));
+    auto path =
+        radix.CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+    ASSERT_TRUE(IsPathContinuous(map, path));
+    ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference));
+  }
+}
+
+TEST(Heuristic, Values) {
+  // Test the raw heuristic values (unit scale)
+  TilePos a{0, 0};
+  TilePos b{3, 4};
+  ASSERT_FLOAT_EQ(pathfinder::heuristic::Manhattan{1.0f}(a, b), 7.0f);
+  ASSERT_FLOAT_EQ(pathfinder::heuristic::Euclidean{1.0f}(a, b), 5.0f);
+  ASSERT_NEAR(pathfinder::heuristic::Octile{1.0f}(a, b), 4.0f + 3.0f * 0.4142f,
+              1e-3f);
+  ASSERT_FLOAT_EQ(pathfinder::heuristic::Zero{}(a, b), 0.0f);
+}
+
+TEST(Heuristic, ScaledByCheapestTile) {
+  // Default heuristics are scaled by the cheapest tile (ROAD)
+  ASSERT_FLOAT_EQ(pathfinder::utils::cheapest_tile_cost(),
+                  tile_types.at(TileType::ROAD).cost);
+  ASSERT_FLOAT_EQ(pathfinder::heuristic::Manhattan{}(TilePos{0, 0},
+                                                     TilePos{0, 10}),
+                  10.0f * tile_types.at(TileType::ROAD).cost);
+}
+
+TEST(AStar, CreatedByUtils) {
+  // Test that A* can be created through the factory
+  Map map(10, 10);
+  auto pf =
+      pathfinder::utils::create(pathfinder::PathFinderType::ASTAR, &map);
+  ASSERT_NE(pf, nullptr);
+  ASSERT_EQ(pf->GetName(), "A*");
+}
+
+TEST(AStar, SameCostAsDijkstra) {
+  // Test that every heuristic keeps A* optimal
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::Dijkstra dijkstra(&map);
+  pathfinder::AStar<pathfinder::heuristic::Manhattan> manhattan(&map);
+  pathfinder::AStar<pathfinder::heuristic::Octile> octile(&map);
+  pathfinder::AStar<pathfinder::heuristic::Euclidean> euclidean(&map);
+  pathfinder::AStar<pathfinder::heuristic::Zero> zero(&map);
+  pathfinder::AStar<pathfinder::heuristic::Manhattan,
+                    pathfinder::utils::RadixHeap<>>
+      radix(&map);
+  std::vector<pathfinder::PathFinderBase *> astars = {&manhattan, &octile,
+                                                      &euclidean, &zero,
+                                                      &radix};
+
+  for (const auto &[start, end] : test_queries) {
+    auto reference = dijkstra.CalculatePath(map.TileToWorld(start),
+                                            map.TileToWorld(end));
+    ASSERT_FALSE(reference.empty());
+    for (auto *astar : astars) {
+      auto path =
+          astar->CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+      ASSERT_FALSE(path.empty());
+      ASSERT_EQ(map.WorldToTile(path.front()), start);
+      ASSERT_EQ(map.WorldToTile(path.back()), end);
+      ASSERT_TRUE(IsPathContinuous(map, path));
+      ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference));
+    }
+  }
+}
+
+TEST(AStar, InvalidQueries) {
+  // Test that out-of-map and trivial queries return empty path
+  Map map(10, 10);
+  pathfinder::AStar<> astar(&map);
+  ASSERT_TRUE(astar.CalculatePath(map.TileToWorld(TilePos{1, 1}),
+                                  map.TileToWorld(TilePos{20, 1}))
+                  .empty());
+  ASSERT_TRUE(astar.CalculatePath(map.TileToWorld(TilePos{3, 3}),
+                                  map.TileToWorld(TilePos{3, 3}))
+                  .empty());
+}
+
+TEST(Bidirectional, SameCostAsDijkstra) {
+  // Test that both bidirectional variants stay optimal on weighted maps
+  std::mt19937 gen(99);
+  std::uniform_int_distribution<int> dist(0, 39);
+  for (unsigned seed = 0; seed < 10; seed++) {
+    Map map(40, 40);
+    PaintRandomMap(map, seed);
+    pathfinder::Dijkstra dijkstra(&map);
+    pathfinder::BidirectionalDijkstra bidijkstra(&map);
+    pathfinder::BidirectionalAStar biastar(&map);
+    for (int i = 0; i < 20; i++) {
+      const TilePos start{dist(gen), dist(gen)};
+      const TilePos end{dist(gen), dist(gen)};
+      auto reference = dijkstra.CalculatePath(map.TileToWorld(start),
+                                              map.TileToWorld(end));
+      for (pathfinder::PathFinderBase *pf :
+           {(pathfinder::PathFinderBase *)&bidijkstra,
+            (pathfinder::PathFinderBase *)&biastar}) {
+        auto path =
+            pf->CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+        ASSERT_EQ(path.empty(), reference.empty()) << pf->GetName();
+        if (path.empty())
+          continue;
+        ASSERT_EQ(map.WorldToTile(path.front()), start);
+        ASSERT_EQ(map.WorldToTile(path.back()), end);
+        ASSERT_TRUE(IsPathContinuous(map, path));
+        ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference))
+            << pf->GetName();
+      }
+    }
+  }
+}
+
+TEST(Bidirectional, ShortAndInvalidQueries) {
+  // Test neighbouring tiles, equal tiles and positions off the map
+  Map map(10, 10);
+  auto pf = pathfinder::utils::create(
+      pathfinder::PathFinderType::BIDIRECTIONAL_ASTAR, &map);
+  ASSERT_EQ(pf->GetName(), "Bidirectional A*");
+  auto path = pf->CalculatePath(map.TileToWorld(TilePos{3, 3}),
+                                map.TileToWorld(TilePos{3, 4}));
+  ASSERT_EQ(path.size(), 2);
+  ASSERT_TRUE(pf->CalculatePath(map.TileToWorld(TilePos{3, 3}),
+                                map.TileToWorld(TilePos{3, 3}))
+                  .empty());
+  ASSERT_TRUE(pf->CalculatePath(map.TileToWorld(TilePos{3, 3}),
+                                map.TileToWorld(TilePos{30, 3}))
+                  .empty());
+}
+
+TEST(ThetaStar, LineOfSight) {
+  // Test the grid line of sight on straight, diagonal and blocked lines
+  Map map(20, 20);
+  const float grass = map.GetCost(TilePos{0, 0});
+  using pathfinder::utils::line_of_sight;
+  ASSERT_TRUE(line_of_sight(map, TilePos{2, 2}, TilePos{2, 15}, grass));
+  ASSERT_TRUE(line_of_sight(map, TilePos{15, 3}, TilePos{1, 12}, grass));
+  ASSERT_TRUE(line_of_sight(map, TilePos{4, 4}, TilePos{4, 4}, grass));
+  ASSERT_FALSE(line_of_sight(map, TilePos{2, 2}, TilePos{2, 25}, grass));
+
+  map.PaintRectangle(TilePos{10, 0}, TilePos{11, 20}, TileType::WATER);
+  ASSERT_FALSE(line_of_sight(map, TilePos{2, 2}, TilePos{15, 7}, grass));
+  ASSERT_TRUE(line_of_sight(map, TilePos{2, 2}, TilePos{9, 17}, grass));
+  // the start tile itself doesn't matter
+  ASSERT_TRUE(line_of_sight(map, TilePos{10, 2}, TilePos{2, 2}, grass));
+
+  // exact diagonal touches the tiles on both sides of every corner
+  Map corner(10, 10);
+  corner.PaintRectangle(TilePos{3, 4}, TilePos{4, 5}, TileType::WALL);
+  ASSERT_FALSE(line_of_sight(corner, TilePos{1, 1}, TilePos{6, 6}, grass));
+}
+
+TEST(ThetaStar, FewerWaypointsNotLonger) {
+  // Test that any-angle paths have fewer waypoints and never cost more than
+  // the grid paths
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::Dijkstra dijkstra(&map);
+  auto theta = pathfinder::utils::create(
+      pathfinder::PathFinderType::THETA_STAR, &map);
+  ASSERT_EQ(theta->GetName(), "Theta*");
+
+  for (const auto &[start, end] : test_queries) {
+    auto reference = dijkstra.CalculatePath(map.TileToWorld(start),
+                                            map.TileToWorld(end));
+    auto path =
+        theta->CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+    ASSERT_FALSE(path.empty());
+    ASSERT_EQ(map.WorldToTile(path.front()), start);
+    ASSERT_EQ(map.WorldToTile(path.back()), end);
+    ASSERT_LE(path.size(), reference.size());
+
+    // every segment is straight over tiles of one cost
+    float cost = 0.0f;
+    for (size_t i = 1; i < path.size(); i++) {
+      const TilePos a = map.WorldToTile(path[i - 1]);
+      const TilePos b = map.WorldToTile(path[i]);
+      const float tile_cost = map.GetCost(b);
+      ASSERT_TRUE(pathfinder::utils::line_of_sight(map, a, b, tile_cost));
+      const auto d = b - a;
+      cost += std::sqrt(static_cast<float>(d.x() * d.x() + d.y() * d.y())) *
+              tile_cost;
+    }
+    ASSERT_LE(cost, PathCost(map, reference) + 1e-3f);
+  }
+
+  // open field: a single straight segment
+  Map open(30, 30);
+  pathfinder::ThetaStar open_theta(&open);
+  auto path = open_theta.CalculatePath(open.TileToWorld(TilePos{2, 3}),
+                                       open.TileToWorld(TilePos{25, 17}));
+  ASSERT_EQ(path.size(), 2);
+}
+
+TEST(Landmarks, AdmissibleLowerBound) {
+  // Test that the landmark bound never exceeds the real cost and that ALT
+  // stays optimal while expanding fewer nodes than plain A*
+  for (unsigned seed = 1; seed <= 4; seed++) {
+    Map map(40, 40);
+    PaintRandomMap(map, seed);
+    auto landmarks = std::make_shared<const pathfinder::Landmarks>(
+        pathfinder::Landmarks::Build(map, 6));
+    ASSERT_EQ(landmarks->GetLandmarks().size(), 6);
+    pathfinder::heuristic::Landmark heuristic;
+    heuristic.map = &map;
+    heuristic.landmarks = landmarks;
+
+    pathfinder::Dijkstra dijkstra(&map);
+    pathfinder::AStar<> astar(&map);
+    pathfinder::AStar<pathfinder::heuristic::Landmark> alt(&map, heuristic);
+    ASSERT_EQ(alt.GetName(), "A* (landmarks)");
+    size_t astar_expanded = 0;
+    size_t alt_expanded = 0;
+    for (const auto &[start, end] : test_queries) {
+      const TilePos from{start.x() % 40, start.y() % 40};
+      const TilePos to{end.x() % 40, end.y() % 40};
+      auto reference =
+          dijkstra.CalculatePath(map.TileToWorld(from), map.TileToWorld(to));
+      if (reference.empty()) { // walled off, no cost to bound
+        ASSERT_TRUE(
+            alt.CalculatePath(map.TileToWorld(from), map.TileToWorld(to))
+                .empty());
+        continue;
+      }
+      const float cost = PathCost(map, reference);
+      ASSERT_LE(landmarks->LowerBound(map, from, to), cost + 1e-3f);
+      ASSERT_LE(heuristic(from, to), cost + 1e-3f);
+
+      auto path = alt.CalculatePath(map.TileToWorld(from), map.TileToWorld(to));
+      ASSERT_TRUE(IsPathContinuous(map, path));
+      ASSERT_NEAR(PathCost(map, path), cost, 1e-3f);
+      astar.CalculatePath(map.TileToWorld(from), map.TileToWorld(to));
+      astar_expanded += astar.GetExpandedNodeCount();
+      alt_expanded += alt.GetExpandedNodeCount();
+    }
+    ASSERT_LT(alt_expanded, astar_expanded);
+
+    // painting the map turns the tables off
+    map.PaintRectangle(TilePos{0, 0}, TilePos{2, 2}, TileType::WALL);
+    ASSERT_FLOAT_EQ(heuristic(TilePos{1, 1}, TilePos{30, 30}),
+                    pathfinder::heuristic::Manhattan{}(TilePos{1, 1},
+                                                       TilePos{30, 30}));
+  }
+}
+
+TEST(Landmarks, RefreshedAfterMapChange) {
+  // Test that ALT built by utils::create gets new tables once the map is
+  // painted and keeps expanding fewer nodes than plain A*
+  Map map(40, 40);
+  PaintRandomMap(map, 1);
+  auto alt = pathfinder::utils::create(pathfinder::PathFinderType::ALT, &map);
+  pathfinder::AStar<> astar(&map);
+  pathfinder::Dijkstra dijkstra(&map);
+  for (unsigned seed = 2; seed <= 4; seed++) {
+    PaintRandomMap(map, seed);
+    size_t astar_expanded = 0;
+    size_t alt_expanded = 0;
+    for (const auto &[start, end] : test_queries) {
+      const WorldPos from = map.TileToWorld({start.x() % 40, start.y() % 40});
+      const WorldPos to = map.TileToWorld({end.x() % 40, end.y() % 40});
+      auto reference = dijkstra.CalculatePath(from, to);
+      auto path = alt->CalculatePath(from, to);
+      ASSERT_NEAR(PathCost(map, path), PathCost(map, reference), 1e-3f);
+      astar.CalculatePath(from, to);
+      astar_expanded += astar.GetExpandedNodeCount();
+      alt_expanded += alt->GetExpandedNodeCount();
+    }
+    ASSERT_LT(alt_expanded, astar_expanded) << "seed " << seed;
+  }
+}
+
+TEST(Landmarks, SaveAndLoad) {
+  // Test that saved tables load with the same bounds and that files of
+  // other maps or other formats are rejected
+  Map map(30, 30);
+  PaintRandomMap(map, 7);
+  const auto path = std::filesystem::temp_directory_path() /
+                    "pathfinder_test_landmarks.bin";
+  const auto built = pathfinder::Landmarks::Build(map, 4);
+  ASSERT_TRUE(built.Save(path).has_value());
+
+  auto loaded = pathfinder::Landmarks::Load(path, map);
+  ASSERT_TRUE(loaded.has_value()) << loaded.error();
+  ASSERT_EQ(loaded->GetLandmarks(), built.GetLandmarks());
+  for (const auto &[start, end] : test_queries) {
+    const TilePos from{start.x() % 30, start.y() % 30};
+    const TilePos to{end.x() % 30, end.y() % 30};
+    ASSERT_EQ(loaded->LowerBound(map, from, to),
+              built.LowerBound(map, from, to));
+  }
+
+  Map other(30, 30);
+  PaintRandomMap(other, 8);
+  ASSERT_FALSE(pathfinder::Landmarks::Load(path, other).has_value());
+  Map smaller(20, 30);
+  ASSERT_FALSE(pathfinder::Landmarks::Load(path, smaller).has_value());
+
+  // a broken count or landmark in the header of the right map is rejected,
+  // the count is at byte 12 and the first landmark at byte 40
+  const auto patch = [&path](std::streamoff offset, int32_t value) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  };
+  for (int32_t count : {0, 0x7fffffff}) {
+    patch(12, count);
+    ASSERT_FALSE(pathfinder::Landmarks::Load(path, map).has_value());
+  }
+  patch(12, 4);
+  ASSERT_TRUE(pathfinder::Landmarks::Load(path, map).has_value());
+  patch(40, 30);
+  ASSERT_FALSE(pathfinder::Landmarks::Load(path, map).has_value());
+
+  std::ofstream(path, std::ios::binary) << "not a landmark file";
+  ASSERT_FALSE(pathfinder::Landmarks::Load(path, map).has_value());
+  // a broken file is replaced by a fresh one
+  auto rebuilt = pathfinder::Landmarks::LoadOrBuild(path, map, 4);
+  ASSERT_EQ(rebuilt.GetLandmarks(), built.GetLandmarks());
+  ASSERT_TRUE(pathfinder::Landmarks::Load(path, map).has_value());
+  std::filesystem::remove(path);
+}
+
+TEST(Landmarks, SharedPerMapVersion) {
+  // Test that every caller of one map version gets the same tables and that
+  // a change or another map gets new ones
+  Map map(30, 30);
+  PaintRandomMap(map, 7);
+  auto shared = pathfinder::Landmarks::Shared(map);
+  ASSERT_EQ(pathfinder::Landmarks::Shared(map), shared);
+  ASSERT_EQ(shared->GetMapVersion(), map.GetVersion());
+  ASSERT_NE(pathfinder::Landmarks::Shared(map, 4), shared);
+
+  Map other(30, 30);
+  PaintRandomMap(other, 8);
+  ASSERT_NE(pathfinder::Landmarks::Shared(other), shared);
+
+  map.PaintRectangle(TilePos{2, 3}, TilePos{5, 8}, TileType::WALL);
+  auto changed = pathfinder::Landmarks::Shared(map);
+  ASSERT_NE(changed, shared);
+  ASSERT_EQ(changed->GetMapVersion(), map.GetVersion());
+}
+
+TEST(BoundedAStar, CreatedByUtils) {
+  // Test that both bounded searches can be created through the factory and
+  // that weights below 1 are not accepted
+  Map map(10, 10);
+  auto weighted = pathfinder::utils::create(
+      pathfinder::PathFinderType::WEIGHTED_ASTAR, &map);
+  auto focal =
+      pathfinder::utils::create(pathfinder::PathFinderType::FOCAL_ASTAR, &map);
+  ASSERT_NE(weighted, nullptr);
+  ASSERT_NE(focal, nullptr);
+  ASSERT_EQ(weighted->GetName(), "Weighted A*");
+  ASSERT_EQ(focal->GetName(), "Focal A*");
+
+  pathfinder::FocalAStar focal_astar(&map, 0.5f);
+  ASSERT_FLOAT_EQ(focal_astar.GetWeight(), 1.0f);
+  focal_astar.SetWeight(2.5f);
+  ASSERT_FLOAT_EQ(focal_astar.GetWeight(), 2.5f);
+}
+
+TEST(BoundedAStar, WithinWeightOfOptimal) {
+  // Test that the paths cost at most weight times the optimum, that weight 1
+  // is optimal and that the reported suboptimality is between the real one
+  // and the weight
+  for (unsigned seed = 1; seed <= 4; seed++) {
+    for (auto connectivity : {Connectivity::FOUR, Connectivity::EIGHT}) {
+      Map map(50, 50);
+      PaintTestMap(map);
+      PaintRandomMap(map, seed);
+      map.SetConnectivity(connectivity);
+      pathfinder::Dijkstra dijkstra(&map);
+      pathfinder::WeightedAStar weighted(&map);
+      pathfinder::FocalAStar focal(&map);
+
+      for (float weight : {1.0f, 1.2f, 2.0f, 5.0f}) {
+        weighted.SetWeight(weight);
+        focal.SetWeight(weight);
+        for (const auto &[start, end] : test_queries) {
+          const auto from = map.TileToWorld(start);
+          const auto to = map.TileToWorld(end);
+          auto reference = dijkstra.CalculatePath(from, to);
+          for (pathfinder::BoundedAStarBase *pf :
+               std::initializer_list<pathfinder::BoundedAStarBase *>{
+                   &weighted, &focal}) {
+            auto path = pf->CalculatePath(from, to);
+            if (reference.empty()) {
+              ASSERT_TRUE(path.empty()) << pf->GetName();
+              continue;
+            }
+            const float optimal = PathCost(map, reference);
+            const float cost = PathCost(map, path);
+            ASSERT_EQ(map.WorldToTile(path.front()), start) << pf->GetName();
+            ASSERT_EQ(map.WorldToTile(path.back()), end) << pf->GetName();
+            ASSERT_TRUE(IsPathContinuous(map, path)) << pf->GetName();
+            ASSERT_LE(cost, optimal * weight + 1e-2f) << pf->GetName();
+            if (weight == 1.0f) {
+              ASSERT_NEAR(cost, optimal, 1e-2f) << pf->GetName();
+            }
+            const float suboptimality = pf->GetSuboptimality();
+            ASSERT_GE(suboptimality, 1.0f) << pf->GetName();
+            ASSERT_LE(suboptimality, weight + 1e-4f) << pf->GetName();
+            ASSERT_GE(suboptimality, cost / optimal - 1e-4f) << pf->GetName();
+            ASSERT_EQ(pf->GetLastStats().suboptimality, suboptimality)
+                << pf->GetName();
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Connectivity, EightConnectedPathfinders) {
+  // Test that every pathfinder moves diagonally on 8-connected maps, never
+  // past wall corners, and that the optimal ones agree with Dijkstra
+  Map map(50, 50);
+  PaintTestMap(map);
+  map.SetConnectivity(Connectivity::EIGHT);
+  pathfinder::Dijkstra dijkstra(&map);
+  std::vector<std::unique_ptr<pathfinder::PathFinderBase>> optimal;
+  for (auto type :
+       {pathfinder::PathFinderType::DIJKSTRA, pathfinder::PathFinderType::ASTAR,
+        pathfinder::PathFinderType::JPS,
+        pathfinder::PathFinderType::DSTAR_LITE,
+        pathfinder::PathFinderType::BIDIRECTIONAL_DIJKSTRA,
+        pathfinder::PathFinderType::BIDIRECTIONAL_ASTAR,
+        pathfinder::PathFinderType::ALT}) {
+    optimal.push_back(pathfinder::utils::create(type, &map));
+  }
+  auto hpa = pathfinder::utils::create(pathfinder::PathFinderType::HPA, &map);
+  auto bfs = pathfinder::utils::create(pathfinder::PathFinderType::BFS, &map);
+  auto gbfs = pathfinder::utils::create(pathfinder::PathFinderType::GBFS, &map);
+
+  for (const auto &[start, end] : test_queries) {
+    const auto from = map.TileToWorld(start);
+    const auto to = map.TileToWorld(end);
+    auto reference = dijkstra.CalculatePath(from, to);
+    ASSERT_TRUE(IsPathContinuous(map, reference));
+    const float cost = PathCost(map, reference);
+    for (auto &pf : optimal) {
+      auto path = pf->CalculatePath(from, to);
+      ASSERT_EQ(map.WorldToTile(path.front()), start) << pf->GetName();
+      ASSERT_EQ(map.WorldToTile(path.back()), end) << pf->GetName();
+      ASSERT_TRUE(IsPathContinuous(map, path)) << pf->GetName();
+      ASSERT_NEAR(PathCost(map, path), cost, 1e-2f) << pf->GetName();
+    }
+    auto hpa_path = hpa->CalculatePath(from, to);
+    ASSERT_TRUE(IsPathContinuous(map, hpa_path));
+    ASSERT_LE(PathCost(map, hpa_path), cost * 1.2f);
+    for (auto *pf : {bfs.get(), gbfs.get()}) {
+      auto path = pf->CalculatePath(from, to);
+      ASSERT_EQ(map.WorldToTile(path.back()), end) << pf->GetName();
+      ASSERT_TRUE(IsPathContinuous(map, path)) << pf->GetName();
+    }
+
+    pathfinder::FlowField field(&map, end);
+    ASSERT_NEAR(field.GetCost(start), cost, 1e-2f);
+    ASSERT_TRUE(IsPathContinuous(map, field.GetPath(from)));
+  }
+}
+
+TEST(Connectivity, DiagonalsShortenPaths) {
+  // Test that diagonal moves make open field paths shorter and that cached
+  // searches notice when the connectivity changes
+  Map map(40, 40);
+  pathfinder::DStarLite dstar(&map);
+  const auto from = map.TileToWorld(TilePos{2, 2});
+  const auto to = map.TileToWorld(TilePos{32, 32});
+  const float straight = PathCost(map, dstar.CalculatePath(from, to));
+  ASSERT_FLOAT_EQ(straight, 60.0f);
+
+  map.SetConnectivity(Connectivity::EIGHT);
+  auto path = dstar.CalculatePath(from, to);
+  ASSERT_TRUE(IsPathContinuous(map, path));
+  ASSERT_NEAR(PathCost(map, path), 30.0f * std::numbers::sqrt2_v<float>,
+              1e-3f);
+
+  // a wall across the diagonal has to be walked around, not cut through
+  map.PaintRectangle(TilePos{10, 0}, TilePos{11, 30}, TileType::WALL);
+  map.PaintRectangle(TilePos{0, 10}, TilePos{30, 11}, TileType::WALL);
+  pathfinder::Dijkstra dijkstra(&map);
+  path = dstar.CalculatePath(from, to);
+  ASSERT_TRUE(IsPathContinuous(map, path));
+  ASSERT_NEAR(PathCost(map, path),
+              PathCost(map, dijkstra.CalculatePath(from, to)), 1e-2f);
+}
+
+TEST(Components, UnreachableGoalRejected) {
+  // Test that every pathfinder gives up on a walled off goal without
+  // expanding a single node, 4- and 8-connected
+  Map map(40, 40);
+  map.PaintRectangle(TilePos{19, 19}, TilePos{20, 32}, TileType::WALL);
+  map.PaintRectangle(TilePos{31, 19}, TilePos{32, 32}, TileType::WALL);
+  map.PaintRectangle(TilePos{19, 19}, TilePos{32, 20}, TileType::WALL);
+  map.PaintRectangle(TilePos{19, 31}, TilePos{32, 32}, TileType::WALL);
+  const TilePos start{2, 2}, inside{25, 25}, wall{19, 25};
+  ASSERT_FALSE(map.IsReachable(start, inside));
+
+  for (auto connectivity : {Connectivity::FOUR, Connectivity::EIGHT}) {
+    map.SetConnectivity(connectivity);
+    for (int t = static_cast<int>(pathfinder::PathFinderType::BFS);
+         t < static_cast<int>(pathfinder::PathFinderType::COUNT); t++) {
+      auto pf = pathfinder::utils::create(
+          static_cast<pathfinder::PathFinderType>(t), &map);
+      ASSERT_TRUE(
+          pf->CalculatePath(map.TileToWorld(start), map.TileToWorld(inside))
+              .empty())
+          << pf->GetName();
+      ASSERT_TRUE(
+          pf->CalculatePath(map.TileToWorld(inside), map.TileToWorld(start))
+              .empty())
+          << pf->GetName();
+      ASSERT_TRUE(
+          pf->CalculatePath(map.TileToWorld(start), map.TileToWorld(wall))
+              .empty())
+          << pf->GetName();
+      ASSERT_EQ(pf->GetExpandedNodeCount(), 0) << pf->GetName();
+
+      // reachable goals still work and never enter the wall
+      auto path =
+          pf->CalculatePath(map.TileToWorld(start), map.TileToWorld({5, 35}));
+      if (static_cast<pathfinder::PathFinderType>(t) !=
+          pathfinder::PathFinderType::THETA_STAR) {
+        ASSERT_TRUE(IsPathContinuous(map, path)) << pf->GetName();
+      }
+      ASSERT_FALSE(path.empty()) << pf->GetName();
+    }
+  }
+}
+
+TEST(MovingAI, LoadMapAndScenarios) {
+  // Test that a MovingAI map loads as an 8-connected map with walls for the
+  // blocked tiles and that the scenario positions are converted to
+  // (row, column)
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto map_path = dir / "pathfinder_test.map";
+  const auto scen_path = dir / "pathfinder_test.map.scen";
+  std::ofstream(map_path) << "type octile\nheight 4\nwidth 6\nmap\n"
+                             "......\n"
+                             ".@@T..\n"
+                             ".@S...\n"
+                             "......\n";
+  std::ofstream(scen_path) << "version 1\n"
+                              "0\ttest.map\t6\t4\t0\t0\t4\t2\t6.00000000\n"
+                              "1\ttest.map\t6\t4\t0\t3\t5\t0\t6.82842712\n";
+
+  auto map = movingai::LoadMap(map_path);
+  ASSERT_TRUE(map.has_value()) << map.error();
+  ASSERT_EQ((*map)->GetRows(), 4);
+  ASSERT_EQ((*map)->GetCols(), 6);
+  ASSERT_EQ((*map)->GetConnectivity(), Connectivity::EIGHT);
+  ASSERT_FALSE((*map)->IsPassable(TilePos{1, 1}));
+  ASSERT_FALSE((*map)->IsPassable(TilePos{1, 3}));
+  ASSERT_TRUE((*map)->IsPassable(TilePos{2, 2}));
+  ASSERT_TRUE((*map)->IsReachable(TilePos{0, 0}, TilePos{2, 2}));
+
+  auto scenarios = movingai::LoadScenarios(scen_path, **map);
+  ASSERT_TRUE(scenarios.has_value()) << scenarios.error();
+  ASSERT_EQ(scenarios->size(), 2);
+  ASSERT_EQ((*scenarios)[0].bucket, 0);
+  ASSERT_EQ((*scenarios)[0].start, (TilePos{0, 0}));
+  ASSERT_EQ((*scenarios)[0].goal, (TilePos{2, 4}));
+  ASSERT_EQ((*scenarios)[1].start, (TilePos{3, 0}));
+  ASSERT_EQ((*scenarios)[1].goal, (TilePos{0, 5}));
+  auto astar = pathfinder::utils::create(pathfinder::PathFinderType::ASTAR,
+                                         map->get());
+  for (const auto &scenario : *scenarios) {
+    auto path = astar->CalculatePath((*map)->TileToWorld(scenario.start),
+                                     (*map)->TileToWorld(scenario.goal));
+    ASSERT_NEAR(PathCost(**map, path), scenario.optimal_cost, 1e-4);
+  }
+  std::filesystem::remove(map_path);
+  std::filesystem::remove(scen_path);
+}
+
+TEST(MovingAI, RejectsMalformedFiles) {
+  // Test that broken maps and scenarios that don't fit the map are reported
+  const auto path =
+      std::filesystem::temp_directory_path() / "pathfinder_test_broken.map";
+  ASSERT_FALSE(movingai::LoadMap(path).has_value());
+  std::ofstream(path) << "type tile\nheight 1\nwidth 2\nmap\n..\n";
+  ASSERT_FALSE(movingai::LoadMap(path).has_value());
+  std::ofstream(path) << "type octile\nheight 2\nwidth 2\nmap\n..\n";
+  ASSERT_FALSE(movingai::LoadMap(path).has_value());
+  std::ofstream(path) << "type octile\nheight 2\nwidth 2\nmap\n..\n...\n";
+  ASSERT_FALSE(movingai::LoadMap(path).has_value());
+
+  // windows line endings are fine
+  std::ofstream(path) << "type octile\r\nheight 2\r\nwidth 2\r\nmap\r\n"
+                         "..\r\n.T\r\n";
+  auto map = movingai::LoadMap(path);
+  ASSERT_TRUE(map.has_value()) << map.error();
+  ASSERT_FALSE((*map)->IsPassable(TilePos{1, 1}));
+
+  std::ofstream(path) << "0\tx.map\t2\t2\t0\t0\t1\t0\t1\n";
+  ASSERT_FALSE(movingai::LoadScenarios(path, **map).has_value());
+  std::ofstream(path) << "version 1\n0\tx.map\t3\t2\t0\t0\t1\t0\t1\n";
+  ASSERT_FALSE(movingai::LoadScenarios(path, **map).has_value());
+  std::ofstream(path) << "version 1\n0\tx.map\t2\t2\t0\t0\t2\t0\t1\n";
+  ASSERT_FALSE(movingai::LoadScenarios(path, **map).has_value());
+  std::ofstream(path) << "version 1\n0\tx.map\t2\t2\t0\t0\n";
+  ASSERT_FALSE(movingai::LoadScenarios(path, **map).has_value());
+  std::filesystem::remove(path);
+}
+
+TEST(Map, PaintTiles) {
+  // Test that painting the whole map at once keeps the components right and
+  // counts as a single change
+  Map map(3, 4);
+  const uint64_t version = map.GetVersion();
+  const auto G = TileType::GRASS, W = TileType::WALL;
+  map.PaintTiles({G, G, W, G, //
+                  W, W, W, G, //
+                  G, W, G, G});
+  ASSERT_EQ(map.GetVersion(), version + 1);
+  ASSERT_EQ(map.GetChangesSince(version).size(), 1);
+  ASSERT_TRUE(map.IsReachable(TilePos{0, 3}, TilePos{2, 2}));
+  ASSERT_FALSE(map.IsReachable(TilePos{0, 0}, TilePos{2, 0}));
+  ASSERT_FALSE(map.IsReachable(TilePos{0, 0}, TilePos{0, 3}));
+  ASSERT_EQ(map.GetComponent(TilePos{1, 1}), Map::kNoComponent);
+
+  map.PaintTiles(std::vector<TileType>(12, TileType::WATER));
+  ASSERT_TRUE(map.IsReachable(TilePos{0, 0}, TilePos{2, 0}));
+  ASSERT_FLOAT_EQ(map.GetCost(TilePos{1, 1}), 10.0f);
+}
+
+TEST(Cooperative, ReservationTable) {
+  // Test that cells, moves and held tiles are reported as reserved
+  pathfinder::ReservationTable table;
+  table.Reserve(5, 2);
+  table.ReserveMove(5, 6, 2);
+  table.Hold(9, 4);
+  ASSERT_TRUE(table.IsReserved(5, 2));
+  ASSERT_FALSE(table.IsReserved(5, 3));
+  ASSERT_TRUE(table.IsMoveReserved(5, 6, 2));
+  ASSERT_FALSE(table.IsMoveReserved(6, 5, 2));
+  ASSERT_FALSE(table.IsReserved(9, 3));
+  ASSERT_TRUE(table.IsReserved(9, 4));
+  ASSERT_TRUE(table.IsReserved(9, 1000));
+  ASSERT_TRUE(table.IsReservedAfter(5, 1));
+  ASSERT_FALSE(table.IsReservedAfter(5, 2));
+  ASSERT_TRUE(table.IsReservedAfter(9, 0));
+  table.Clear();
+  ASSERT_FALSE(table.IsReserved(9, 4));
+  ASSERT_EQ(table.GetSize(), 0);
+
+  // only the window of the path is reserved, a path ending in it holds its
+  // last tile
+  Map map(5, 5);
+  const pathfinder::SpaceTimePath path = {TilePos{0, 0}, TilePos{0, 1},
+                                          TilePos{0, 1}, TilePos{1, 1}};
+  table.ReservePath(map, path, 10, 2);
+  ASSERT_TRUE(table.IsReserved(map.TileToIndex(TilePos{0, 1}), 12));
+  ASSERT_TRUE(table.IsMoveReserved(map.TileToIndex(TilePos{0, 0}),
+                                   map.TileToIndex(TilePos{0, 1}), 10));
+  ASSERT_FALSE(table.IsReserved(map.TileToIndex(TilePos{1, 1}), 13));
+  table.ReservePath(map, path, 20, 3);
+  ASSERT_TRUE(table.IsReserved(map.TileToIndex(TilePos{1, 1}), 50));
+}
+
+TEST(Cooperative, SpaceTimeSearchAvoidsReservations) {
+  // Test that the search gets around a reserved cell and never swaps
+  // places with an agent coming the other way
+  Map map(5, 8);
+  pathfinder::SpaceTimeAStar search(&map);
+  pathfinder::ReservationTable table;
+  const TilePos start{2, 0}, goal{2, 7};
+
+  auto alone = search.FindPath(start, goal, table, 32);
+  ASSERT_EQ(alone.size(), 8);
+  ASSERT_EQ(alone[3], (TilePos{2, 3}));
+
+  table.Reserve(map.TileToIndex(TilePos{2, 3}), 3);
+  auto around = search.FindPath(start, goal, table, 32);
+  ASSERT_EQ(around.front(), start);
+  ASSERT_EQ(around.back(), goal);
+  ASSERT_NE(around[3], (TilePos{2, 3}));
+  ASSERT_GT(search.GetExpandedNodeCount(), 0);
+
+  // an agent walking the same row the other way
+  table.Clear();
+  pathfinder::SpaceTimePath other;
+  for (int col = 7; col >= 0; col--)
+    other.push_back(TilePos{2, col});
+  table.ReservePath(map, other, 0, 32);
+  auto path = search.FindPath(start, goal, table, 32);
+  ASSERT_EQ(path.back(), goal);
+  ASSERT_EQ(CountConflicts({path, other}, 40), 0);
+  for (size_t i = 1; i < path.size(); i++) {
+    const TilePos diff = path[i] - path[i - 1];
+    ASSERT_LE(std::abs(diff.x()) + std::abs(diff.y()), 1);
+  }
+
+  // the goal is held by someone else, the path ends at the window
+  table.Clear();
+  table.Hold(map.TileToIndex(goal), 0);
+  auto blocked = search.FindPath(start, goal, table, 4);
+  ASSERT_EQ(blocked.size(), 5 + 3);
+  ASSERT_EQ(blocked[4], (TilePos{2, 4}));
+}
+
+TEST(Cooperative, SingleAgentIsOptimal) {
+  // Test that an agent planned alone takes a path as cheap as Dijkstra's
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::CooperativePlanner planner(&map, 200);
+  pathfinder::Dijkstra dijkstra(&map);
+  for (const auto &[start, end] : test_queries) {
+    const std::vector<pathfinder::AgentQuery> agents = {{start, end}};
+    auto paths = planner.Plan(agents);
+    ASSERT_EQ(paths.size(), 1);
+    pathfinder::Path path;
+    for (TilePos tile : paths[0])
+      path.push_back(map.TileToWorld(tile));
+    auto reference =
+        dijkstra.CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+    ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference));
+    ASSERT_TRUE(IsPathContinuous(map, path));
+  }
+}
+
+TEST(Cooperative, ObstaclesAreAvoided) {
+  // Test that agents walk around the tiles of units that are not planned
+  Map map(10, 10);
+  pathfinder::CooperativePlanner planner(&map, 32);
+  const std::vector<pathfinder::AgentQuery> agents = {{{0, 5}, {9, 5}},
+                                                      {{5, 0}, {5, 9}}};
+  const std::vector<TilePos> obstacles = {{5, 5}, {4, 5}};
+  auto paths = planner.Plan(agents, obstacles);
+  for (size_t i = 0; i < agents.size(); i++) {
+    ASSERT_EQ(paths[i].back(), agents[i].goal);
+    for (TilePos obstacle : obstacles)
+      ASSERT_EQ(std::ranges::count(paths[i], obstacle), 0) << obstacle;
+  }
+  ASSERT_EQ(CountConflicts(paths, 32), 0);
+}
+
+TEST(Cooperative, CrowdWithoutConflictsInWindow) {
+  // Test that a crowd crossing each other has no conflicts inside the
+  // window and that everybody gets a path to the goal
+  Map map(30, 30);
+  PaintRandomMap(map, 9);
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<int> coord(0, 29);
+  std::set<size_t> starts, goals;
+  std::vector<pathfinder::AgentQuery> agents;
+  while (agents.size() < 25) {
+    const TilePos start{coord(gen), coord(gen)}, goal{coord(gen), coord(gen)};
+    if (!map.IsReachable(start, goal) ||
+        starts.contains(map.TileToIndex(start)) ||
+        goals.contains(map.TileToIndex(goal)))
+      continue;
+    starts.insert(map.TileToIndex(start));
+    goals.insert(map.TileToIndex(goal));
+    agents.push_back({start, goal});
+  }
+
+  for (uint32_t window : {8u, 16u, 64u}) {
+    pathfinder::CooperativePlanner planner(&map, window);
+    auto paths = planner.Plan(agents);
+    ASSERT_EQ(paths.size(), agents.size());
+    for (size_t i = 0; i < agents.size(); i++) {
+      ASSERT_EQ(paths[i].front(), agents[i].start);
+      ASSERT_EQ(paths[i].back(), agents[i].goal);
+    }
+    ASSERT_EQ(CountConflicts(paths, window), 0) << "window " << window;
+    ASSERT_GT(planner.GetExpandedNodeCount(), 0);
+    ASSERT_GT(planner.GetReservations().GetSize(), 0);
+  }
+}
+
+TEST(Cooperative, GoalsAround) {
+  // Test that a group order gets distinct passable goals around the target
+  Map map(20, 20);
+  map.PaintRectangle(TilePos{0, 5}, TilePos{20, 6}, TileType::WALL);
+  auto goals = pathfinder::GoalsAround(map, TilePos{10, 3}, 30);
+  ASSERT_EQ(goals.size(), 30);
+  ASSERT_EQ(goals.front(), (TilePos{10, 3}));
+  std::set<size_t> unique;
+  for (TilePos goal : goals) {
+    ASSERT_TRUE(unique.insert(map.TileToIndex(goal)).second);
+    ASSERT_TRUE(map.IsReachable(goal, TilePos{10, 3}));
+    ASSERT_LE(std::abs(goal.x() - 10) + std::abs(goal.y() - 3), 5);
+  }
+  // the component left of the wall has only 100 tiles
+  ASSERT_EQ(pathfinder::GoalsAround(map, TilePos{10, 3}, 500).size(), 100);
+  ASSERT_TRUE(pathfinder::GoalsAround(map, TilePos{10, 5}, 5).empty());
+}
+
+TEST(CBS, CorridorSwapIsOptimal) {
+  // Test that two agents swapping ends of a corridor with one bay get the
+  // cheapest plan: one of them steps into the bay and back, 2 extra moves
+  Map map(3, 7);
+  map.PaintRectangle(TilePos{0, 0}, TilePos{0, 6}, TileType::WALL);
+  map.PaintRectangle(TilePos{2, 0}, TilePos{2, 6}, TileType::WALL);
+  map.PaintRectangle(TilePos{0, 3}, TilePos{0, 3}, TileType::GRASS);
+  const std::vector<pathfinder::AgentQuery> agents = {{{1, 0}, {1, 6}},
+                                                      {{1, 6}, {1, 0}}};
+  pathfinder::ConflictBasedSearch cbs(&map);
+  auto result = cbs.Solve(agents);
+  ASSERT_EQ(result.status, pathfinder::ConflictBasedSearch::Status::SOLVED);
+  ASSERT_EQ(result.conflicts, 0);
+  ASSERT_FLOAT_EQ(result.cost, 6.0f + 8.0f);
+  ASSERT_EQ(CountConflicts(result.paths, 20), 0);
+  ASSERT_EQ(pathfinder::CountConflicts(result.paths), 0);
+  ASSERT_GT(cbs.GetNodeCount(), 1);
+  ASSERT_GT(cbs.GetExpandedNodeCount(), 0);
+
+  // the plan alone swaps through each other
+  pathfinder::ConflictBasedSearch root_only(
+      &map, pathfinder::ConflictBasedSearch::Limits{1, 1000.0});
+  result = root_only.Solve(agents);
+  ASSERT_EQ(result.status,
+            pathfinder::ConflictBasedSearch::Status::NODE_LIMIT);
+  ASSERT_EQ(result.paths.size(), 2);
+  ASSERT_GT(result.conflicts, 0);
+  ASSERT_FLOAT_EQ(result.cost, 12.0f);
+  root_only.SetLimits({10000, 0.0});
+  ASSERT_EQ(root_only.Solve(agents).status,
+            pathfinder::ConflictBasedSearch::Status::TIME_LIMIT);
+}
+
+TEST(CBS, TimeLimitStopsLowLevelSearch) {
+  // Test that a space-time search past its deadline gives up, and that CBS
+  // reports the time limit when its root searches run out of time
+  Map map(200, 200);
+  const std::vector<pathfinder::AgentQuery> agents = {{{0, 0}, {199, 199}},
+                                                      {{199, 0}, {0, 199}}};
+  pathfinder::SpaceTimeAStar search(&map);
+  const pathfinder::ReservationTable none;
+  ASSERT_FALSE(search.FindPath({0, 0}, {199, 199}, none, 1000).empty());
+  ASSERT_FALSE(search.HasTimedOut());
+  search.SetDeadline(std::chrono::steady_clock::now());
+  ASSERT_TRUE(search.FindPath({0, 0}, {199, 199}, none, 1000).empty());
+  ASSERT_TRUE(search.HasTimedOut());
+
+  pathfinder::ConflictBasedSearch cbs(
+      &map, pathfinder::ConflictBasedSearch::Limits{10000, 0.0});
+  auto result = cbs.Solve(agents);
+  ASSERT_EQ(result.status,
+            pathfinder::ConflictBasedSearch::Status::TIME_LIMIT);
+  ASSERT_TRUE(result.paths.empty());
+  cbs.SetLimits({10000, 1000.0});
+  ASSERT_EQ(cbs.Solve(agents).status,
+            pathfinder::ConflictBasedSearch::Status::SOLVED);
+}
+
+TEST(CBS, NoSolution) {
+  // Test that shared goals, shared starts and unreachable goals fail fast
+  Map map(20, 20);
+  map.PaintRectangle(TilePos{0, 5}, TilePos{20, 6}, TileType::WALL);
+  pathfinder::ConflictBasedSearch cbs(&map);
+  const std::vector<std::vector<pathfinder::AgentQuery>> cases = {
+      {{{1, 1}, {3, 3}}, {{2, 2}, {3, 3}}},
+      {{{1, 1}, {3, 3}}, {{1, 1}, {4, 4}}},
+      {{{1, 1}, {3, 3}}, {{2, 2}, {10, 10}}},
+  };
+  for (const auto &agents : cases) {
+    auto result = cbs.Solve(agents);
+    ASSERT_EQ(result.status,
+              pathfinder::ConflictBasedSearch::Status::NO_SOLUTION);
+    ASSERT_TRUE(result.paths.empty());
+  }
+}
+
+TEST(CBS, CrowdWithoutConflicts) {
+  // Test that a small crowd gets a plan without any conflict, every agent
+  // moving one tile at a time from its start to its goal
+  Map map(20, 20);
+  PaintRandomMap(map, 4);
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<int> coord(0, 19);
+  std::set<size_t> starts, goals;
+  std::vector<pathfinder::AgentQuery> agents;
+  while (agents.size() < 8) {
+    const TilePos start{coord(gen), coord(gen)}, goal{coord(gen), coord(gen)};
+    if (!map.IsReachable(start, goal) ||
+        starts.contains(map.TileToIndex(start)) ||
+        goals.contains(map.TileToIndex(goal)))
+      continue;
+    starts.insert(map.TileToIndex(start));
+    goals.insert(map.TileToIndex(goal));
+    agents.push_back({start, goal});
+  }
+
+  pathfinder::ConflictBasedSearch cbs(&map);
+  auto result = cbs.Solve(agents);
+  ASSERT_EQ(result.status, pathfinder::ConflictBasedSearch::Status::SOLVED);
+  size_t ticks = 0;
+  for (size_t i = 0; i < agents.size(); i++) {
+    const auto &path = result.paths[i];
+    ASSERT_EQ(path.front(), agents[i].start);
+    ASSERT_EQ(path.back(), agents[i].goal);
+    for (size_t j = 1; j < path.size(); j++) {
+      const TilePos diff = path[j] - path[j - 1];
+      ASSERT_LE(std::abs(diff.x()) + std::abs(diff.y()), 1);
+    }
+    ticks = std::max(ticks, path.size());
+  }
+  ASSERT_EQ(CountConflicts(result.paths, ticks), 0);
+
+  // never cheaper than every agent planned alone
+  pathfinder::Dijkstra dijkstra(&map);
+  float alone = 0.0f;
+  for (const auto &agent : agents) {
+    alone += PathCost(map, dijkstra.CalculatePath(map.TileToWorld(agent.start),
+                                                  map.TileToWorld(agent.goal)));
+  }
+  ASSERT_GE(result.cost, alone - 1e-3f);
+}
+
+TEST(JPS, SameCostAsDijkstra) {
+  // Test that jump point search stays optimal on weighted maps
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::Dijkstra dijkstra(&map);
+  pathfinder::JPS jps(&map);
+  for (const auto &[start, end] : test_queries) {
+    auto reference = dijkstra.CalculatePath(map.TileToWorld(start),
+                                            map.TileToWorld(end));
+    auto path = jps.CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+    ASSERT_FALSE(path.empty());
+    ASSERT_EQ(map.WorldToTile(path.front()), start);
+    ASSERT_EQ(map.WorldToTile(path.back()), end);
+    ASSERT_TRUE(IsPathContinuous(map, path));
+    ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference));
+  }
+}
+
+TEST(JPS, RandomMaps) {
+  // Test optimality on many random maps and queries
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<int> dist(0, 39);
+  for (unsigned seed = 0; seed < 20; seed++) {
+    Map map(40, 40);
+    PaintRandomMap(map, seed);
+    pathfinder::Dijkstra dijkstra(&map);
+    pathfinder::JPS jps(&map);
+    for (int i = 0; i < 20; i++) {
+      const TilePos start{dist(gen), dist(gen)};
+      const TilePos end{dist(gen), dist(gen)};
+      auto reference = dijkstra.CalculatePath(map.TileToWorld(start),
+                                              map.TileToWorld(end));
+      auto path =
+          jps.CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+      ASSERT_EQ(path.empty(), reference.empty());
+      ASSERT_TRUE(IsPathContinuous(map, path));
+      ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference))
+          << "seed " << seed << " from " << start << " to " << end;
+    }
+  }
+}
+
+TEST(JPS, UniformMapExpandsFewNodes) {
+  // Test that nothing is forced on a uniform map
+  Map map(60, 60);
+  pathfinder::Dijkstra dijkstra(&map);
+  pathfinder::JPS jps(&map);
+  const auto start = map.TileToWorld(TilePos{5, 5});
+  const auto end = map.TileToWorld(TilePos{55, 50});
+  auto reference = dijkstra.CalculatePath(start, end);
+  auto path = jps.CalculatePath(start, end);
+  ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference));
+  ASSERT_LT(jps.GetExpandedNodeCount(), dijkstra.GetExpandedNodeCount() / 10);
+}
+
+TEST(JPS, FollowsMapChanges) {
+  // Test that precomputed runs are rebuilt after painting
+  Map map(40, 40);
+  pathfinder::Dijkstra dijkstra(&map);
+  pathfinder::JPS jps(&map);
+  const auto start = map.TileToWorld(TilePos{5, 5});
+  const auto end = map.TileToWorld(TilePos{35, 30});
+  jps.CalculatePath(start, end);
+  map.PaintLine(TilePos{20, 0}, TilePos{20, 35}, 2.0, TileType::WATER);
+  map.PaintLine(TilePos{0, 20}, TilePos{15, 20}, 1.0, TileType::ROAD);
+  ASSERT_FLOAT_EQ(PathCost(map, jps.CalculatePath(start, end)),
+                  PathCost(map, dijkstra.CalculatePath(start, end)));
+}
+
+TEST(HPA, CreatedByUtils) {
+  // Test that HPA* can be created through the factory
+  Map map(10, 10);
+  auto pf = pathfinder::utils::create(pathfinder::PathFinderType::HPA, &map);
+  ASSERT_NE(pf, nullptr);
+  ASSERT_EQ(pf->GetName(), "HPA*");
+}
+
+TEST(HPA, NearOptimalPaths) {
+  // Test that hierarchical paths are valid and not much worse than optimal
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::Dijkstra dijkstra(&map);
+  pathfinder::HPAStar hpa(&map);
+  for (const auto &[start, end] : test_queries) {
+    auto reference = dijkstra.CalculatePath(map.TileToWorld(start),
+                                            map.TileToWorld(end));
+    auto path = hpa.CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+    ASSERT_FALSE(path.empty());
+    ASSERT_EQ(map.WorldToTile(path.front()), start);
+    ASSERT_EQ(map.WorldToTile(path.back()), end);
+    ASSERT_TRUE(IsPathContinuous(map, path));
+    ASSERT_GE(PathCost(map, path), PathCost(map, reference) - 1e-3f);
+    ASSERT_LE(PathCost(map, path), PathCost(map, reference) * 1.2f);
+  }
+}
+
+TEST(HPA, RefinedSegmentsMatchFullPath) {
+  // Test that refining the waypoints one by one gives the full path
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::HPAStar hpa(&map);
+  const auto start = map.TileToWorld(TilePos{1, 1});
+  const auto end = map.TileToWorld(TilePos{48, 48});
+  auto waypoints = hpa.CalculateAbstractPath(start, end);
+  ASSERT_GT(waypoints.size(), 1);
+  ASSERT_EQ(waypoints.back(), end);
+
+  pathfinder::Path refined{start};
+  for (const auto &waypoint : waypoints) {
+    auto segment = hpa.RefineSegment(refined.back(), waypoint);
+    ASSERT_FALSE(segment.empty());
+    ASSERT_EQ(segment.front(), refined.back());
+    refined.insert(refined.end(), std::next(segment.begin()), segment.end());
+  }
+  auto path = hpa.CalculatePath(start, end);
+  ASSERT_TRUE(IsPathContinuous(map, refined));
+  ASSERT_FLOAT_EQ(PathCost(map, refined), PathCost(map, path));
+}
+
+TEST(HPA, RefiningDoesNotBuildAbstractGraph) {
+  // Test that refining searches only the clusters of the segment, without
+  // building the abstract graph, and is empty once the way leaves them
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::HPAStar hpa(&map);
+  auto segment = hpa.RefineSegment(map.TileToWorld(TilePos{1, 1}),
+                                   map.TileToWorld(TilePos{12, 12}));
+  ASSERT_FALSE(segment.empty());
+  ASSERT_TRUE(IsPathContinuous(map, segment));
+  ASSERT_EQ(hpa.GetAbstractNodeCount(), 0);
+
+  // wall across the neighbouring clusters, the way around leaves them
+  map.PaintLine(TilePos{0, 15}, TilePos{40, 15}, 1.0, TileType::WALL);
+  segment = hpa.RefineSegment(map.TileToWorld(TilePos{5, 12}),
+                              map.TileToWorld(TilePos{5, 18}));
+  ASSERT_TRUE(segment.empty());
+  ASSERT_EQ(hpa.GetAbstractNodeCount(), 0);
+  auto path = hpa.CalculatePath(map.TileToWorld(TilePos{5, 12}),
+                                map.TileToWorld(TilePos{5, 18}));
+  ASSERT_FALSE(path.empty());
+  ASSERT_GT(hpa.GetAbstractNodeCount(), 0);
+}
+
+TEST(HPA, RebuildsOnlyChangedClusters) {
+  // Test that painting rebuilds the touched clusters only
+  Map map(60, 60);
+  PaintTestMap(map);
+  pathfinder::HPAStar hpa(&map);
+  const auto start = map.TileToWorld(TilePos{2, 2});
+  const auto end = map.TileToWorld(TilePos{57, 57});
+  ASSERT_FALSE(hpa.CalculatePath(start, end).empty());
+  ASSERT_EQ(hpa.GetRebuiltClusterCount(), 36);
+
+  // small lake in the middle of a single cluster
+  map.PaintCircle(TilePos{45, 15}, 3, TileType::WATER);
+  auto path = hpa.CalculatePath(start, end);
+  ASSERT_EQ(hpa.GetRebuiltClusterCount(), 1);
+
+  // lake over a border moves entrances of the neighbours as well
+  map.PaintCircle(TilePos{50, 25}, 3, TileType::WATER);
+  path = hpa.CalculatePath(start, end);
+  ASSERT_GE(hpa.GetRebuiltClusterCount(), 2);
+  ASSERT_LE(hpa.GetRebuiltClusterCount(), 6);
+
+  // same result as building from scratch
+  pathfinder::HPAStar fresh(&map);
+  ASSERT_FLOAT_EQ(PathCost(map, path),
+                  PathCost(map, fresh.CalculatePath(start, end)));
+}
+
+TEST(DStarLite, SameCostAsDijkstra) {
+  // Test that D* Lite finds optimal paths for changing goals
+  for (unsigned seed = 1; seed <= 5; seed++) {
+    Map map(50, 50);
+    if (seed == 1)
+      PaintTestMap(map);
+    else
+      PaintRandomMap(map, seed);
+    pathfinder::Dijkstra dijkstra(&map);
+    pathfinder::DStarLite dstar(&map);
+    for (const auto &[start, end] : test_queries) {
+      auto reference = dijkstra.CalculatePath(map.TileToWorld(start),
+                                              map.TileToWorld(end));
+      auto path =
+          dstar.CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+      ASSERT_EQ(path.empty(), reference.empty());
+      if (path.empty())
+        continue;
+      ASSERT_EQ(map.WorldToTile(path.front()), start);
+      ASSERT_EQ(map.WorldToTile(path.back()), end);
+      ASSERT_TRUE(IsPathContinuous(map, path));
+      ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference));
+    }
+  }
+}
+
+TEST(DStarLite, RepairsAfterMapChanges) {
+  // Test that replanning after small edits stays optimal and only touches
+  // a part of the search tree
+  Map map(60, 60);
+  PaintRandomMap(map, 3);
+  pathfinder::Dijkstra dijkstra(&map);
+  pathfinder::DStarLite dstar(&map);
+  const auto end = map.TileToWorld(TilePos{57, 55});
+  auto path = dstar.CalculatePath(map.TileToWorld(TilePos{2, 3}), end);
+  ASSERT_FALSE(path.empty());
+  const size_t initial_expansions = dstar.GetExpandedNodeCount();
+
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> coord(0, 59);
+  const TileType types[] = {TileType::WALL, TileType::ROAD, TileType::GRASS,
+                            TileType::WATER};
+  for (int i = 0; i < 20; i++) {
+    // walk a few steps along the current path, then edit the map
+    const auto start = path[std::min<size_t>(3, path.size() - 1)];
+    const TilePos a{coord(gen), coord(gen)};
+    map.PaintRectangle(a, a + TilePos{1, 4}, types[i % 4]);
+
+    path = dstar.CalculatePath(start, end);
+    auto reference = dijkstra.CalculatePath(start, end);
+    ASSERT_EQ(path.empty(), reference.empty());
+    if (path.empty())
+      break; // entity is standing at the goal (or got walled in)
+    ASSERT_TRUE(IsPathContinuous(map, path));
+    ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference));
+    ASSERT_LT(dstar.GetExpandedNodeCount(), initial_expansions);
+  }
+}
+
+TEST(PathCache, HitsAndMisses) {
+  // Test that repeated queries are answered from the cache
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::CachedPathFinder cached(&map, pathfinder::PathFinderType::ASTAR);
+  pathfinder::AStar<> astar(&map);
+  ASSERT_EQ(cached.GetName(), astar.GetName());
+
+  for (int round = 0; round < 3; round++) {
+    for (const auto &[start, end] : test_queries) {
+      auto path =
+          cached.CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+      ASSERT_EQ(path, astar.CalculatePath(map.TileToWorld(start),
+                                          map.TileToWorld(end)));
+      if (round > 0) {
+        ASSERT_EQ(cached.GetExpandedNodeCount(), 0);
+      }
+    }
+  }
+  const auto &cache = cached.GetCache();
+  ASSERT_EQ(cache.GetMissCount(), test_queries.size());
+  ASSERT_EQ(cache.GetHitCount(), 2 * test_queries.size());
+  ASSERT_EQ(cache.GetSize(), test_queries.size());
+}
+
+TEST(PathCache, EvictsLeastRecentlyUsed) {
+  // Test that the cache stays within its memory cap and keeps recent paths
+  const pathfinder::Path short_path = {WorldPos{0.0f, 0.0f}};
+  const size_t entry = pathfinder::PathCache::EntryMemoryUsage(short_path);
+  ASSERT_GT(entry, sizeof(WorldPos));
+  pathfinder::PathCache cache(2 * entry);
+  auto key = [](int i) {
+    return pathfinder::PathCache::Key{TilePos{i, 0}, TilePos{0, i},
+                                      pathfinder::PathFinderType::BFS, 0};
+  };
+  cache.Insert(key(1), {WorldPos{1.0f, 1.0f}});
+  cache.Insert(key(2), {WorldPos{2.0f, 2.0f}});
+  ASSERT_NE(cache.Find(key(1)), nullptr); // 1 is now more recent than 2
+  cache.Insert(key(3), {WorldPos{3.0f, 3.0f}});
+  ASSERT_EQ(cache.GetSize(), 2);
+  ASSERT_EQ(cache.GetMemoryUsage(), 2 * entry);
+  ASSERT_EQ(cache.Find(key(2)), nullptr);
+  ASSERT_EQ(cache.Find(key(1))->front(), (WorldPos{1.0f, 1.0f}));
+  ASSERT_EQ(cache.Find(key(3))->front(), (WorldPos{3.0f, 3.0f}));
+
+  // a long path takes the room of several short ones, the newest is kept
+  // even if it alone is over the cap
+  const pathfinder::Path long_path(5, WorldPos{4.0f, 4.0f});
+  cache.Insert(key(4), long_path);
+  ASSERT_EQ(cache.GetSize(), 1);
+  ASSERT_EQ(cache.GetMemoryUsage(),
+            pathfinder::PathCache::EntryMemoryUsage(long_path));
+  ASSERT_NE(cache.Find(key(4)), nullptr);
+
+  // empty paths of unreachable goals take room too
+  cache.SetMemoryCap(10 * entry);
+  for (int i = 0; i < 100; i++)
+    cache.Insert(key(i), {});
+  ASSERT_LE(cache.GetSize(), 10);
+  ASSERT_LE(cache.GetMemoryUsage(), cache.GetMemoryCap());
+  cache.SetMemoryCap(0);
+  ASSERT_EQ(cache.GetSize(), 0);
+  ASSERT_EQ(cache.GetMemoryUsage(), 0);
+
+  // the algorithm is part of the key
+  auto other = key(1);
+  other.type = pathfinder::PathFinderType::DIJKSTRA;
+  ASSERT_EQ(cache.Find(other), nullptr);
+}
+
+TEST(PathCache, WrapsAnyPathFinder) {
+  // Test that a configured pathfinder can be wrapped and shares the cache
+  // with the others under its own type
+  Map map(50, 50);
+  PaintTestMap(map);
+  auto cache = std::make_shared<pathfinder::PathCache>();
+  pathfinder::CachedPathFinder weighted(
+      &map, std::make_unique<pathfinder::WeightedAStar>(&map, 3.0f),
+      pathfinder::PathFinderType::WEIGHTED_ASTAR, cache);
+  pathfinder::CachedPathFinder dijkstra(
+      &map, pathfinder::PathFinderType::DIJKSTRA, cache);
+  pathfinder::WeightedAStar reference(&map, 3.0f);
+  ASSERT_EQ(weighted.GetName(), reference.GetName());
+  for (int round = 0; round < 2; round++) {
+    for (const auto &[start, end] : test_queries) {
+      const auto from = map.TileToWorld(start), to = map.TileToWorld(end);
+      ASSERT_EQ(weighted.CalculatePath(from, to),
+                reference.CalculatePath(from, to));
+      dijkstra.CalculatePath(from, to);
+    }
+  }
+  ASSERT_EQ(cache->GetSize(), 2 * test_queries.size());
+  ASSERT_EQ(cache->GetHitCount(), 2 * test_queries.size());
+  ASSERT_GT(cache->GetMemoryUsage(), 0);
+  ASSERT_LE(cache->GetMemoryUsage(), cache->GetMemoryCap());
+}
+
+TEST(PathCache, InvalidatedByMapChanges) {
+  // Test that painting the map drops the cached paths
+  Map map(50, 50);
+  auto cache = std::make_shared<pathfinder::PathCache>();
+  pathfinder::CachedPathFinder cached(
+      &map, pathfinder::PathFinderType::DIJKSTRA, cache);
+  const auto start = map.TileToWorld(TilePos{5, 5});
+  const auto end = map.TileToWorld(TilePos{5, 40});
+  auto before = cached.CalculatePath(start, end);
+  ASSERT_EQ(cache->GetSize(), 1);
+
+  // wall across the straight path
+  map.PaintLine(TilePos{0, 20}, TilePos{30, 20}, 1.0, TileType::WALL);
+  auto after = cached.CalculatePath(start, end);
+  ASSERT_EQ(cache->GetHitCount(), 0);
+  ASSERT_EQ(cache->GetSize(), 1);
+  ASSERT_GT(after.size(), before.size());
+  ASSERT_EQ(cached.CalculatePath(start, end), after);
+  ASSERT_EQ(cache->GetHitCount(), 1);
+}
+
+TEST(FlowField, SameCostAsDijkstra) {
+  // Test that following the field from anywhere gives optimal paths
+  Map map(50, 50);
+  PaintTestMap(map);
+  const TilePos target{44, 33};
+  pathfinder::FlowField field(&map, target);
+  pathfinder::Dijkstra dijkstra(&map);
+  ASSERT_EQ(field.GetMapVersion(), map.GetVersion());
+  ASSERT_FLOAT_EQ(field.GetCost(target), 0.0f);
+
+  for (const auto &[start, end] : test_queries) {
+    auto reference = dijkstra.CalculatePath(map.TileToWorld(start),
+                                            map.TileToWorld(target));
+    auto path = field.GetPath(map.TileToWorld(start));
+    ASSERT_EQ(map.WorldToTile(path.front()), start);
+    ASSERT_EQ(map.WorldToTile(path.back()), target);
+    ASSERT_TRUE(IsPathContinuous(map, path));
+    ASSERT_FLOAT_EQ(PathCost(map, path), PathCost(map, reference));
+    ASSERT_FLOAT_EQ(field.GetCost(start), PathCost(map, reference));
+
+    // single steps agree with the whole path
+    auto step = field.GetNextStep(map.TileToWorld(start));
+    ASSERT_TRUE(step.has_value());
+    ASSERT_EQ(step.value(), path[1]);
+  }
+  // the target points to itself
+  ASSERT_EQ(field.GetNextStep(map.TileToWorld(target)),
+            map.TileToWorld(target));
+}
+
+TEST(FlowField, InvalidPositions) {
+  // Test that off-map targets and positions give no steps
+  Map map(10, 10);
+  pathfinder::FlowField off_map(&map, TilePos{20, 3});
+  ASSERT_FALSE(off_map.GetNextStep(map.TileToWorld(TilePos{1, 1})));
+  ASSERT_TRUE(off_map.GetPath(map.TileToWorld(TilePos{1, 1})).empty());
+
+  pathfinder::FlowField field(&map, TilePos{5, 5});
+  ASSERT_FALSE(field.GetNextStep(WorldPos{-25.0f, 35.0f}));
+  ASSERT_EQ(field.GetCost(TilePos{30, 3}), pathfinder::FlowField::kUnreachable);
+}
+
+TEST(FlowField, NextTileLeadsDownhill) {
+  // Test that every reachable tile's next tile is a neighbour that is
+  // exactly one move closer to the target
+  Map map(50, 50);
+  PaintTestMap(map);
+  map.SetConnectivity(Connectivity::EIGHT);
+  const TilePos target{10, 30};
+  pathfinder::FlowField field(&map, target);
+  for (size_t idx = 0; idx < map.GetTileCount(); idx++) {
+    const TilePos tile = map.IndexToTile(idx);
+    const auto next = field.GetNextTile(tile);
+    if (!map.IsPassable(tile)) {
+      ASSERT_FALSE(next.has_value());
+      continue;
+    }
+    ASSERT_TRUE(next.has_value());
+    if (tile == target) {
+      ASSERT_EQ(*next, target);
+      continue;
+    }
+    const TilePos diff = *next - tile;
+    const float step = diff.x() != 0 && diff.y() != 0
+                           ? std::numbers::sqrt2_v<float>
+                           : 1.0f;
+    ASSERT_NEAR(field.GetCost(tile),
+                field.GetCost(*next) + step * map.GetCost(*next), 1e-3f);
+  }
+}
+
+TEST(ParallelIntegrator, SameCostAsFlowField) {
+  // Test that the blocked parallel integration gives the costs of the
+  // sequential reverse Dijkstra for any block size and thread count, with
+  // next tiles one move downhill
+  Map map(50, 50);
+  PaintTestMap(map);
+  Map odd(37, 53);
+  PaintRandomMap(odd, 21);
+  for (Map *m : {&map, &odd}) {
+    for (auto connectivity : {Connectivity::FOUR, Connectivity::EIGHT}) {
+      m->SetConnectivity(connectivity);
+      // the second target is a block corner, the last one may be a wall
+      for (TilePos target : {TilePos{10, 30}, TilePos{4, 4}, TilePos{36, 0},
+                             TilePos{25, 25}}) {
+        const pathfinder::FlowField reference(m, target);
+        for (auto [threads, block_size] :
+             {std::pair{1, 2}, std::pair{3, 4}, std::pair{3, 5},
+              std::pair{4, 64}}) {
+          pathfinder::ParallelIntegrator integrator(m, threads, block_size);
+          std::vector<float> costs;
+          std::vector<uint32_t> next;
+          integrator.Integrate(target, costs, next);
+          ASSERT_EQ(costs.size(), m->GetTileCount());
+          ASSERT_GT(integrator.GetRoundCount(), 0);
+          for (size_t idx = 0; idx < m->GetTileCount(); idx++) {
+            const TilePos tile = m->IndexToTile(idx);
+            const float expected = reference.GetCost(tile);
+            if (expected == pathfinder::FlowField::kUnreachable) {
+              ASSERT_EQ(costs[idx], expected);
+              continue;
+            }
+            ASSERT_NEAR(costs[idx], expected, 1e-5f * expected);
+            if (tile == target) {
+              ASSERT_EQ(next[idx], idx);
+              continue;
+            }
+            const TilePos step = m->IndexToTile(next[idx]);
+            const TilePos diff = step - tile;
+            ASSERT_LE(std::max(std::abs(diff.x()), std::abs(diff.y())), 1);
+            const float length = diff.x() != 0 && diff.y() != 0
+                                     ? std::numbers::sqrt2_v<float>
+                                     : 1.0f;
+            ASSERT_NEAR(costs[idx],
+                        costs[next[idx]] + length * m->GetCost(step),
+                        1e-5f * costs[idx]);
+          }
+        }
+
+        const pathfinder::FlowField parallel(m, target, 2);
+        ASSERT_EQ(parallel.GetCost(TilePos{20, 20}),
+                  reference.GetCost(TilePos{20, 20}));
+        ASSERT_GT(parallel.GetExpandedNodeCount(), 0);
+      }
+    }
+  }
+}
+
+TEST(FollowedPath, CursorAndSharing) {
+  // Test that popping points moves the cursor over the remaining points
+  // and that entities on one route share the points
+  pathfinder::FollowedPath empty;
+  ASSERT_TRUE(empty.empty());
+  ASSERT_EQ(empty.size(), 0);
+  ASSERT_EQ(empty.begin(), empty.end());
+  ASSERT_EQ(empty.GetMemoryUsage(), 0);
+
+  pathfinder::Path points = {{0.0f, 0.0f}, {10.0f, 0.0f}, {20.0f, 10.0f}};
+  const WorldPos *data = points.data();
+  pathfinder::FollowedPath path(std::move(points));
+  ASSERT_EQ(path.size(), 3);
+  ASSERT_EQ(path.begin(), data) << "the points should be moved, not copied";
+  path.pop_front();
+  ASSERT_EQ(path.size(), 2);
+  ASSERT_EQ(path.front(), (WorldPos{10.0f, 0.0f}));
+  std::vector<WorldPos> rest(path.begin(), path.end());
+  ASSERT_EQ(rest, (std::vector<WorldPos>{{10.0f, 0.0f}, {20.0f, 10.0f}}));
+
+  // a second entity on the same route has its own cursor
+  pathfinder::FollowedPath other(path.GetShared());
+  ASSERT_EQ(other.size(), 3);
+  ASSERT_EQ(other.GetShared(), path.GetShared());
+  ASSERT_EQ(other.GetMemoryUsage() + path.GetMemoryUsage(),
+            3 * sizeof(WorldPos));
+  path.pop_front();
+  path.pop_front();
+  ASSERT_TRUE(path.empty());
+  ASSERT_EQ(path.begin(), path.end());
+  ASSERT_EQ(other.front(), (WorldPos{0.0f, 0.0f}));
+
+  // moving keeps the cursor
+  other.pop_front();
+  pathfinder::FollowedPath moved = std::move(other);
+  ASSERT_EQ(moved.front(), (WorldPos{10.0f, 0.0f}));
+  moved.clear();
+  ASSERT_TRUE(moved.empty());
+}
+
+TEST(FlowFieldCache, SharedUntilMapChanges) {
+  // Test that repeated targets share one field and that painting the map
+  // drops the cached fields
+  Map map(30, 30);
+  PaintRandomMap(map, 4);
+  pathfinder::FlowFieldCache cache(&map);
+  auto base = cache.Get(TilePos{3, 4});
+  auto mine = cache.Get(TilePos{25, 20});
+  ASSERT_EQ(cache.Get(TilePos{3, 4}), base);
+  ASSERT_EQ(cache.GetSize(), 2);
+  ASSERT_EQ(cache.GetHitCount(), 1);
+  ASSERT_EQ(cache.GetMissCount(), 2);
+  ASSERT_EQ(cache.GetMemoryUsage(),
+            base->GetMemoryUsage() + mine->GetMemoryUsage());
+
+  map.PaintCircle(TilePos{15, 15}, 3, TileType::WATER);
+  auto repainted = cache.Get(TilePos{3, 4});
+  ASSERT_NE(repainted, base);
+  ASSERT_EQ(repainted->GetMapVersion(), map.GetVersion());
+  ASSERT_EQ(cache.GetSize(), 1);
+  // the old field is still valid for whoever holds it
+  ASSERT_EQ(base->GetTarget(), (TilePos{3, 4}));
+
+  // off the map fields are never reachable and not cached
+  auto off_map = cache.Get(TilePos{40, 3});
+  ASSERT_EQ(off_map->GetCost(TilePos{3, 3}),
+            pathfinder::FlowField::kUnreachable);
+  ASSERT_EQ(cache.GetSize(), 1);
+}
+
+TEST(FlowFieldCache, EvictsLeastRecentlyUsedOverCap) {
+  // Test that the cache stays under its memory cap by dropping the least
+  // recently used fields, but always keeps the newest one
+  Map map(20, 20);
+  pathfinder::FlowFieldCache cache(&map);
+  const size_t field_size = cache.Get(TilePos{0, 0})->GetMemoryUsage();
+  cache.SetMemoryCap(3 * field_size);
+  cache.Get(TilePos{1, 1});
+  cache.Get(TilePos{2, 2});
+  cache.Get(TilePos{0, 0}); // most recent again
+  cache.Get(TilePos{3, 3}); // evicts {1, 1}
+  ASSERT_EQ(cache.GetSize(), 3);
+  ASSERT_LE(cache.GetMemoryUsage(), cache.GetMemoryCap());
+
+  const size_t misses = cache.GetMissCount();
+  cache.Get(TilePos{0, 0});
+  cache.Get(TilePos{2, 2});
+  ASSERT_EQ(cache.GetMissCount(), misses);
+  cache.Get(TilePos{1, 1});
+  ASSERT_EQ(cache.GetMissCount(), misses + 1);
+
+  cache.SetMemoryCap(field_size / 2);
+  ASSERT_EQ(cache.GetSize(), 1);
+  ASSERT_EQ(cache.Get(TilePos{1, 1})->GetTarget(), (TilePos{1, 1}));
+  ASSERT_EQ(cache.GetMissCount(), misses + 1);
+  cache.Clear();
+  ASSERT_EQ(cache.GetSize(), 0);
+  ASSERT_EQ(cache.GetMemoryUsage(), 0);
+}
+
+TEST(SearchStats, FilledByEveryPathfinder) {
+  // Test that every pathfinder reports its counters, memory and the cost of
+  // the path after CalculatePath
+  Map map(50, 50);
+  PaintTestMap(map);
+  for (int t = static_cast<int>(pathfinder::PathFinderType::BFS);
+       t < static_cast<int>(pathfinder::PathFinderType::COUNT); t++) {
+    const auto type = static_cast<pathfinder::PathFinderType>(t);
+    auto pf = pathfinder::utils::create(type, &map);
+    ASSERT_NE(pf, nullptr);
+    for (const auto &[start, end] : test_queries) {
+      auto path = pf->CalculatePath(map.TileToWorld(start),
+                                    map.TileToWorld(end));
+      ASSERT_FALSE(path.empty()) << pf->GetName();
+      const pathfinder::SearchStats &stats = pf->GetLastStats();
+      ASSERT_EQ(stats.expanded_nodes, pf->GetExpandedNodeCount());
+      ASSERT_GT(stats.expanded_nodes, 0) << pf->GetName();
+      ASSERT_GE(stats.pushed_nodes, stats.peak_frontier) << pf->GetName();
+      ASSERT_GT(stats.peak_frontier, 0) << pf->GetName();
+      ASSERT_GT(stats.memory_bytes, 0) << pf->GetName();
+      ASSERT_GE(stats.time_ms, 0.0);
+      if (type == pathfinder::PathFinderType::THETA_STAR) {
+        // any-angle segments are priced by their length
+        ASSERT_GT(stats.path_cost, 0.0f);
+      } else {
+        ASSERT_NEAR(stats.path_cost, PathCost(map, path), 1e-3f)
+            << pf->GetName();
+      }
+    }
+    // the counters start over with every query
+    pf->CalculatePath(map.TileToWorld(TilePos{5, 5}),
+                      map.TileToWorld(TilePos{5, 5}));
+    ASSERT_EQ(pf->GetLastStats().path_cost, 0.0f) << pf->GetName();
+    ASSERT_LT(pf->GetLastStats().expanded_nodes, 2) << pf->GetName();
+  }
+}
+
+TEST(SearchStats, AggregatedPerType) {
+  // Test that the request service sums the statistics of its queries per
+  // pathfinder type and skips hierarchical waypoint queries
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::PathRequestService service(&map, 2);
+  const std::vector<pathfinder::PathFinderType> types = {
+      pathfinder::PathFinderType::DIJKSTRA, pathfinder::PathFinderType::ASTAR,
+      pathfinder::PathFinderType::HPA, pathfinder::PathFinderType::FOCAL_ASTAR};
+  std::map<pathfinder::RequestId, pathfinder::PathFinderType> submitted;
+  for (auto type : types) {
+    for (const auto &[start, end] : test_queries) {
+      auto id =
+          service.Submit(map.TileToWorld(start), map.TileToWorld(end), type);
+      submitted.emplace(id, type);
+    }
+  }
+  // a goal inside the wall can't be reached
+  auto id = service.Submit(map.TileToWorld(TilePos{1, 1}),
+                           map.TileToWorld(TilePos{40, 30}),
+                           pathfinder::PathFinderType::ASTAR);
+  submitted.emplace(id, pathfinder::PathFinderType::ASTAR);
+  service.Wait();
+
+  std::map<pathfinder::PathFinderType, pathfinder::AggregatedStats> expected;
+  auto results = service.TakeResults();
+  for (const auto &result : results) {
+    if (!result.waypoints.empty()) {
+      ASSERT_EQ(result.stats.expanded_nodes, 0);
+      continue;
+    }
+    expected[submitted.at(result.id)].Add(result.stats);
+  }
+
+  auto &table = service.GetStats();
+  for (const auto &[type, stats] : expected) {
+    auto aggregated = table.Get(type);
+    ASSERT_EQ(aggregated.queries, stats.queries);
+    ASSERT_EQ(aggregated.found, stats.found);
+    ASSERT_EQ(aggregated.total.expanded_nodes, stats.total.expanded_nodes);
+    ASSERT_EQ(aggregated.total.pushed_nodes, stats.total.pushed_nodes);
+    ASSERT_EQ(aggregated.peak.peak_frontier, stats.peak.peak_frontier);
+    ASSERT_FLOAT_EQ(aggregated.total.path_cost, stats.total.path_cost);
+    ASSERT_FLOAT_EQ(aggregated.total.suboptimality, stats.total.suboptimality);
+  }
+  auto astar = table.Get(pathfinder::PathFinderType::ASTAR);
+  ASSERT_EQ(astar.name, "A*");
+  ASSERT_EQ(astar.queries, test_queries.size() + 1);
+  ASSERT_EQ(astar.found, test_queries.size());
+  ASSERT_NEAR(astar.Mean().path_cost,
+              astar.total.path_cost / test_queries.size(), 1e-3f);
+  // only the bounded searches prove a bound other than 1
+  ASSERT_EQ(astar.peak.suboptimality, 1.0f);
+  ASSERT_FLOAT_EQ(astar.Mean().suboptimality, 1.0f);
+  auto focal = table.Get(pathfinder::PathFinderType::FOCAL_ASTAR);
+  ASSERT_GE(focal.Mean().suboptimality, 1.0f);
+  ASSERT_LE(focal.peak.suboptimality,
+            pathfinder::BoundedAStarBase::kDefaultWeight + 1e-4f);
+  // long HPA* queries only return waypoints
+  ASSERT_LT(table.Get(pathfinder::PathFinderType::HPA).queries,
+            test_queries.size());
+
+  table.Clear();
+  ASSERT_EQ(table.Get(pathfinder::PathFinderType::ASTAR).queries, 0);
+}
+
+TEST(RequestService, ResultsMatchSynchronous) {
+  // Test that requests run on the workers give the same paths as the
+  // pathfinders called directly
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::PathRequestService service(&map, 3);
+  ASSERT_EQ(service.GetThreadCount(), 3);
+
+  const std::vector<pathfinder::PathFinderType> types = {
+      pathfinder::PathFinderType::DIJKSTRA, pathfinder::PathFinderType::ASTAR,
+      pathfinder::PathFinderType::JPS, pathfinder::PathFinderType::HPA};
+  std::map<pathfinder::RequestId, std::pair<size_t, size_t>> submitted;
+  for (size_t t = 0; t < types.size(); t++) {
+    for (size_t q = 0; q < test_queries.size(); q++) {
+      const auto &[start, end] = test_queries[q];
+      auto id = service.Submit(map.TileToWorld(start), map.TileToWorld(end),
+                               types[t]);
+      ASSERT_TRUE(submitted.emplace(id, std::make_pair(t, q)).second);
+    }
+  }
+  service.Wait();
+  ASSERT_EQ(service.GetPendingCount(), 0);
+
+  auto results = service.TakeResults();
+  ASSERT_EQ(results.size(), submitted.size());
+  ASSERT_TRUE(service.TakeResults().empty());
+  std::set<pathfinder::RequestId> seen;
+  for (auto &result : results) {
+    ASSERT_TRUE(seen.insert(result.id).second);
+    auto [t, q] = submitted.at(result.id);
+    const auto &[start, end] = test_queries[q];
+    auto reference = pathfinder::utils::create(types[t], &map);
+    auto path = reference->CalculatePath(map.TileToWorld(start),
+                                         map.TileToWorld(end));
+    auto waypoints = reference->CalculateAbstractPath(map.TileToWorld(start),
+                                                      map.TileToWorld(end));
+    // hierarchical pathfinders only return the waypoints, entities refine
+    // them as they go
+    ASSERT_EQ(result.waypoints, waypoints);
+    if (waypoints.empty()) {
+      ASSERT_FLOAT_EQ(PathCost(map, result.path), PathCost(map, path));
+    } else {
+      ASSERT_TRUE(result.path.empty());
+    }
+  }
+}
+
+TEST(RequestService, SolveBatchMatchesSequential) {
+  // Test that a batch solved by several workers gives exactly the paths of
+  // one pathfinder of each type running the requests in order
+  Map map(80, 80);
+  PaintRandomMap(map, 11);
+  pathfinder::PathRequestService service(&map, 3);
+
+  const std::vector<pathfinder::PathFinderType> types = {
+      pathfinder::PathFinderType::DIJKSTRA,
+      pathfinder::PathFinderType::ASTAR,
+      pathfinder::PathFinderType::JPS,
+      pathfinder::PathFinderType::HPA,
+      pathfinder::PathFinderType::DSTAR_LITE,
+      pathfinder::PathFinderType::BIDIRECTIONAL_ASTAR,
+      pathfinder::PathFinderType::THETA_STAR,
+      pathfinder::PathFinderType::ALT,
+      pathfinder::PathFinderType::WEIGHTED_ASTAR};
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<int> coord(0, 79);
+  std::vector<pathfinder::PathRequest> requests;
+  for (pathfinder::RequestId id = 100; requests.size() < 200; id++) {
+    requests.push_back({id, map.TileToWorld(TilePos{coord(gen), coord(gen)}),
+                        map.TileToWorld(TilePos{coord(gen), coord(gen)}),
+                        types[id % types.size()]});
+  }
+  // an async request is served once the batch is done
+  auto async_id = service.Submit(requests[0].start, requests[0].goal,
+                                 pathfinder::PathFinderType::HPA);
+
+  auto results = service.SolveBatch(requests);
+  ASSERT_EQ(results.size(), requests.size());
+  std::map<pathfinder::PathFinderType,
+           std::unique_ptr<pathfinder::PathFinderBase>>
+      reference;
+  for (size_t i = 0; i < requests.size(); i++) {
+    const auto &request = requests[i];
+    auto &pf = reference[request.type];
+    if (!pf)
+      pf = pathfinder::utils::create(request.type, &map);
+    ASSERT_EQ(results[i].id, request.id);
+    ASSERT_TRUE(results[i].waypoints.empty());
+    ASSERT_EQ(results[i].path, pf->CalculatePath(request.start, request.goal))
+        << pf->GetName() << ", request " << request.id;
+    ASSERT_EQ(results[i].stats.path_cost, pf->GetLastStats().path_cost);
+  }
+  const auto dijkstra_count =
+      std::ranges::count(requests, types[0], &pathfinder::PathRequest::type);
+  ASSERT_EQ(service.GetStats().Get(types[0]).queries, dijkstra_count);
+
+  service.Wait();
+  auto async_results = service.TakeResults();
+  ASSERT_EQ(async_results.size(), 1);
+  ASSERT_EQ(async_results[0].id, async_id);
+  ASSERT_TRUE(service.SolveBatch({}).empty());
+}
+
+TEST(RequestService, DestroyWithPendingRequests) {
+  // Test that the service can be destroyed while requests are queued
+  Map map(100, 100);
+  PaintRandomMap(map, 5);
+  auto service = std::make_unique<pathfinder::PathRequestService>(&map, 2);
+  pathfinder::RequestId last = 0;
+  for (int i = 0; i < 200; i++) {
+    auto id = service->Submit(map.TileToWorld(TilePos{1, 1}),
+                              map.TileToWorld(TilePos{98, 97}),
+                              pathfinder::PathFinderType::DIJKSTRA);
+    ASSERT_GT(id, last);
+    last = id;
+  }
+  service.reset();
+}
+
+TEST(TimeSliced, SameAsCalculatePath) {
+  // Test that a search split into small steps expands the same nodes and
+  // finds the same path as one CalculatePath call, never over the budget
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::Dijkstra reference_dijkstra(&map), dijkstra(&map);
+  pathfinder::AStar<> reference_astar(&map), astar(&map);
+  const std::vector<std::pair<pathfinder::PathFinderBase *,
+                              pathfinder::PathFinderBase *>>
+      pairs = {{&reference_dijkstra, &dijkstra}, {&reference_astar, &astar}};
+  for (auto [reference, sliced] : pairs) {
+    for (const auto &[start, end] : test_queries) {
+      auto path = reference->CalculatePath(map.TileToWorld(start),
+                                           map.TileToWorld(end));
+      sliced->Begin(map.TileToWorld(start), map.TileToWorld(end));
+      pathfinder::SearchStatus status;
+      size_t steps = 0;
+      do {
+        const size_t before = sliced->GetExpandedNodeCount();
+        status = sliced->Step(37);
+        ASSERT_LE(sliced->GetExpandedNodeCount() - before, 37);
+        steps++;
+      } while (status == pathfinder::SearchStatus::IN_PROGRESS);
+      ASSERT_EQ(status, pathfinder::SearchStatus::FOUND);
+      ASSERT_GT(steps, 1);
+      ASSERT_EQ(sliced->GetExpandedNodeCount(),
+                reference->GetExpandedNodeCount());
+      ASSERT_EQ(sliced->TakePath(), path);
+    }
+  }
+
+  // pathfinders without time slicing finish in the first step
+  for (auto [reference, sliced] : pairs)
+    ASSERT_TRUE(sliced->IsTimeSliced());
+  pathfinder::JPS jps(&map);
+  ASSERT_FALSE(jps.IsTimeSliced());
+  jps.Begin(map.TileToWorld(TilePos{1, 1}), map.TileToWorld(TilePos{48, 48}));
+  ASSERT_EQ(jps.Step(1), pathfinder::SearchStatus::FOUND);
+  ASSERT_FALSE(jps.TakePath().empty());
+  // walled off or invalid goals are never in progress
+  map.PaintRectangle(TilePos{45, 0}, TilePos{46, 50}, TileType::WALL);
+  astar.Begin(map.TileToWorld(TilePos{1, 1}), map.TileToWorld(TilePos{48, 48}));
+  ASSERT_EQ(astar.Step(1), pathfinder::SearchStatus::NOT_FOUND);
+  ASSERT_TRUE(astar.TakePath().empty());
+  dijkstra.Begin(map.TileToWorld(TilePos{1, 1}),
+                 map.TileToWorld(TilePos{80, 1}));
+  ASSERT_EQ(dijkstra.Step(1), pathfinder::SearchStatus::NOT_FOUND);
+}
+
+TEST(SlicedScheduler, KeepsToBudget) {
+  // Test that the scheduler never expands more nodes per update than the
+  // budget and still answers every request like the pathfinders do
+  Map map(50, 50);
+  PaintTestMap(map);
+  pathfinder::SlicedPathScheduler scheduler(&map, 4);
+  const std::vector<pathfinder::PathFinderType> types = {
+      pathfinder::PathFinderType::DIJKSTRA, pathfinder::PathFinderType::ASTAR};
+  std::map<pathfinder::RequestId, std::pair<size_t, size_t>> submitted;
+  for (size_t t = 0; t < types.size(); t++) {
+    for (size_t q = 0; q < test_queries.size(); q++) {
+      const auto &[start, end] = test_queries[q];
+      auto id = scheduler.Submit(map.TileToWorld(start), map.TileToWorld(end),
+                                 types[t]);
+      submitted.emplace(id, std::make_pair(t, q));
+    }
+  }
+  ASSERT_EQ(scheduler.GetPendingCount(), submitted.size());
+
+  std::vector<pathfinder::PathResult> results;
+  size_t updates = 0;
+  while (scheduler.GetPendingCount() > 0) {
+    ASSERT_LE(scheduler.Update(300), 300);
+    ASSERT_LE(scheduler.GetRunningCount(), 4);
+    for (auto &result : scheduler.TakeResults())
+      results.push_back(std::move(result));
+    ASSERT_LT(++updates, 10000);
+  }
+  ASSERT_GT(updates, submitted.size());
+  ASSERT_EQ(results.size(), submitted.size());
+  for (const auto &result : results) {
+    auto [t, q] = submitted.at(result.id);
+    const auto &[start, end] = test_queries[q];
+    auto reference = pathfinder::utils::create(types[t], &map);
+    auto path = reference->CalculatePath(map.TileToWorld(start),
+                                         map.TileToWorld(end));
+    ASSERT_FLOAT_EQ(PathCost(map, result.path), PathCost(map, path));
+  }
+}
+
+TEST(SlicedScheduler, MapChangesAndCancel) {
+  // Test that searches restart when the map is painted under them and that
+  // cancelled requests never report a result
+  Map map(50, 50);
+  pathfinder::SlicedPathScheduler scheduler(&map);
+  const TilePos start{1, 1}, end{48, 48};
+  auto id = scheduler.Submit(map.TileToWorld(start), map.TileToWorld(end),
+                             pathfinder::PathFinderType::ASTAR);
+  auto cancelled =
+      scheduler.Submit(map.TileToWorld(start), map.TileToWorld(end),
+                       pathfinder::PathFinderType::DIJKSTRA);
+  scheduler.Update(50);
+  ASSERT_TRUE(scheduler.TakeResults().empty());
+  scheduler.Cancel(cancelled);
+  ASSERT_EQ(scheduler.GetPendingCount(), 1);
+
+  // a wall with a single gap far from the straight line
+  map.PaintRectangle(TilePos{25, 0}, TilePos{26, 50}, TileType::WALL);
+  map.PaintRectangle(TilePos{25, 2}, TilePos{26, 3}, TileType::GRASS);
+  while (scheduler.GetPendingCount() > 0)
+    scheduler.Update(50);
+  auto results = scheduler.TakeResults();
+  ASSERT_EQ(results.size(), 1);
+  ASSERT_EQ(results[0].id, id);
+  ASSERT_TRUE(IsPathContinuous(map, results[0].path));
+
+  pathfinder::Dijkstra dijkstra(&map);
+  auto reference =
+      dijkstra.CalculatePath(map.TileToWorld(start), map.TileToWorld(end));
+  ASSERT_FLOAT_EQ(PathCost(map, results[0].path), PathCost(map, reference));
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "map.hpp"
+#include "movingai.hpp"
+#include "pathfinder/base.hpp"
+#include "pathfinder/search_stats.hpp"
+#include "pathfinder/utils.hpp"
+
+/**
+ * @file pathfinding_benchmarks.cpp
+ * @brief Runs every pathfinder over a MovingAI map and scenario
+ *
+ * Usage: pathfinding_benchmarks <file.map> <file.scen> [buckets per row]
+ *
+ * The scenario buckets are reported in groups, every row shows the
+ * throughput, the expansions and the path cost divided by the optimal cost
+ * listed in the scenario. A sample map and scenario are in
+ * cpp/resources/benchmarks, the maps of the MovingAI repository
+ * (https://movingai.com/benchmarks/grids.html) load the same way.
+ */
+
+namespace {
+
+/**
+ * @brief Results of the queries of one group of buckets
+ */
+struct BucketResult {
+    pathfinder::AggregatedStats stats;
+    double suboptimality = 0.0; // sum over the found paths
+    double worst = 0.0;
+};
+
+void PrintHeader() {
+    std::cout << std::left << std::setw(14) << "  buckets" << std::right
+              << std::setw(10) << "queries" << std::setw(12) << "queries/s"
+              << std::setw(14) << "expanded/q" << std::setw(12) << "cost/opt"
+              << std::setw(10) << "worst" << std::setw(10) << "failed" << std::endl;
+}
+
+void PrintRow(const std::string &label, const BucketResult &r) {
+    const auto &stats = r.stats;
+    const double seconds = stats.total.time_ms / 1000.0;
+    const double found = static_cast<double>(std::max<size_t>(stats.found, 1));
+    std::cout << std::left << std::setw(14) << "  " + label << std::right << std::fixed
+              << std::setw(10) << stats.queries << std::setprecision(0) << std::setw(12)
+              << (seconds > 0.0 ? static_cast<double>(stats.queries) / seconds : 0.0)
+              << std::setw(14) << stats.Mean().expanded_nodes << std::setprecision(4)
+              << std::setw(12) << r.suboptimality / found << std::setw(10) << r.worst
+              << std::setw(10) << stats.queries - stats.found << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <file.map> <file.scen> [buckets per row]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const unsigned group = argc > 3 ? std::max(std::atoi(argv[3]), 1) : 10;
+
+    auto map = movingai::LoadMap(argv[1]);
+    if (!map) {
+        std::cerr << map.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto scenarios = movingai::LoadScenarios(argv[2], **map);
+    if (!scenarios) {
+        std::cerr << scenarios.error() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "[BENCHMARK] " << argv[1] << ": " << (*map)->GetCols() << "x"
+              << (*map)->GetRows() << " tiles, " << scenarios->size() << " queries\n"
+              << std::endl;
+
+    bool all_found = true;
+    for (int t = static_cast<int>(pathfinder::PathFinderType::BFS);
+         t < static_cast<int>(pathfinder::PathFinderType::COUNT); t++) {
+        const auto type = static_cast<pathfinder::PathFinderType>(t);
+        auto pf = pathfinder::utils::create(type, map->get());
+        if (!pf) {
+            continue;
+        }
+
+        std::map<unsigned, BucketResult> rows;
+        BucketResult all;
+        for (const auto &scenario : *scenarios) {
+            pf->CalculatePath((*map)->TileToWorld(scenario.start),
+                              (*map)->TileToWorld(scenario.goal));
+            const pathfinder::SearchStats &stats = pf->GetLastStats();
+            for (BucketResult *r : {&rows[scenario.bucket / group], &all}) {
+                r->stats.Add(stats);
+                if (stats.path_cost > 0.0f && scenario.optimal_cost > 0.0) {
+                    const double ratio = stats.path_cost / scenario.optimal_cost;
+                    r->suboptimality += ratio;
+                    r->worst = std::max(r->worst, ratio);
+                }
+            }
+        }
+        all_found &= all.stats.found == all.stats.queries;
+
+        std::cout << "[BENCHMARK] " << pf->GetName() << std::endl;
+        PrintHeader();
+        for (const auto &[row, result] : rows) {
+            PrintRow(std::to_string(row * group) + "-" + std::to_string((row + 1) * group - 1),
+                     result);
+        }
+        PrintRow("all", all);
+        std::cout << std::endl;
+    }
+    // every query of a scenario has a path
+    return all_found ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -5,6 +5,7 @@
 # Imports
 #
 
+import math
 import matplotlib.pyplot as plt
 import numpy as np
 import time
@@ -22,20 +23,29 @@ Point2D = NewType("Point2D", tuple[int, int])
 # type Point2D = tuple[int, int] # tuple(x, y)
 type Path = list[Point2D]
 
+WALL_COST = 1000
+
 class Map:
     """
     2D map consisting of cells with given cost
+
+    Connectivity is 4 (moves to the sides only) or 8 (diagonals too),
+    same as in the C++ demo: a diagonal move costs sqrt(2) times the cost
+    of the entered cell and can't cut the corner of a wall.
     """
     # array not defined as private, as plotting utilities work with it directly
     array: np.ndarray
+    connectivity: int
     _visited_nodes: int
 
-    def __init__(self, width: int, height: int) -> None:
+    def __init__(self, width: int, height: int, connectivity: int = 4) -> None:
         assert width > 0
         assert height > 0
+        assert connectivity in (4, 8)
         rows = height
         cols = width
         self.array = np.zeros((rows, cols), dtype=np.float64)
+        self.connectivity = connectivity
         self._visited_nodes = 0
 
     def Randomize(self, low: float = 0.0, high: float = 1.0) -> None:
@@ -56,21 +66,51 @@ class Map:
         x_center, y_center = center_point
         for x in range(-1,2):
             for y in range(-1,2):
-                diagonal = x == y # includes center 0,0
-                if diagonal:
+                if x == 0 and y == 0:
+                    continue
+                diagonal = x != 0 and y != 0
+                if diagonal and self.connectivity == 4:
                     continue
                 p = Point2D((x + x_center, y + y_center))
-                if self.IsPointValid(p):
-                    points.append(p)
+                if not self.IsPointValid(p):
+                    continue
+                if diagonal and (self.IsWall(Point2D((x_center + x, y_center))) or
+                                 self.IsWall(Point2D((x_center, y_center + y)))):
+                    # no cutting past the corner of a wall
+                    continue
+                points.append(p)
         return points
-    
+
+    def IsWall(self, point: Point2D) -> bool:
+        return self.GetPointCost(point) >= WALL_COST
+
     def GetPointCost(self, point: Point2D) -> float:
         x, y = point
         row, col = y, x
         return self.array[(row, col)]
-    
+
+    @staticmethod
+    def GetStepLength(a: Point2D, b: Point2D) -> float:
+        """
+        1 for moves to the side, sqrt(2) for diagonal moves
+        """
+        return math.sqrt(2) if a[0] != b[0] and a[1] != b[1] else 1.0
+
+    def GetDistance(self, a: Point2D, b: Point2D) -> float:
+        """
+        Fewest steps between two points: Manhattan distance on 4-connected
+        maps, octile distance on 8-connected ones
+        """
+        dx = abs(a[0] - b[0])
+        dy = abs(a[1] - b[1])
+        if self.connectivity == 4:
+            return dx + dy
+        return max(dx, dy) + (math.sqrt(2) - 1) * min(dx, dy)
+
     def GetPathCost(self, path: Path) -> float:
-        return sum([self.GetPointCost(p) for p in path])
+        # entered cells only, like the C++ demo
+        return sum([self.GetStepLength(a, b) * self.GetPointCost(b)
+                    for a, b in zip(path, path[1:])])
 
     def ResetVisitedCount(self) -> None:
         self._visited_nodes = 0
@@ -78,14 +118,16 @@ class Map:
     def GetVisitedCount(self) -> int:
         return self._visited_nodes
 
-    def Visit(self, point: Point2D) -> float:
+    def Visit(self, point: Point2D, from_point: Optional[Point2D] = None) -> float:
         """
-        Visit the node and return its cost
+        Visit the node and return its cost, or the cost of the move
+        from from_point if given
         """
         if not self.IsPointValid(point):
             raise ValueError("Point out of bounds")
         self._visited_nodes += 1
-        return self.GetPointCost(point)
+        step = 1.0 if from_point is None else self.GetStepLength(from_point, point)
+        return step * self.GetPointCost(point)
 
     def CreateMaze(self, wall_probability: float = 0.3) -> None:
         """
@@ -278,7 +320,7 @@ class DijkstraAlgorithm(PathFinderBase):
                 # early exit - remove if you want to build the whole flow map
                 break
             for next_point in self._map.GetNeighbours(current):
-                new_cost = cost_so_far[current] + self._map.Visit(next_point)
+                new_cost = cost_so_far[current] + self._map.Visit(next_point, current)
                 if next_point not in cost_so_far or new_cost < cost_so_far[next_point]:
                     cost_so_far[next_point] = new_cost
                     priority = new_cost
@@ -343,12 +385,6 @@ class A_star(PathFinderBase):
 
     name = "A*"
 
-    @staticmethod
-    def heuristic(a: Point2D, b: Point2D) -> float:
-        x_a, y_a = a
-        x_b, y_b = b
-        return abs(x_a - x_b) + abs(y_a - y_b)
-
     def _CalculatePath(self, start_point: Point2D, end_point: Point2D) -> Optional[Path]:
         frontier: PriorityQueue[PrioritizedItem] = PriorityQueue()
         came_from: dict[Point2D, Optional[Point2D]] = { start_point: None }
@@ -361,10 +397,10 @@ class A_star(PathFinderBase):
                 # early exit
                 break
             for next_point in self._map.GetNeighbours(current):
-                new_cost = cost_so_far[current] + self._map.Visit(next_point)
+                new_cost = cost_so_far[current] + self._map.Visit(next_point, current)
                 if next_point not in cost_so_far or new_cost < cost_so_far[next_point]:
                     cost_so_far[next_point] = new_cost
-                    priority = new_cost + self.heuristic(end_point, next_point)
+                    priority = new_cost + self._map.GetDistance(end_point, next_point)
                     frontier.put(PrioritizedItem(next_point, priority))
                     came_from[next_point] = current
         # create the actual path